@@ -25,7 +25,6 @@
 
 extern const char gFwVer[FWVER_MAX_LEN];
 
-#define BP_RESPONSE_BUF_LEN   512
 /* 
    A gadget identifier, is a unique ID that you put into the firmware of a                                                                                                                            .
    gadget. It is also known as the device serial number (DSN) and endpointId,
@@ -42,15 +41,30 @@ extern unsigned char gDeviceToken[65];
 // in alexa/rx.c
 extern int32_t gBPM;
 extern bool gSendSensorData;
+extern uint32_t gRxExpiredTransactions;   // stalled transactions dropped
+extern uint32_t gRxReclaimedBytes;        // transaction bytes released by expiry
 
+void AlexaRxInit(void);                  // at boot, checks the directive routes
 int AlexaRxPacket(uint8_t *pData,uint8_t Len);
+void AlexaRxExpireTransactions(bool bAll);
+void AlexaRxPrintDirectiveStats(void);   // per-directive calls and cycles
 
 // in alexa/tx.c
-void AlexTxPacket(uint8_t *pData,uint8_t Len);
+extern uint32_t gTxRetries;               // notifications deferred for lack of stack buffers
+extern uint32_t gTxRejected;              // transactions not queued, TX ring full
+extern uint32_t gTxDroppedFrames;         // queued frames discarded undelivered
+
+int AlexaTxPump(void);
+size_t AlexaTxQueueDepth(void);
+void AlexaTxFlush(void);
 void SetAlexAdvertisingData(bool bPairingMode);
-void SendAlexaProtocolVerPkt(void);
+void SendAlexaProtocolVerPkt(void);  // held until the MTU exchange
+void AlexaProtocolVerTimeout(void);  // from PROTOCOL_VERSION_TIMER_HANDLE
 uint8_t CreateAlexaAdvertisingData(bool bPairingMode,uint8_t **pAdvData);
 void SendSensorData(int32_t F,uint32_t rhData);
+void AlexaSetAttMtu(uint16_t Mtu);     // from gecko_evt_gatt_mtu_exchanged
+void AlexaResetAttMtu(void);           // new or closed connection
+void AlexaRefreshResponseCache(void);  // after the gadget identity is set or changes
 
 
 // in app.c
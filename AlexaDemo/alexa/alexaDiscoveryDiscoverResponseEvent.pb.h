@@ -63,8 +63,8 @@ extern const pb_msgdesc_t alexaDiscovery_DiscoverResponseEventProto_Event_msg;
 #define alexaDiscovery_DiscoverResponseEventProto_Event_fields &alexaDiscovery_DiscoverResponseEventProto_Event_msg
 
 /* Maximum encoded size of messages (where known) */
-#define alexaDiscovery_DiscoverResponseEventProto_size 1842
-#define alexaDiscovery_DiscoverResponseEventProto_Event_size 1839
+/* alexaDiscovery_DiscoverResponseEventProto_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventProto_Event_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -15,16 +15,16 @@ extern "C" {
 
 /* Struct definitions */
 typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification {
-    char firmwareVersion[32];
-    char deviceToken[65];
-    char deviceTokenEncryptionType[32];
-    char amazonDeviceType[32];
-    char modelName[32];
-    char radioAddress[32];
+    pb_view_t firmwareVersion;
+    pb_view_t deviceToken;
+    pb_view_t deviceTokenEncryptionType;
+    pb_view_t amazonDeviceType;
+    pb_view_t modelName;
+    pb_view_t radioAddress;
 } alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification;
 
 typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes {
-    char name[32];
+    pb_view_t name;
 } alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes;
 
 typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration {
@@ -33,18 +33,18 @@ typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capab
 } alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration;
 
 typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities {
-    char type[32];
-    char interface[32];
-    char version[32];
+    pb_view_t type;
+    pb_view_t interface;
+    pb_view_t version;
     bool has_configuration;
     alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration configuration;
 } alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities;
 
 typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints {
-    char endpointId[32];
-    char friendlyName[32];
-    char description[32];
-    char manufacturerName[32];
+    pb_view_t endpointId;
+    pb_view_t friendlyName;
+    pb_view_t description;
+    pb_view_t manufacturerName;
     pb_size_t capabilities_count;
     alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities capabilities[4];
     bool has_additionalIdentification;
@@ -59,17 +59,17 @@ typedef struct _alexaDiscovery_DiscoverResponseEventPayloadProto {
 
 /* Initializer values for message structs */
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_init_default {0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_default}}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_default {"", "", "", "", 0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_default}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default {"", "", "", false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_default}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_default {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, 0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_default}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_default {{NULL, 0}, {NULL, 0}, {NULL, 0}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_default}
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_default {0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default}}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default {""}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_default {"", "", "", "", "", ""}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_default {{NULL, 0}}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_default {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}}
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_init_zero {0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_zero}}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_zero {"", "", "", "", 0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_zero}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero {"", "", "", false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_zero}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_init_zero {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, 0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_zero}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_init_zero {{NULL, 0}, {NULL, 0}, {NULL, 0}, false, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_zero}
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_init_zero {0, {alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero, alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero}}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero {""}
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_zero {"", "", "", "", "", ""}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_init_zero {{NULL, 0}}
+#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_init_zero {{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_modelName_tag 5
@@ -100,10 +100,10 @@ X(a, STATIC,   REPEATED, MESSAGE,  endpoints,         1)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_endpoints_MSGTYPE alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints
 
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   endpointId,        1) \
-X(a, STATIC,   SINGULAR, STRING,   friendlyName,      2) \
-X(a, STATIC,   SINGULAR, STRING,   description,       3) \
-X(a, STATIC,   SINGULAR, STRING,   manufacturerName,   4) \
+X(a, STATIC,   SINGULAR, VIEW,     endpointId,        1) \
+X(a, STATIC,   SINGULAR, VIEW,     friendlyName,      2) \
+X(a, STATIC,   SINGULAR, VIEW,     description,       3) \
+X(a, STATIC,   SINGULAR, VIEW,     manufacturerName,   4) \
 X(a, STATIC,   REPEATED, MESSAGE,  capabilities,     11) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  additionalIdentification,  12)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_CALLBACK NULL
@@ -112,9 +112,9 @@ X(a, STATIC,   OPTIONAL, MESSAGE,  additionalIdentification,  12)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_additionalIdentification_MSGTYPE alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification
 
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   type,              1) \
-X(a, STATIC,   SINGULAR, STRING,   interface,         2) \
-X(a, STATIC,   SINGULAR, STRING,   version,           3) \
+X(a, STATIC,   SINGULAR, VIEW,     type,              1) \
+X(a, STATIC,   SINGULAR, VIEW,     interface,         2) \
+X(a, STATIC,   SINGULAR, VIEW,     version,           3) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  configuration,     4)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_CALLBACK NULL
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_DEFAULT NULL
@@ -127,17 +127,17 @@ X(a, STATIC,   REPEATED, MESSAGE,  supportedTypes,    1)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_supportedTypes_MSGTYPE alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes
 
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   name,              1)
+X(a, STATIC,   SINGULAR, VIEW,     name,              1)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_CALLBACK NULL
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_DEFAULT NULL
 
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   firmwareVersion,   1) \
-X(a, STATIC,   SINGULAR, STRING,   deviceToken,       2) \
-X(a, STATIC,   SINGULAR, STRING,   deviceTokenEncryptionType,   3) \
-X(a, STATIC,   SINGULAR, STRING,   amazonDeviceType,   4) \
-X(a, STATIC,   SINGULAR, STRING,   modelName,         5) \
-X(a, STATIC,   SINGULAR, STRING,   radioAddress,      6)
+X(a, STATIC,   SINGULAR, VIEW,     firmwareVersion,   1) \
+X(a, STATIC,   SINGULAR, VIEW,     deviceToken,       2) \
+X(a, STATIC,   SINGULAR, VIEW,     deviceTokenEncryptionType,   3) \
+X(a, STATIC,   SINGULAR, VIEW,     amazonDeviceType,   4) \
+X(a, STATIC,   SINGULAR, VIEW,     modelName,         5) \
+X(a, STATIC,   SINGULAR, VIEW,     radioAddress,      6)
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_CALLBACK NULL
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_DEFAULT NULL
 
@@ -157,12 +157,12 @@ extern const pb_msgdesc_t alexaDiscovery_DiscoverResponseEventPayloadProto_Endpo
 #define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_fields &alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_msg
 
 /* Maximum encoded size of messages (where known) */
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_size 1735
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_size 1731
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_size 452
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_size 350
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_size 33
-#define alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_size 231
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes_size depends on runtime parameters */
+/* alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -22,14 +22,14 @@ typedef struct _alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData {
 typedef struct _alexaGadgetMusicData_TempoDirectivePayloadProto {
     int32_t playerOffsetInMilliSeconds;
     pb_size_t tempoData_count;
-    alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData tempoData[1];
+    struct _alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData *tempoData;
 } alexaGadgetMusicData_TempoDirectivePayloadProto;
 
 
 /* Initializer values for message structs */
-#define alexaGadgetMusicData_TempoDirectivePayloadProto_init_default {0, 0, {alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_init_default}}
+#define alexaGadgetMusicData_TempoDirectivePayloadProto_init_default {0, 0, NULL}
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_init_default {0, 0}
-#define alexaGadgetMusicData_TempoDirectivePayloadProto_init_zero {0, 0, {alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_init_zero}}
+#define alexaGadgetMusicData_TempoDirectivePayloadProto_init_zero {0, 0, NULL}
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_init_zero {0, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
@@ -41,7 +41,7 @@ typedef struct _alexaGadgetMusicData_TempoDirectivePayloadProto {
 /* Struct field encoding specification for nanopb */
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_FIELDLIST(X, a) \
 X(a, STATIC,   SINGULAR, INT32,    playerOffsetInMilliSeconds,   1) \
-X(a, STATIC,   REPEATED, MESSAGE,  tempoData,         2)
+X(a, POINTER,  REPEATED, MESSAGE,  tempoData,         2)
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_CALLBACK NULL
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_DEFAULT NULL
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_tempoData_MSGTYPE alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData
@@ -60,7 +60,7 @@ extern const pb_msgdesc_t alexaGadgetMusicData_TempoDirectivePayloadProto_TempoD
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_fields &alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_msg
 
 /* Maximum encoded size of messages (where known) */
-#define alexaGadgetMusicData_TempoDirectivePayloadProto_size 36
+/* alexaGadgetMusicData_TempoDirectivePayloadProto_size depends on runtime parameters */
 #define alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_size 22
 
 #ifdef __cplusplus
@@ -15,21 +15,21 @@ extern "C" {
 
 /* Struct definitions */
 typedef struct _alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States {
-    char name[32];
-    char value[32];
+    pb_view_t name;
+    pb_view_t value;
 } alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States;
 
 typedef struct _alexaGadgetStateListener_StateUpdateDirectivePayloadProto {
     pb_size_t states_count;
-    alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States states[5];
+    struct _alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States *states;
 } alexaGadgetStateListener_StateUpdateDirectivePayloadProto;
 
 
 /* Initializer values for message structs */
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_init_default {0, {alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default}}
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default {"", ""}
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_init_zero {0, {alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero}}
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero {"", ""}
+#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_init_default {0, NULL}
+#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_default {{NULL, 0}, {NULL, 0}}
+#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_init_zero {0, NULL}
+#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_init_zero {{NULL, 0}, {NULL, 0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_name_tag 1
@@ -38,14 +38,14 @@ typedef struct _alexaGadgetStateListener_StateUpdateDirectivePayloadProto {
 
 /* Struct field encoding specification for nanopb */
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_FIELDLIST(X, a) \
-X(a, STATIC,   REPEATED, MESSAGE,  states,            1)
+X(a, POINTER,  REPEATED, MESSAGE,  states,            1)
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_CALLBACK NULL
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_DEFAULT NULL
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_states_MSGTYPE alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States
 
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   name,              1) \
-X(a, STATIC,   SINGULAR, STRING,   value,             2)
+X(a, STATIC,   SINGULAR, VIEW,     name,              1) \
+X(a, STATIC,   SINGULAR, VIEW,     value,             2)
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_CALLBACK NULL
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_DEFAULT NULL
 
@@ -57,8 +57,8 @@ extern const pb_msgdesc_t alexaGadgetStateListener_StateUpdateDirectivePayloadPr
 #define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_fields &alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_msg
 
 /* Maximum encoded size of messages (where known) */
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_size 340
-#define alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_size 66
+/* alexaGadgetStateListener_StateUpdateDirectivePayloadProto_size depends on runtime parameters */
+/* alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
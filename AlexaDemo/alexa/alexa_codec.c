@@ -0,0 +1,675 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa_codec.h"
+
+// The field layout the codecs below are written for. Every field of the
+// generated FIELDLISTs is checked against it, so the build fails when a .pb.h
+// file is regenerated with a field added, renumbered or given another type.
+// HTYPE_OPTIONAL and HTYPE_SINGULAR share a value in pb.h, but only optional
+// fields have a has_ flag, so the codecs tell them apart here.
+
+#define CODEC_ATYPE_STATIC    1U
+#define CODEC_ATYPE_POINTER   2U
+#define CODEC_ATYPE_CALLBACK  3U
+
+#define CODEC_HTYPE_REQUIRED  1U
+#define CODEC_HTYPE_OPTIONAL  2U
+#define CODEC_HTYPE_SINGULAR  3U
+#define CODEC_HTYPE_REPEATED  4U
+#define CODEC_HTYPE_FIXARRAY  5U
+#define CODEC_HTYPE_ONEOF     6U
+
+#define CODEC_FIELD(atype, htype, ltype, tag) \
+   (CODEC_ATYPE_ ## atype | CODEC_HTYPE_ ## htype << 2 | \
+    (uint32_t) PB_LTYPE_MAP_ ## ltype << 5 | (uint32_t) (tag) << 9)
+
+// Members the codecs read or write directly. Other types are reached through
+// the member itself (strings by sizeof, submessages by their own layout).
+#define CODEC_MEMBER_OK_INT32(structname, fieldname)    (pb_membersize(structname, fieldname) == sizeof(int32_t))
+#define CODEC_MEMBER_OK_VIEW(structname, fieldname)     (pb_membersize(structname, fieldname) == sizeof(pb_view_t))
+#define CODEC_MEMBER_OK_STRING(structname, fieldname)   1
+#define CODEC_MEMBER_OK_MESSAGE(structname, fieldname)  1
+
+#define CODEC_CHECK_FIELD(structname, atype, htype, ltype, fieldname, tag) \
+   PB_STATIC_ASSERT(CODEC_FIELD(atype, htype, ltype, tag) == CODEC_ ## structname ## _ ## fieldname, \
+                    CODEC_FIELD_CHANGED_ ## structname ## _ ## fieldname) \
+   PB_STATIC_ASSERT(CODEC_MEMBER_OK_ ## ltype(structname, fieldname), \
+                    CODEC_MEMBER_CHANGED_ ## structname ## _ ## fieldname)
+
+// Encoded fields must also keep the one byte tag the encoder assumes.
+#define CODEC_CHECK_ENCODED_FIELD(structname, atype, htype, ltype, fieldname, tag) \
+   CODEC_CHECK_FIELD(structname, atype, htype, ltype, fieldname, tag) \
+   PB_STATIC_ASSERT((tag) < 16, CODEC_TAG_TOO_LARGE_ ## structname ## _ ## fieldname)
+
+#define CODEC_header_DirectiveHeaderProto_namespace          CODEC_FIELD(STATIC, SINGULAR, STRING, 1)
+#define CODEC_header_DirectiveHeaderProto_name               CODEC_FIELD(STATIC, SINGULAR, STRING, 2)
+#define CODEC_header_DirectiveHeaderProto_messageId          CODEC_FIELD(STATIC, SINGULAR, STRING, 3)
+#define CODEC_header_DirectiveHeaderProto_dialogRequestId    CODEC_FIELD(STATIC, SINGULAR, STRING, 4)
+header_DirectiveHeaderProto_FIELDLIST(CODEC_CHECK_FIELD, header_DirectiveHeaderProto)
+
+#define CODEC_directive_DirectiveParserProto_directive       CODEC_FIELD(STATIC, OPTIONAL, MESSAGE, 1)
+directive_DirectiveParserProto_FIELDLIST(CODEC_CHECK_FIELD, directive_DirectiveParserProto)
+
+#define CODEC_directive_DirectiveParserProto_Directive_header    CODEC_FIELD(STATIC, OPTIONAL, MESSAGE, 1)
+#define CODEC_directive_DirectiveParserProto_Directive_payload   CODEC_FIELD(STATIC, SINGULAR, VIEW, 2)
+directive_DirectiveParserProto_Directive_FIELDLIST(CODEC_CHECK_FIELD, directive_DirectiveParserProto_Directive)
+
+#define CODEC_alexaGadgetStateListener_StateUpdateDirectivePayloadProto_states \
+   CODEC_FIELD(POINTER, REPEATED, MESSAGE, 1)
+alexaGadgetStateListener_StateUpdateDirectivePayloadProto_FIELDLIST(
+   CODEC_CHECK_FIELD, alexaGadgetStateListener_StateUpdateDirectivePayloadProto)
+PB_STATIC_ASSERT(pb_membersize(alexaGadgetStateListener_StateUpdateDirectivePayloadProto, states_count) ==
+                 sizeof(pb_size_t), CODEC_MEMBER_CHANGED_states_count)
+
+#define CODEC_alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_name \
+   CODEC_FIELD(STATIC, SINGULAR, VIEW, 1)
+#define CODEC_alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_value \
+   CODEC_FIELD(STATIC, SINGULAR, VIEW, 2)
+alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_FIELDLIST(
+   CODEC_CHECK_FIELD, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States)
+
+#define CODEC_alexaGadgetMusicData_TempoDirectivePayloadProto_playerOffsetInMilliSeconds \
+   CODEC_FIELD(STATIC, SINGULAR, INT32, 1)
+#define CODEC_alexaGadgetMusicData_TempoDirectivePayloadProto_tempoData \
+   CODEC_FIELD(POINTER, REPEATED, MESSAGE, 2)
+alexaGadgetMusicData_TempoDirectivePayloadProto_FIELDLIST(
+   CODEC_CHECK_FIELD, alexaGadgetMusicData_TempoDirectivePayloadProto)
+PB_STATIC_ASSERT(pb_membersize(alexaGadgetMusicData_TempoDirectivePayloadProto, tempoData_count) ==
+                 sizeof(pb_size_t), CODEC_MEMBER_CHANGED_tempoData_count)
+
+#define CODEC_alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_value \
+   CODEC_FIELD(STATIC, SINGULAR, INT32, 1)
+#define CODEC_alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_startOffsetInMilliSeconds \
+   CODEC_FIELD(STATIC, SINGULAR, INT32, 2)
+alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_FIELDLIST(
+   CODEC_CHECK_FIELD, alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData)
+
+#define CODEC_event_EventParserProto_event                   CODEC_FIELD(STATIC, OPTIONAL, MESSAGE, 1)
+event_EventParserProto_FIELDLIST(CODEC_CHECK_ENCODED_FIELD, event_EventParserProto)
+
+#define CODEC_event_EventParserProto_Event_header            CODEC_FIELD(STATIC, OPTIONAL, MESSAGE, 1)
+#define CODEC_event_EventParserProto_Event_payload           CODEC_FIELD(STATIC, SINGULAR, VIEW, 2)
+event_EventParserProto_Event_FIELDLIST(CODEC_CHECK_ENCODED_FIELD, event_EventParserProto_Event)
+
+#define CODEC_header_EventHeaderProto_namespace              CODEC_FIELD(STATIC, SINGULAR, VIEW, 1)
+#define CODEC_header_EventHeaderProto_name                   CODEC_FIELD(STATIC, SINGULAR, VIEW, 2)
+#define CODEC_header_EventHeaderProto_messageId              CODEC_FIELD(STATIC, SINGULAR, VIEW, 3)
+header_EventHeaderProto_FIELDLIST(CODEC_CHECK_ENCODED_FIELD, header_EventHeaderProto)
+
+// Decoding works on a window of the input buffer. Submessages get a window of
+// their own, and the stream is only advanced once the whole message has been
+// decoded. As in pb_decode, a known field is decoded by its declared type
+// whatever its wire type, and unknown fields are skipped.
+
+typedef struct {
+   pb_byte_t const *next;
+   pb_byte_t const *end;
+   char const *error;
+} window_t;
+
+#define FAIL(in, message) do { (in)->error = (message); return false; } while(false)
+
+static bool readVarint(window_t *in, uint64_t *value)
+{
+   uint64_t result = 0;
+   unsigned shift = 0;
+
+   while(in->next < in->end) {
+      pb_byte_t byte = *in->next++;
+      result |= (uint64_t) (byte & 0x7FU) << shift;
+      if(!(byte & 0x80U)) {
+         *value = result;
+         return true;
+      }
+      shift += 7;
+      if(shift >= 64) {
+         FAIL(in, "varint overflow");
+      }
+   }
+   FAIL(in, "io error");
+}
+
+// Same rules as pb_decode_varint32: bytes past bit 32 may only carry the
+// sign extension of a negative value.
+static bool readVarint32(window_t *in, uint32_t *value)
+{
+   pb_byte_t byte;
+   uint32_t result;
+   unsigned bitpos = 7;
+
+   if(in->next == in->end) {
+      FAIL(in, "io error");
+   }
+   byte = *in->next++;
+   // Almost every tag and length here fits in one byte.
+   if(!(byte & 0x80U)) {
+      *value = byte;
+      return true;
+   }
+
+   result = byte & 0x7FU;
+   do {
+      if(in->next == in->end) {
+         FAIL(in, "io error");
+      }
+      byte = *in->next++;
+      if(bitpos >= 32) {
+         pb_byte_t signExtension = (bitpos < 63) ? 0xFFU : 0x01U;
+         if((byte & 0x7FU) != 0 && ((result >> 31) == 0 || byte != signExtension)) {
+            FAIL(in, "varint overflow");
+         }
+      }
+      else {
+         result |= (uint32_t) (byte & 0x7FU) << bitpos;
+      }
+      bitpos += 7;
+   } while(byte & 0x80U);
+
+   if(bitpos == 35 && (byte & 0x70U) != 0) {
+      FAIL(in, "varint overflow");
+   }
+   *value = result;
+   return true;
+}
+
+// Reads a tag; returns false at the end of the window with no error set.
+static bool readTag(window_t *in, uint32_t *field, pb_wire_type_t *wireType)
+{
+   uint32_t tag;
+
+   if(in->next == in->end || !readVarint32(in, &tag)) {
+      return false;
+   }
+   if(tag >> 3 == 0) {
+      FAIL(in, "zero tag");
+   }
+   *field = tag >> 3;
+   *wireType = (pb_wire_type_t) (tag & 0x07U);
+   return true;
+}
+
+// Reads a length prefix and splits the field's bytes off into sub.
+static bool readDelimited(window_t *in, window_t *sub)
+{
+   uint32_t length;
+
+   if(!readVarint32(in, &length)) {
+      return false;
+   }
+   if(length > (size_t) (in->end - in->next)) {
+      FAIL(in, "parent stream too short");
+   }
+   sub->next = in->next;
+   sub->end = in->next + length;
+   sub->error = NULL;
+   in->next = sub->end;
+   return true;
+}
+
+static bool skipVarint(window_t *in)
+{
+   pb_byte_t byte;
+
+   do {
+      if(in->next == in->end) {
+         FAIL(in, "io error");
+      }
+      byte = *in->next++;
+   } while(byte & 0x80U);
+   return true;
+}
+
+static bool skipField(window_t *in, pb_wire_type_t wireType)
+{
+   window_t skipped;
+   size_t size;
+
+   switch(wireType) {
+      case PB_WT_VARINT:
+         return skipVarint(in);
+      case PB_WT_STRING:
+         return readDelimited(in, &skipped);
+      case PB_WT_64BIT:
+         size = 8;
+         break;
+      case PB_WT_32BIT:
+         size = 4;
+         break;
+      default:
+         FAIL(in, "invalid wire_type");
+   }
+   if(size > (size_t) (in->end - in->next)) {
+      FAIL(in, "io error");
+   }
+   in->next += size;
+   return true;
+}
+
+static bool readString(window_t *in, char *dest, size_t destSize)
+{
+   window_t string;
+
+   if(!readDelimited(in, &string)) {
+      return false;
+   }
+   size_t size = (size_t) (string.end - string.next);
+   if(size + 1 > destSize) {
+      FAIL(in, "string overflow");
+   }
+   memcpy(dest, string.next, size);
+   dest[size] = '\0';
+   return true;
+}
+
+static bool readView(window_t *in, pb_view_t *dest)
+{
+   window_t view;
+
+   if(!readDelimited(in, &view)) {
+      return false;
+   }
+   if((size_t) (view.end - view.next) > PB_SIZE_MAX) {
+      FAIL(in, "bytes overflow");
+   }
+   dest->bytes = view.next;
+   dest->size = (pb_size_t) (view.end - view.next);
+   return true;
+}
+
+// Like pb_decode, keeps the low 32 bits so that negative values encoded as
+// 32 rather than 64 bit varints still come out right.
+static bool readInt32(window_t *in, int32_t *dest)
+{
+   uint64_t value;
+
+   if(!readVarint(in, &value)) {
+      return false;
+   }
+   *dest = (int32_t) value;
+   return true;
+}
+
+// Makes room for one more entry of a repeated field.
+static void *appendEntry(window_t *in, void **array, pb_size_t *count, size_t entrySize)
+{
+   if(*count == PB_SIZE_MAX) {
+      in->error = "too many array entries";
+      return NULL;
+   }
+   void *grown = pb_realloc(*array, ((size_t) *count + 1) * entrySize);
+   if(grown == NULL) {
+      in->error = "realloc failed";
+      return NULL;
+   }
+   *array = grown;
+   return (uint8_t *) grown + (size_t) (*count)++ * entrySize;
+}
+
+// Hands the outcome back to the stream the way pb_decode does.
+static bool finish(pb_istream_t *stream, window_t const *in, bool status)
+{
+   if(!status) {
+      PB_RETURN_ERROR(stream, in->error ? in->error : "io error");
+   }
+   stream->state = (void *) in->end;
+   stream->bytes_left = 0;
+   return true;
+}
+
+static bool openWindow(pb_istream_t *stream, window_t *in)
+{
+#ifndef PB_BUFFER_ONLY
+   // The decoders read the buffer directly and leave views pointing into it.
+   pb_istream_t probe = pb_istream_from_buffer(NULL, 0);
+   if(stream->callback != probe.callback) {
+      PB_RETURN_ERROR(stream, "view needs buffer stream");
+   }
+#endif
+   in->next = (pb_byte_t const *) stream->state;
+   in->end = in->next + stream->bytes_left;
+   in->error = NULL;
+   return true;
+}
+
+static void resetDirectiveHeader(header_DirectiveHeaderProto *dest)
+{
+   dest->namespace[0] = '\0';
+   dest->name[0] = '\0';
+   dest->messageId[0] = '\0';
+   dest->dialogRequestId[0] = '\0';
+}
+
+static bool decodeDirectiveHeader(window_t *in, header_DirectiveHeaderProto *dest)
+{
+   uint32_t field;
+   pb_wire_type_t wireType;
+
+   while(readTag(in, &field, &wireType)) {
+      bool status;
+      switch(field) {
+         case header_DirectiveHeaderProto_namespace_tag:
+            status = readString(in, dest->namespace, sizeof(dest->namespace));
+            break;
+         case header_DirectiveHeaderProto_name_tag:
+            status = readString(in, dest->name, sizeof(dest->name));
+            break;
+         case header_DirectiveHeaderProto_messageId_tag:
+            status = readString(in, dest->messageId, sizeof(dest->messageId));
+            break;
+         case header_DirectiveHeaderProto_dialogRequestId_tag:
+            status = readString(in, dest->dialogRequestId, sizeof(dest->dialogRequestId));
+            break;
+         default:
+            status = skipField(in, wireType);
+            break;
+      }
+      if(!status) {
+         return false;
+      }
+   }
+   return in->error == NULL;
+}
+
+static bool decodeDirective(window_t *in, directive_DirectiveParserProto_Directive *dest)
+{
+   uint32_t field;
+   pb_wire_type_t wireType;
+   window_t sub;
+
+   while(readTag(in, &field, &wireType)) {
+      bool status;
+      switch(field) {
+         case directive_DirectiveParserProto_Directive_header_tag:
+            dest->has_header = true;
+            status = readDelimited(in, &sub);
+            if(status && !decodeDirectiveHeader(&sub, &dest->header)) {
+               in->error = sub.error;
+               status = false;
+            }
+            break;
+         case directive_DirectiveParserProto_Directive_payload_tag:
+            status = readView(in, &dest->payload);
+            break;
+         default:
+            status = skipField(in, wireType);
+            break;
+      }
+      if(!status) {
+         return false;
+      }
+   }
+   return in->error == NULL;
+}
+
+bool header_DirectiveHeaderProto_decode(pb_istream_t *stream, header_DirectiveHeaderProto *dest)
+{
+   window_t in;
+
+   if(!openWindow(stream, &in)) {
+      return false;
+   }
+   resetDirectiveHeader(dest);
+   return finish(stream, &in, decodeDirectiveHeader(&in, dest));
+}
+
+bool directive_DirectiveParserProto_decode(pb_istream_t *stream, directive_DirectiveParserProto *dest)
+{
+   window_t in;
+   window_t sub;
+   uint32_t field;
+   pb_wire_type_t wireType;
+   bool status = true;
+
+   if(!openWindow(stream, &in)) {
+      return false;
+   }
+   dest->has_directive = false;
+   dest->directive.has_header = false;
+   resetDirectiveHeader(&dest->directive.header);
+   dest->directive.payload.bytes = NULL;
+   dest->directive.payload.size = 0;
+
+   while(status && readTag(&in, &field, &wireType)) {
+      if(field == directive_DirectiveParserProto_directive_tag) {
+         dest->has_directive = true;
+         status = readDelimited(&in, &sub);
+         if(status && !decodeDirective(&sub, &dest->directive)) {
+            in.error = sub.error;
+            status = false;
+         }
+      }
+      else {
+         status = skipField(&in, wireType);
+      }
+   }
+   return finish(stream, &in, status && in.error == NULL);
+}
+
+static bool decodeState(window_t *in, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States *dest)
+{
+   uint32_t field;
+   pb_wire_type_t wireType;
+
+   while(readTag(in, &field, &wireType)) {
+      bool status;
+      switch(field) {
+         case alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_name_tag:
+            status = readView(in, &dest->name);
+            break;
+         case alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States_value_tag:
+            status = readView(in, &dest->value);
+            break;
+         default:
+            status = skipField(in, wireType);
+            break;
+      }
+      if(!status) {
+         return false;
+      }
+   }
+   return in->error == NULL;
+}
+
+bool alexaGadgetStateListener_StateUpdateDirectivePayloadProto_decode(
+   pb_istream_t *stream,
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto *dest)
+{
+   window_t in;
+   window_t sub;
+   uint32_t field;
+   pb_wire_type_t wireType;
+   bool status = true;
+
+   if(!openWindow(stream, &in)) {
+      return false;
+   }
+   dest->states_count = 0;
+   dest->states = NULL;
+
+   while(status && readTag(&in, &field, &wireType)) {
+      if(field == alexaGadgetStateListener_StateUpdateDirectivePayloadProto_states_tag) {
+         alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States *state;
+         status = readDelimited(&in, &sub);
+         if(!status) {
+            break;
+         }
+         state = appendEntry(&in, (void **) &dest->states, &dest->states_count, sizeof(*state));
+         if(state == NULL) {
+            status = false;
+            break;
+         }
+         state->name.bytes = NULL;
+         state->name.size = 0;
+         state->value.bytes = NULL;
+         state->value.size = 0;
+         if(!decodeState(&sub, state)) {
+            in.error = sub.error;
+            status = false;
+         }
+      }
+      else {
+         status = skipField(&in, wireType);
+      }
+   }
+   return finish(stream, &in, status && in.error == NULL);
+}
+
+static bool decodeTempoData(window_t *in, alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData *dest)
+{
+   uint32_t field;
+   pb_wire_type_t wireType;
+
+   while(readTag(in, &field, &wireType)) {
+      bool status;
+      switch(field) {
+         case alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_value_tag:
+            status = readInt32(in, &dest->value);
+            break;
+         case alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData_startOffsetInMilliSeconds_tag:
+            status = readInt32(in, &dest->startOffsetInMilliSeconds);
+            break;
+         default:
+            status = skipField(in, wireType);
+            break;
+      }
+      if(!status) {
+         return false;
+      }
+   }
+   return in->error == NULL;
+}
+
+bool alexaGadgetMusicData_TempoDirectivePayloadProto_decode(
+   pb_istream_t *stream,
+   alexaGadgetMusicData_TempoDirectivePayloadProto *dest)
+{
+   window_t in;
+   window_t sub;
+   uint32_t field;
+   pb_wire_type_t wireType;
+   bool status = true;
+
+   if(!openWindow(stream, &in)) {
+      return false;
+   }
+   dest->playerOffsetInMilliSeconds = 0;
+   dest->tempoData_count = 0;
+   dest->tempoData = NULL;
+
+   while(status && readTag(&in, &field, &wireType)) {
+      switch(field) {
+         case alexaGadgetMusicData_TempoDirectivePayloadProto_playerOffsetInMilliSeconds_tag:
+            status = readInt32(&in, &dest->playerOffsetInMilliSeconds);
+            break;
+         case alexaGadgetMusicData_TempoDirectivePayloadProto_tempoData_tag: {
+            alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData *entry;
+            status = readDelimited(&in, &sub);
+            if(!status) {
+               break;
+            }
+            entry = appendEntry(&in, (void **) &dest->tempoData, &dest->tempoData_count, sizeof(*entry));
+            if(entry == NULL) {
+               status = false;
+               break;
+            }
+            entry->value = 0;
+            entry->startOffsetInMilliSeconds = 0;
+            if(!decodeTempoData(&sub, entry)) {
+               in.error = sub.error;
+               status = false;
+            }
+            break;
+         }
+         default:
+            status = skipField(&in, wireType);
+            break;
+      }
+   }
+   return finish(stream, &in, status && in.error == NULL);
+}
+
+// Every field number below is under 16, so each tag is a single byte.
+#define TAG_SIZE 1U
+
+static size_t varintSize(size_t value)
+{
+   size_t size = 1;
+   while(value >= 0x80U) {
+      value >>= 7;
+      size++;
+   }
+   return size;
+}
+
+// Encoded size of a view field; empty views are left out, as in pb_encode.
+static size_t viewFieldSize(pb_view_t const *view)
+{
+   if(view->size == 0) {
+      return 0;
+   }
+   return TAG_SIZE + varintSize(view->size) + view->size;
+}
+
+static bool writeView(pb_ostream_t *stream, uint32_t field, pb_view_t const *view)
+{
+   if(view->size == 0) {
+      return true;
+   }
+   if(view->bytes == NULL) {
+      PB_RETURN_ERROR(stream, "invalid view");
+   }
+   return pb_encode_tag(stream, PB_WT_STRING, field) &&
+          pb_encode_string(stream, view->bytes, view->size);
+}
+
+static bool writeLength(pb_ostream_t *stream, uint32_t field, size_t size)
+{
+   return pb_encode_tag(stream, PB_WT_STRING, field) &&
+          pb_encode_varint(stream, (uint64_t) size);
+}
+
+bool event_EventParserProto_encode(pb_ostream_t *stream, event_EventParserProto const *src)
+{
+   event_EventParserProto_Event const *event = &src->event;
+   header_EventHeaderProto const *header = &event->header;
+   size_t headerSize;
+   size_t eventSize;
+
+   if(!src->has_event) {
+      return true;
+   }
+
+   headerSize = viewFieldSize(&header->namespace) +
+                viewFieldSize(&header->name) +
+                viewFieldSize(&header->messageId);
+   eventSize = viewFieldSize(&event->payload);
+   if(event->has_header) {
+      eventSize += TAG_SIZE + varintSize(headerSize) + headerSize;
+   }
+
+   if(!writeLength(stream, event_EventParserProto_event_tag, eventSize)) {
+      return false;
+   }
+   if(event->has_header) {
+      if(!writeLength(stream, event_EventParserProto_Event_header_tag, headerSize) ||
+         !writeView(stream, header_EventHeaderProto_namespace_tag, &header->namespace) ||
+         !writeView(stream, header_EventHeaderProto_name_tag, &header->name) ||
+         !writeView(stream, header_EventHeaderProto_messageId_tag, &header->messageId))
+      {
+         return false;
+      }
+   }
+   return writeView(stream, event_EventParserProto_Event_payload_tag, &event->payload);
+}
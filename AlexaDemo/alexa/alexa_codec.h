@@ -0,0 +1,78 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_ALEXA_CODEC_H
+#define ALEXA_GADGETS_SAMPLE_CODE_ALEXA_CODEC_H
+
+#include <stdbool.h>
+
+#include "pb.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "alexaGadgetMusicDataTempoDirectivePayload.pb.h"
+#include "alexaGadgetStateListenerStateUpdateDirectivePayload.pb.h"
+#include "directiveHeader.pb.h"
+#include "directiveParser.pb.h"
+#include "eventParser.pb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Specialized codecs for the messages on the directive and event paths. Each
+// one is equivalent to pb_decode() or pb_encode() with the matching _fields
+// descriptor, but has the field layout written out instead of walking the
+// descriptor at run time. They must be kept in step with the .pb.h files.
+//
+// The decoders read memory buffers only (pb_istream_from_buffer()) and reset
+// the destination the way pb_decode_ex() does with PB_DECODE_NOCLEAR, so it
+// does not need to be initialized. Repeated fields are allocated with
+// pb_realloc(). Errors are reported through PB_GET_ERROR() on the stream.
+
+/**
+ * Decodes a directive header, as pb_decode() with header_DirectiveHeaderProto_fields.
+ */
+bool header_DirectiveHeaderProto_decode(pb_istream_t *stream, header_DirectiveHeaderProto *dest);
+
+/**
+ * Decodes a directive, as pb_decode() with directive_DirectiveParserProto_fields.
+ * The payload is left pointing into the stream's buffer.
+ */
+bool directive_DirectiveParserProto_decode(pb_istream_t *stream, directive_DirectiveParserProto *dest);
+
+/**
+ * Decodes a StateUpdate payload, as pb_decode() with
+ * alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields.
+ */
+bool alexaGadgetStateListener_StateUpdateDirectivePayloadProto_decode(
+   pb_istream_t *stream,
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto *dest);
+
+/**
+ * Decodes a Tempo payload, as pb_decode() with
+ * alexaGadgetMusicData_TempoDirectivePayloadProto_fields.
+ */
+bool alexaGadgetMusicData_TempoDirectivePayloadProto_decode(
+   pb_istream_t *stream,
+   alexaGadgetMusicData_TempoDirectivePayloadProto *dest);
+
+/**
+ * Encodes an event, as pb_encode() with event_EventParserProto_fields. Every
+ * submessage length is worked out up front, so unlike pb_encode() nothing is
+ * encoded twice when the stream is not a memory buffer.
+ */
+bool event_EventParserProto_encode(pb_ostream_t *stream, event_EventParserProto const *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_ALEXA_CODEC_H
@@ -0,0 +1,94 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include "codec_stats.h"
+
+#if SAMPLE_CODEC_STATS
+
+#include <stdio.h>
+
+#include "em_device.h"
+
+#include "app.h"
+#include "directive_arena.h"
+#include "helpers.h"
+
+typedef struct {
+   char const *name;
+   char const *direction;
+   uint32_t count;
+   uint32_t errors;
+   uint32_t bytes;
+   uint32_t cycles;
+   uint32_t maxCycles;
+   uint32_t maxArena;
+} codec_stats_t;
+
+static codec_stats_t stats[CODEC_STATS_MESSAGE_COUNT] = {
+   [CODEC_STATS_CONTROL_ENVELOPE_DECODE]   = { "ControlEnvelope", "decode" },
+   [CODEC_STATS_DIRECTIVE_DECODE]          = { "DirectiveParserProto", "decode" },
+   [CODEC_STATS_DIRECTIVE_HEADER_DECODE]   = { "DirectiveHeaderProto", "decode" },
+   [CODEC_STATS_STATE_UPDATE_DECODE]       = { "StateUpdateDirectivePayloadProto", "decode" },
+   [CODEC_STATS_TEMPO_DECODE]              = { "TempoDirectivePayloadProto", "decode" },
+   [CODEC_STATS_CONTROL_ENVELOPE_ENCODE]   = { "ControlEnvelope", "encode" },
+   [CODEC_STATS_DISCOVERY_RESPONSE_ENCODE] = { "DiscoverResponseEventProto", "encode" },
+   [CODEC_STATS_EVENT_ENCODE]              = { "EventParserProto", "encode" },
+};
+
+uint32_t CodecStats_start(void)
+{
+   // The cycle counter is off until a debugger or this code turns it on.
+   if(!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CYCCNT = 0;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+   }
+   return DWT->CYCCNT;
+}
+
+uint32_t CodecStats_elapsed(uint32_t start)
+{
+   return DWT->CYCCNT - start;
+}
+
+void CodecStats_finish(codec_stats_message_t message, uint32_t start, size_t size, bool status)
+{
+   uint32_t cycles = CodecStats_elapsed(start);
+   codec_stats_t *entry = &stats[message];
+
+   entry->count++;
+   if(!status) {
+      entry->errors++;
+   }
+   entry->bytes += (uint32_t) size;
+   entry->cycles += cycles;
+   entry->maxCycles = MAX(entry->maxCycles, cycles);
+   entry->maxArena = MAX(entry->maxArena, (uint32_t) DirectiveArena_getUsed());
+}
+
+void CodecStats_print(void)
+{
+   printLog("{\"codec_stats\":1,\"core_hz\":%lu,\"arena_high_water\":%lu,\"messages\":[",
+            (unsigned long) SystemCoreClock,
+            (unsigned long) DirectiveArena_getHighWater());
+   for(size_t i = 0; i < CODEC_STATS_MESSAGE_COUNT; i++) {
+      codec_stats_t const *entry = &stats[i];
+      printLog("%s{\"message\":\"%s\",\"direction\":\"%s\",\"count\":%lu,\"errors\":%lu,"
+               "\"bytes\":%lu,\"cycles\":%lu,\"max_cycles\":%lu,\"max_arena\":%lu}",
+               (i > 0) ? "," : "", entry->name, entry->direction,
+               (unsigned long) entry->count, (unsigned long) entry->errors,
+               (unsigned long) entry->bytes, (unsigned long) entry->cycles,
+               (unsigned long) entry->maxCycles, (unsigned long) entry->maxArena);
+   }
+   printLog("]}\r\n");
+}
+
+#endif
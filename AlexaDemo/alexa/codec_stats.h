@@ -0,0 +1,99 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_CODEC_STATS_H
+#define ALEXA_GADGETS_SAMPLE_CODE_CODEC_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Every message encoded or decoded on the device, in each direction it is used.
+ */
+typedef enum {
+   CODEC_STATS_CONTROL_ENVELOPE_DECODE,
+   CODEC_STATS_DIRECTIVE_DECODE,
+   CODEC_STATS_DIRECTIVE_HEADER_DECODE,
+   CODEC_STATS_STATE_UPDATE_DECODE,
+   CODEC_STATS_TEMPO_DECODE,
+   CODEC_STATS_CONTROL_ENVELOPE_ENCODE,
+   CODEC_STATS_DISCOVERY_RESPONSE_ENCODE,
+   CODEC_STATS_EVENT_ENCODE,
+   CODEC_STATS_MESSAGE_COUNT
+} codec_stats_message_t;
+
+#if SAMPLE_CODEC_STATS
+
+/**
+ * Marks the start of one encode or decode.
+ * @return the value to pass to CodecStats_finish().
+ */
+uint32_t CodecStats_start(void);
+
+/**
+ * Returns the cycles since a call to CodecStats_start(), for timing other work.
+ * @param start the value returned by CodecStats_start().
+ */
+uint32_t CodecStats_elapsed(uint32_t start);
+
+/**
+ * Records one encode or decode.
+ * @param message what was encoded or decoded.
+ * @param start the value returned by CodecStats_start().
+ * @param size the encoded size in bytes.
+ * @param status whether the encode or decode succeeded.
+ */
+void CodecStats_finish(codec_stats_message_t message, uint32_t start, size_t size, bool status);
+
+/**
+ * Prints the totals since boot as a single line of JSON.
+ */
+void CodecStats_print(void);
+
+#else
+
+static inline uint32_t CodecStats_start(void)
+{
+   return 0;
+}
+
+static inline uint32_t CodecStats_elapsed(uint32_t start)
+{
+   (void) start;
+   return 0;
+}
+
+static inline void CodecStats_finish(codec_stats_message_t message, uint32_t start, size_t size, bool status)
+{
+   (void) message;
+   (void) start;
+   (void) size;
+   (void) status;
+}
+
+static inline void CodecStats_print(void)
+{
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_CODEC_STATS_H
@@ -15,6 +15,7 @@
 
 #define ADV_DATA_LEN (31U)
 #define BLE_AD_TYPE (0x06) // LE General discoverable mode, BT/EDR not supported.
+#define ATT_HEADER_SIZE (3U) // ATT opcode and handle ahead of a write or notification value.
 #define CONTROL_PACKET_LENGTH (6)
 #define PROTOCOL_IDENTIFIER (0xFE03U)
 #define PROTOCOL_VERSION_MAJOR (3U)
@@ -10,6 +10,64 @@
 #define ALEXA_GADGETS_SAMPLE_CODE_CONFIG_H
 
 #define SAMPLE_MAX_TRANSACTION_SIZE (5000U)
-#define SAMPLE_NEGOTIATED_MTU       (128U)
+
+// ATT MTU offered in the MTU exchange. Packets are sized from the MTU that is
+// actually negotiated on the connection, SAMPLE_DEFAULT_ATT_MTU until then.
+#define SAMPLE_MAX_ATT_MTU                  (250U)
+#define SAMPLE_DEFAULT_ATT_MTU              (23U)
+
+// Largest transaction reassembled on the control and OTA streams. Alexa stream
+// transactions may use the full SAMPLE_MAX_TRANSACTION_SIZE.
+#define SAMPLE_MAX_CONTROL_TRANSACTION_SIZE (256U)
+
+// Transactions that may be reassembled at the same time. Control and OTA
+// stream transactions share the buffered slots; Alexa stream directives use
+// the directive slots, each of which holds a decoded directive payload.
+#define SAMPLE_RX_BUFFERED_TRANSACTIONS     (4U)
+#define SAMPLE_RX_DIRECTIVE_TRANSACTIONS    (2U)
+
+// A transaction that receives no fragment for this long is dropped.
+#define SAMPLE_RX_TRANSACTION_TIMEOUT_MS    (5000U)
+
+// Encoded Alexa.Discovery response kept from boot. A response that does not
+// fit is encoded again for every Discover directive.
+#define SAMPLE_DISCOVERY_CACHE_SIZE         (512U)
+
+// Outbound frames waiting to be sent, including a one byte length per frame.
+// A transaction is queued whole, so this bounds the largest event that can be
+// sent: about 3 KB at the default ATT MTU, more once a larger MTU is in use.
+#define SAMPLE_TX_RING_SIZE                 (4096U)
+
+// Space for the dynamically allocated fields of one decoded directive payload,
+// such as StateUpdate states and Tempo entries. Released after each directive.
+#define SAMPLE_DIRECTIVE_ARENA_SIZE         (1024U)
+
+// Fixed blocks behind packet_t data and packet_list_t nodes: list nodes, short
+// packets (ACKs, protocol version, advertising data) and MTU sized fragments.
+// A request that finds its own pool empty is served from a larger one. A list
+// from buildStreamPacket() holds a block per fragment until it is sent, so
+// the fragment blocks bound the transactions framed that way.
+#define SAMPLE_PACKET_POOL_NODES            (8U)
+#define SAMPLE_PACKET_POOL_SHORT_PACKETS    (4U)
+#define SAMPLE_PACKET_POOL_FRAGMENTS        (4U)
+
+// Static work area shared by message structs too large for the stack, such as
+// the Alexa.Discovery response. The build fails if one of them outgrows it.
+#ifndef SAMPLE_MESSAGE_SCRATCH_SIZE
+#define SAMPLE_MESSAGE_SCRATCH_SIZE         (640U)
+#endif
+
+// Set to 1 to trap on any heap allocation after boot. Also add
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free to the linker
+// flags so that the allocator calls reach heap_guard.c; the link fails without
+// them. Allocations made during boot are printed as one line of JSON each
+// time the connection closes.
+#ifndef SAMPLE_HEAP_GUARD
+#define SAMPLE_HEAP_GUARD                   (0U)
+#endif
+
+// Set to 1 to count cycles and bytes for every protobuf encode and decode. The
+// totals are printed as one line of JSON each time the connection closes.
+#define SAMPLE_CODEC_STATS                  (0U)
 
 #endif //ALEXA_GADGETS_SAMPLE_CODE_CONFIG_H
@@ -15,11 +15,10 @@ extern "C" {
 #endif
 
 /* Struct definitions */
-typedef PB_BYTES_ARRAY_T(2048) directive_DirectiveParserProto_Directive_payload_t;
 typedef struct _directive_DirectiveParserProto_Directive {
     bool has_header;
     header_DirectiveHeaderProto header;
-    directive_DirectiveParserProto_Directive_payload_t payload;
+    pb_view_t payload;
 } directive_DirectiveParserProto_Directive;
 
 typedef struct _directive_DirectiveParserProto {
@@ -30,9 +29,9 @@ typedef struct _directive_DirectiveParserProto {
 
 /* Initializer values for message structs */
 #define directive_DirectiveParserProto_init_default {false, directive_DirectiveParserProto_Directive_init_default}
-#define directive_DirectiveParserProto_Directive_init_default {false, header_DirectiveHeaderProto_init_default, {0, {0}}}
+#define directive_DirectiveParserProto_Directive_init_default {false, header_DirectiveHeaderProto_init_default, {NULL, 0}}
 #define directive_DirectiveParserProto_init_zero {false, directive_DirectiveParserProto_Directive_init_zero}
-#define directive_DirectiveParserProto_Directive_init_zero {false, header_DirectiveHeaderProto_init_zero, {0, {0}}}
+#define directive_DirectiveParserProto_Directive_init_zero {false, header_DirectiveHeaderProto_init_zero, {NULL, 0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define directive_DirectiveParserProto_Directive_payload_tag 2
@@ -48,7 +47,7 @@ X(a, STATIC,   OPTIONAL, MESSAGE,  directive,         1)
 
 #define directive_DirectiveParserProto_Directive_FIELDLIST(X, a) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  header,            1) \
-X(a, STATIC,   SINGULAR, BYTES,    payload,           2)
+X(a, STATIC,   SINGULAR, VIEW,     payload,           2)
 #define directive_DirectiveParserProto_Directive_CALLBACK NULL
 #define directive_DirectiveParserProto_Directive_DEFAULT NULL
 #define directive_DirectiveParserProto_Directive_header_MSGTYPE header_DirectiveHeaderProto
@@ -61,8 +60,8 @@ extern const pb_msgdesc_t directive_DirectiveParserProto_Directive_msg;
 #define directive_DirectiveParserProto_Directive_fields &directive_DirectiveParserProto_Directive_msg
 
 /* Maximum encoded size of messages (where known) */
-#define directive_DirectiveParserProto_size      2189
-#define directive_DirectiveParserProto_Directive_size 2186
+/* directive_DirectiveParserProto_size depends on runtime parameters */
+/* directive_DirectiveParserProto_Directive_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,108 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.h"
+#include "directive_arena.h"
+#include "helpers.h"
+
+// Blocks are carved from the front of the arena, each behind a header that
+// records its size so a block can be copied when it has to move. Headers and
+// blocks are kept aligned for any field type nanopb may store.
+typedef union {
+   size_t size;
+   uint64_t align;
+} block_header_t;
+
+#define BLOCK_ALIGN sizeof(block_header_t)
+
+static block_header_t arena[SAMPLE_DIRECTIVE_ARENA_SIZE / sizeof(block_header_t)];
+static size_t arenaUsed;
+static size_t arenaHighWater;
+static block_header_t *newestBlock;
+static bool arenaOpen;
+
+static size_t roundUp(size_t size)
+{
+   return (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+}
+
+// Moves the end of the used space, failing if it would pass the arena end.
+static bool setUsed(size_t used)
+{
+   if(used > sizeof(arena)) {
+      return false;
+   }
+   arenaUsed = used;
+   if(used > arenaHighWater) {
+      arenaHighWater = used;
+   }
+   return true;
+}
+
+void DirectiveArena_begin(void)
+{
+   arenaUsed = 0;
+   newestBlock = NULL;
+   arenaOpen = true;
+}
+
+void *DirectiveArena_realloc(void *ptr, size_t size)
+{
+   block_header_t *block = (ptr != NULL) ? (block_header_t *) ptr - 1 : NULL;
+   size_t start = arenaUsed;
+
+   if(!arenaOpen || size > sizeof(arena)) {
+      return NULL;
+   }
+   if(block != NULL && block == newestBlock) {
+      start = (size_t) ((uint8_t *) block - (uint8_t *) arena);
+   }
+   if(!setUsed(start + sizeof(block_header_t) + roundUp(size))) {
+      return NULL;
+   }
+
+   block_header_t *moved = (block_header_t *) ((uint8_t *) arena + start);
+   if(block != NULL && moved != block) {
+      memcpy(moved + 1, block + 1, MIN(block->size, size));
+   }
+   moved->size = size;
+   newestBlock = moved;
+   return moved + 1;
+}
+
+void DirectiveArena_free(void *ptr)
+{
+   if(ptr != NULL && (block_header_t *) ptr - 1 == newestBlock) {
+      arenaUsed = (size_t) ((uint8_t *) newestBlock - (uint8_t *) arena);
+      newestBlock = NULL;
+   }
+}
+
+void DirectiveArena_reset(void)
+{
+   arenaUsed = 0;
+   newestBlock = NULL;
+   arenaOpen = false;
+}
+
+size_t DirectiveArena_getUsed(void)
+{
+   return arenaUsed;
+}
+
+size_t DirectiveArena_getHighWater(void)
+{
+   return arenaHighWater;
+}
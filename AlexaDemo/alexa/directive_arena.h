@@ -0,0 +1,68 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ARENA_H
+#define ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opens the arena for the directive about to be handled. Allocations are only
+ * served between this and the next DirectiveArena_reset(), so a message
+ * decoded anywhere else cannot take arena space that is about to be reused.
+ */
+void DirectiveArena_begin(void);
+
+/**
+ * Allocates or resizes a block in the directive arena. This backs nanopb's
+ * pb_realloc, so dynamically allocated message fields never use the heap.
+ * Growing the newest block, which is how repeated fields are filled in, is
+ * done in place.
+ * @param ptr the block to resize, or NULL for a new block.
+ * @param size the new size in bytes.
+ * @return the block, or NULL if the arena is full or not open for a
+ *         directive; \p ptr stays valid then.
+ */
+void *DirectiveArena_realloc(void *ptr, size_t size);
+
+/**
+ * Releases a block. Only the newest block is given back right away; the
+ * space of any other block is reclaimed by DirectiveArena_reset().
+ * @param ptr the block to release, or NULL.
+ */
+void DirectiveArena_free(void *ptr);
+
+/**
+ * Releases every block at once and closes the arena until the next
+ * DirectiveArena_begin(). Called when a directive has been handled, after
+ * which nothing decoded for it may be used.
+ */
+void DirectiveArena_reset(void);
+
+/**
+ * Returns the arena space in use, in bytes.
+ */
+size_t DirectiveArena_getUsed(void);
+
+/**
+ * Returns the most arena space in use since boot, in bytes.
+ */
+size_t DirectiveArena_getHighWater(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ARENA_H
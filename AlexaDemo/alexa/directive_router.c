@@ -0,0 +1,136 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app.h"
+#include "codec_stats.h"
+#include "directive_router.h"
+
+static int compareRoute(
+   directive_route_t const *route,
+   char const *namespace,
+   char const *name)
+{
+   int order = strcmp(namespace, route->namespace);
+   if(order == 0) {
+      order = strcmp(name, route->name);
+   }
+   return order;
+}
+
+static bool isSorted(directive_router_t const *router)
+{
+   for(size_t i = 1; i < router->count; i++) {
+      directive_route_t const *route = &router->routes[i];
+      if(compareRoute(&router->routes[i - 1], route->namespace, route->name) <= 0) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Used when the table is out of order, which a binary search would get wrong.
+static directive_route_t *scanRoutes(
+   directive_router_t *router,
+   char const *namespace,
+   char const *name)
+{
+   for(size_t i = 0; i < router->count; i++) {
+      if(compareRoute(&router->routes[i], namespace, name) == 0) {
+         return &router->routes[i];
+      }
+   }
+   return NULL;
+}
+
+static directive_route_t *findRoute(
+   directive_router_t *router,
+   char const *namespace,
+   char const *name)
+{
+   if(!router->checked) {
+      DirectiveRouter_init(router);
+   }
+   if(!router->sorted) {
+      return scanRoutes(router, namespace, name);
+   }
+
+   size_t low = 0;
+   size_t high = router->count;
+
+   while(low < high) {
+      size_t middle = low + (high - low) / 2;
+      int order = compareRoute(&router->routes[middle], namespace, name);
+      if(order == 0) {
+         return &router->routes[middle];
+      }
+      if(order < 0) {
+         high = middle;
+      }
+      else {
+         low = middle + 1;
+      }
+   }
+   return NULL;
+}
+
+void DirectiveRouter_init(directive_router_t *router)
+{
+   router->sorted = isSorted(router);
+   router->checked = true;
+   if(!router->sorted) {
+      printLog("Error: directive routes are not sorted, searching them one by one\n");
+   }
+}
+
+bool DirectiveRouter_accepts(directive_router_t *router, header_DirectiveHeaderProto const *header)
+{
+   return findRoute(router, header->namespace, header->name) != NULL;
+}
+
+bool DirectiveRouter_dispatch(
+   directive_router_t *router,
+   header_DirectiveHeaderProto const *header,
+   uint8_t const *payload,
+   size_t payloadSize)
+{
+   directive_route_t *route = findRoute(router, header->namespace, header->name);
+   if(route == NULL) {
+      router->unknown++;
+      return false;
+   }
+
+   uint32_t start = CodecStats_start();
+   route->handler(payload, payloadSize);
+   uint32_t cycles = CodecStats_elapsed(start);
+
+   route->calls++;
+   route->cycles += cycles;
+   route->maxCycles = MAX(route->maxCycles, cycles);
+   return true;
+}
+
+void DirectiveRouter_print(directive_router_t const *router)
+{
+   printLog("{\"directive_stats\":1,\"unknown\":%lu,\"routes\":[",
+            (unsigned long) router->unknown);
+   for(size_t i = 0; i < router->count; i++) {
+      directive_route_t const *route = &router->routes[i];
+      printLog("%s{\"namespace\":\"%s\",\"name\":\"%s\",\"calls\":%lu,"
+               "\"cycles\":%lu,\"max_cycles\":%lu}",
+               (i > 0) ? "," : "", route->namespace, route->name,
+               (unsigned long) route->calls, (unsigned long) route->cycles,
+               (unsigned long) route->maxCycles);
+   }
+   printLog("]}\r\n");
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ROUTER_H
+#define ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ROUTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "directiveHeader.pb.h"
+#include "helpers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Handles one directive.
+ * @param payload the encoded directive payload.
+ * @param payloadSize the size of \p payload in bytes.
+ */
+typedef void (*directive_handler_t)(uint8_t const *payload, size_t payloadSize);
+
+/**
+ * A directive handler and what it has cost so far. Declare routes with
+ * DIRECTIVE_ROUTE().
+ */
+typedef struct {
+   char const *namespace;
+   char const *name;
+   directive_handler_t handler;
+   uint32_t calls;
+   uint32_t cycles;
+   uint32_t maxCycles;
+} directive_route_t;
+
+/**
+ * A table of routes, sorted by namespace and then by name as strcmp() orders
+ * them. Declare it with DIRECTIVE_ROUTER().
+ */
+typedef struct {
+   directive_route_t *routes;
+   size_t count;
+   uint32_t unknown;
+   bool checked;
+   bool sorted;
+} directive_router_t;
+
+#define DIRECTIVE_ROUTE(namespace, name, handler) { (namespace), (name), (handler), 0, 0, 0 }
+#define DIRECTIVE_ROUTER(routes) { (routes), ARRAY_SIZE(routes), 0, false, false }
+
+/**
+ * Checks that the routes are in order. Routes out of order are reported and
+ * then searched one by one rather than by binary search. Called at boot; the
+ * first search does it otherwise.
+ * @param router the routes to check.
+ */
+void DirectiveRouter_init(directive_router_t *router);
+
+/**
+ * Checks whether a directive has a route, without calling its handler.
+ * @param router the routes to search.
+ * @param header the header of the directive.
+ * @return true if DirectiveRouter_dispatch() would find a route.
+ */
+bool DirectiveRouter_accepts(directive_router_t *router, header_DirectiveHeaderProto const *header);
+
+/**
+ * Finds the route for a directive and calls its handler.
+ * @param router the routes to search.
+ * @param header the header of the directive.
+ * @param payload the encoded directive payload.
+ * @param payloadSize the size of \p payload in bytes.
+ * @return false if no route matches.
+ */
+bool DirectiveRouter_dispatch(
+   directive_router_t *router,
+   header_DirectiveHeaderProto const *header,
+   uint8_t const *payload,
+   size_t payloadSize);
+
+/**
+ * Prints the call counts and cycles of every route as a single line of JSON.
+ * Cycles are only counted when SAMPLE_CODEC_STATS is set.
+ * @param router the routes to print.
+ */
+void DirectiveRouter_print(directive_router_t const *router);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_ROUTER_H
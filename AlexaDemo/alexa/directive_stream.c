@@ -0,0 +1,241 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+
+#include "alexa_codec.h"
+#include "codec_stats.h"
+#include "directive_stream.h"
+#include "helpers.h"
+#include "pb.h"
+#include "pb_decode.h"
+
+// nanopb decodes a message in one blocking call, so it cannot be suspended
+// between fragments. Instead the tags and lengths of DirectiveParserProto and
+// its Directive submessage are walked here byte by byte. Only the header is
+// collected into the carry window and decoded as a unit; the payload is
+// copied directly to its destination and unknown fields are skipped. The
+// header comes before the payload on the wire, so a directive nobody handles
+// is recognized in time to skip its payload as well.
+
+#define MAX_VARINT_SIZE 10U
+
+static size_t fail(directive_stream_t *stream, char const *error)
+{
+   stream->state = DIRECTIVE_STREAM_ERROR;
+   stream->error = error;
+   return 0;
+}
+
+static void startField(directive_stream_t *stream, directive_stream_state_t state, size_t length)
+{
+   stream->fieldRemaining = length;
+   stream->state = (length > 0) ? state : DIRECTIVE_STREAM_TAG;
+}
+
+static size_t onTag(directive_stream_t *stream, uint32_t tag)
+{
+   stream->tag = tag;
+   switch((pb_wire_type_t) (tag & 0x07U)) {
+      case PB_WT_VARINT:
+         stream->state = DIRECTIVE_STREAM_VARINT;
+         break;
+      case PB_WT_64BIT:
+         startField(stream, DIRECTIVE_STREAM_SKIP, 8);
+         break;
+      case PB_WT_32BIT:
+         startField(stream, DIRECTIVE_STREAM_SKIP, 4);
+         break;
+      case PB_WT_STRING:
+         stream->state = DIRECTIVE_STREAM_LENGTH;
+         break;
+      default:
+         return fail(stream, "invalid wire type");
+   }
+   return 1;
+}
+
+static size_t onLength(directive_stream_t *stream, uint32_t length)
+{
+   uint32_t field = stream->tag >> 3;
+   size_t fieldStart = stream->position + 1;
+
+   if(stream->inDirective && length > stream->directiveEnd - fieldStart) {
+      return fail(stream, "submessage overflow");
+   }
+
+   if(!stream->inDirective) {
+      if(field == directive_DirectiveParserProto_directive_tag) {
+         stream->inDirective = true;
+         stream->directiveEnd = fieldStart + length;
+         stream->state = DIRECTIVE_STREAM_TAG;
+      }
+      else {
+         startField(stream, DIRECTIVE_STREAM_SKIP, length);
+      }
+   }
+   else if(field == directive_DirectiveParserProto_Directive_header_tag) {
+      if(length > sizeof(stream->carry)) {
+         return fail(stream, "header too long");
+      }
+      startField(stream, DIRECTIVE_STREAM_HEADER, length);
+      if(length == 0) {
+         memset(&stream->header, 0, sizeof(stream->header));
+      }
+   }
+   else if(field == directive_DirectiveParserProto_Directive_payload_tag) {
+      stream->payloadSize = 0;
+      if(stream->ignored) {
+         startField(stream, DIRECTIVE_STREAM_SKIP, length);
+      }
+      else if(length > sizeof(stream->payload)) {
+         return fail(stream, "payload too long");
+      }
+      else {
+         startField(stream, DIRECTIVE_STREAM_PAYLOAD, length);
+      }
+   }
+   else {
+      startField(stream, DIRECTIVE_STREAM_SKIP, length);
+   }
+   return 1;
+}
+
+// Collects one varint byte into the carry window and acts on it once complete.
+static size_t consumeVarintByte(directive_stream_t *stream, uint8_t byte)
+{
+   if(stream->carrySize >= MAX_VARINT_SIZE) {
+      return fail(stream, "varint overflow");
+   }
+   stream->carry[stream->carrySize++] = byte;
+   if(byte & 0x80U) {
+      return 1;
+   }
+
+   uint32_t value;
+   pb_istream_t carry = pb_istream_from_buffer(stream->carry, stream->carrySize);
+   stream->carrySize = 0;
+   if(!pb_decode_varint32(&carry, &value)) {
+      return fail(stream, PB_GET_ERROR(&carry));
+   }
+   if(stream->state == DIRECTIVE_STREAM_TAG) {
+      return onTag(stream, value);
+   }
+   return onLength(stream, value);
+}
+
+static size_t consume(directive_stream_t *stream, uint8_t const *data, size_t dataSize)
+{
+   size_t size = MIN(dataSize, stream->fieldRemaining);
+
+   switch(stream->state) {
+      case DIRECTIVE_STREAM_TAG:
+      case DIRECTIVE_STREAM_LENGTH:
+         return consumeVarintByte(stream, data[0]);
+
+      case DIRECTIVE_STREAM_VARINT:
+         if(!(data[0] & 0x80U)) {
+            stream->state = DIRECTIVE_STREAM_TAG;
+         }
+         return 1;
+
+      case DIRECTIVE_STREAM_HEADER:
+         memcpy(&stream->carry[stream->carrySize], data, size);
+         stream->carrySize += size;
+         stream->fieldRemaining -= size;
+         if(stream->fieldRemaining == 0) {
+            pb_istream_t header = pb_istream_from_buffer(stream->carry, stream->carrySize);
+            uint32_t start = CodecStats_start();
+            bool status = header_DirectiveHeaderProto_decode(&header, &stream->header);
+            CodecStats_finish(CODEC_STATS_DIRECTIVE_HEADER_DECODE, start, stream->carrySize, status);
+            stream->carrySize = 0;
+            if(!status) {
+               return fail(stream, PB_GET_ERROR(&header));
+            }
+            stream->ignored = stream->filter != NULL && !stream->filter(&stream->header);
+            stream->state = DIRECTIVE_STREAM_TAG;
+         }
+         return size;
+
+      case DIRECTIVE_STREAM_PAYLOAD:
+         memcpy(&stream->payload[stream->payloadSize], data, size);
+         stream->payloadSize += size;
+         // The copied bytes are accounted for below.
+         /* fall through */
+      case DIRECTIVE_STREAM_SKIP:
+         stream->fieldRemaining -= size;
+         if(stream->fieldRemaining == 0) {
+            stream->state = DIRECTIVE_STREAM_TAG;
+         }
+         return size;
+
+      default:
+         return 0;
+   }
+}
+
+void DirectiveStream_reset(directive_stream_t *stream, directive_stream_filter_t filter)
+{
+   stream->state = DIRECTIVE_STREAM_TAG;
+   stream->tag = 0;
+   stream->position = 0;
+   stream->fieldRemaining = 0;
+   stream->inDirective = false;
+   stream->directiveEnd = 0;
+   stream->carrySize = 0;
+   stream->error = NULL;
+   stream->filter = filter;
+   stream->ignored = false;
+   memset(&stream->header, 0, sizeof(stream->header));
+   stream->payloadSize = 0;
+}
+
+bool DirectiveStream_feed(directive_stream_t *stream, uint8_t const *data, size_t dataSize)
+{
+   while(dataSize > 0 && stream->state != DIRECTIVE_STREAM_ERROR) {
+      size_t size = dataSize;
+      if(stream->inDirective) {
+         if(stream->position == stream->directiveEnd) {
+            if(stream->state != DIRECTIVE_STREAM_TAG || stream->carrySize != 0) {
+               fail(stream, "submessage overflow");
+               break;
+            }
+            stream->inDirective = false;
+            continue;
+         }
+         size = MIN(size, stream->directiveEnd - stream->position);
+      }
+      size_t used = consume(stream, data, size);
+      stream->position += used;
+      data += used;
+      dataSize -= used;
+   }
+   return stream->state != DIRECTIVE_STREAM_ERROR;
+}
+
+bool DirectiveStream_finish(directive_stream_t *stream)
+{
+   if(stream->state == DIRECTIVE_STREAM_ERROR) {
+      return false;
+   }
+   if(stream->state != DIRECTIVE_STREAM_TAG || stream->carrySize != 0 ||
+      (stream->inDirective && stream->position != stream->directiveEnd))
+   {
+      fail(stream, "truncated directive");
+      return false;
+   }
+   return true;
+}
+
+char const *DirectiveStream_error(directive_stream_t const *stream)
+{
+   return stream->error ? stream->error : "(none)";
+}
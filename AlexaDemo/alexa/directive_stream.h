@@ -0,0 +1,117 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_STREAM_H
+#define ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "directiveHeader.pb.h"
+#include "directiveParser.pb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Bytes held back between fragments. Large enough for a whole encoded
+ * directive header, which is the only field that is decoded as a unit.
+ */
+#define DIRECTIVE_STREAM_CARRY_SIZE    header_DirectiveHeaderProto_size
+
+/**
+ * Largest directive payload accepted. Fragments of a streamed directive are
+ * not contiguous, so unlike a single-packet directive, whose payload is
+ * decoded as a view into the packet, the payload is gathered here.
+ */
+#define DIRECTIVE_STREAM_PAYLOAD_SIZE  2048U
+
+typedef enum {
+   DIRECTIVE_STREAM_TAG,
+   DIRECTIVE_STREAM_LENGTH,
+   DIRECTIVE_STREAM_VARINT,
+   DIRECTIVE_STREAM_HEADER,
+   DIRECTIVE_STREAM_PAYLOAD,
+   DIRECTIVE_STREAM_SKIP,
+   DIRECTIVE_STREAM_ERROR
+} directive_stream_state_t;
+
+/**
+ * Decides from its header whether a directive is wanted.
+ * @param header the decoded directive header.
+ * @return false to skip the payload instead of collecting it.
+ */
+typedef bool (*directive_stream_filter_t)(header_DirectiveHeaderProto const *header);
+
+/**
+ * Incremental decoder for a directive_DirectiveParserProto that arrives in
+ * fragments. Wire-level fields are parsed as their bytes come in; the header
+ * is decoded with pb_decode once it is complete and the payload is copied
+ * straight into place, so the encoded transaction is never buffered whole.
+ * @sa DirectiveStream_reset.
+ * @sa DirectiveStream_feed.
+ * @sa DirectiveStream_finish.
+ */
+typedef struct {
+   directive_stream_state_t state;
+   uint32_t tag;
+   size_t position;
+   size_t fieldRemaining;
+   bool inDirective;
+   size_t directiveEnd;
+   size_t carrySize;
+   uint8_t carry[DIRECTIVE_STREAM_CARRY_SIZE];
+   char const *error;
+   directive_stream_filter_t filter;
+   bool ignored;
+   header_DirectiveHeaderProto header;
+   size_t payloadSize;
+   uint8_t payload[DIRECTIVE_STREAM_PAYLOAD_SIZE];
+} directive_stream_t;
+
+/**
+ * Prepares the decoder for a new transaction.
+ * @param stream the decoder to reset.
+ * @param filter called once the header is decoded, or NULL to keep every
+ * directive. A payload that follows a rejected header is skipped rather than
+ * copied, however large it is, and ignored is set.
+ */
+void DirectiveStream_reset(directive_stream_t *stream, directive_stream_filter_t filter);
+
+/**
+ * Decodes the next chunk of an encoded directive.
+ * @param stream the decoder.
+ * @param data the chunk, which does not need to be kept after the call returns.
+ * @param dataSize length of \p data in bytes.
+ * @return false once the encoded data has been found to be invalid.
+ */
+bool DirectiveStream_feed(directive_stream_t *stream, uint8_t const *data, size_t dataSize);
+
+/**
+ * Checks that the decoder stopped on a field boundary with a complete directive.
+ * @param stream the decoder.
+ * @return true if \p stream holds a fully decoded header and payload.
+ */
+bool DirectiveStream_finish(directive_stream_t *stream);
+
+/**
+ * Returns a readable reason for the last decode failure.
+ * @param stream the decoder.
+ */
+char const *DirectiveStream_error(directive_stream_t const *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_DIRECTIVE_STREAM_H
@@ -15,15 +15,15 @@ extern "C" {
 
 /* Struct definitions */
 typedef struct _header_EventHeaderProto {
-    char namespace[32];
-    char name[32];
-    char messageId[32];
+    pb_view_t namespace;
+    pb_view_t name;
+    pb_view_t messageId;
 } header_EventHeaderProto;
 
 
 /* Initializer values for message structs */
-#define header_EventHeaderProto_init_default     {"", "", ""}
-#define header_EventHeaderProto_init_zero        {"", "", ""}
+#define header_EventHeaderProto_init_default     {{NULL, 0}, {NULL, 0}, {NULL, 0}}
+#define header_EventHeaderProto_init_zero        {{NULL, 0}, {NULL, 0}, {NULL, 0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define header_EventHeaderProto_namespace_tag    1
@@ -32,9 +32,9 @@ typedef struct _header_EventHeaderProto {
 
 /* Struct field encoding specification for nanopb */
 #define header_EventHeaderProto_FIELDLIST(X, a) \
-X(a, STATIC,   SINGULAR, STRING,   namespace,         1) \
-X(a, STATIC,   SINGULAR, STRING,   name,              2) \
-X(a, STATIC,   SINGULAR, STRING,   messageId,         3)
+X(a, STATIC,   SINGULAR, VIEW,     namespace,         1) \
+X(a, STATIC,   SINGULAR, VIEW,     name,              2) \
+X(a, STATIC,   SINGULAR, VIEW,     messageId,         3)
 #define header_EventHeaderProto_CALLBACK NULL
 #define header_EventHeaderProto_DEFAULT NULL
 
@@ -44,7 +44,7 @@ extern const pb_msgdesc_t header_EventHeaderProto_msg;
 #define header_EventHeaderProto_fields &header_EventHeaderProto_msg
 
 /* Maximum encoded size of messages (where known) */
-#define header_EventHeaderProto_size             99
+/* header_EventHeaderProto_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
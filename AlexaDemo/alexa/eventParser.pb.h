@@ -15,11 +15,10 @@ extern "C" {
 #endif
 
 /* Struct definitions */
-typedef PB_BYTES_ARRAY_T(2048) event_EventParserProto_Event_payload_t;
 typedef struct _event_EventParserProto_Event {
     bool has_header;
     header_EventHeaderProto header;
-    event_EventParserProto_Event_payload_t payload;
+    pb_view_t payload;
 } event_EventParserProto_Event;
 
 typedef struct _event_EventParserProto {
@@ -30,9 +29,9 @@ typedef struct _event_EventParserProto {
 
 /* Initializer values for message structs */
 #define event_EventParserProto_init_default      {false, event_EventParserProto_Event_init_default}
-#define event_EventParserProto_Event_init_default {false, header_EventHeaderProto_init_default, {0, {0}}}
+#define event_EventParserProto_Event_init_default {false, header_EventHeaderProto_init_default, {NULL, 0}}
 #define event_EventParserProto_init_zero         {false, event_EventParserProto_Event_init_zero}
-#define event_EventParserProto_Event_init_zero   {false, header_EventHeaderProto_init_zero, {0, {0}}}
+#define event_EventParserProto_Event_init_zero   {false, header_EventHeaderProto_init_zero, {NULL, 0}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define event_EventParserProto_Event_payload_tag 2
@@ -48,7 +47,7 @@ X(a, STATIC,   OPTIONAL, MESSAGE,  event,             1)
 
 #define event_EventParserProto_Event_FIELDLIST(X, a) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  header,            1) \
-X(a, STATIC,   SINGULAR, BYTES,    payload,           2)
+X(a, STATIC,   SINGULAR, VIEW,     payload,           2)
 #define event_EventParserProto_Event_CALLBACK NULL
 #define event_EventParserProto_Event_DEFAULT NULL
 #define event_EventParserProto_Event_header_MSGTYPE header_EventHeaderProto
@@ -61,8 +60,8 @@ extern const pb_msgdesc_t event_EventParserProto_Event_msg;
 #define event_EventParserProto_Event_fields &event_EventParserProto_Event_msg
 
 /* Maximum encoded size of messages (where known) */
-#define event_EventParserProto_size              2155
-#define event_EventParserProto_Event_size        2152
+/* event_EventParserProto_size depends on runtime parameters */
+/* event_EventParserProto_Event_size depends on runtime parameters */
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,112 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include "heap_guard.h"
+
+#if SAMPLE_HEAP_GUARD
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "em_device.h"
+
+#include "app.h"
+
+// The linker sends every call to malloc() and friends here once the project
+// links with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free, and
+// the real allocator stays reachable as __real_malloc() and so on. Nothing in
+// here may print, since printf() can allocate itself.
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+// The __real_ names only exist when the matching --wrap option is given.
+// HeapGuard_initComplete() reads this table, so a build without the options
+// fails to link instead of running with a guard that sees nothing.
+static struct {
+   void *(*malloc)(size_t size);
+   void *(*calloc)(size_t count, size_t size);
+   void *(*realloc)(void *ptr, size_t size);
+   void (*free)(void *ptr);
+} const volatile realAllocator = {
+   __real_malloc, __real_calloc, __real_realloc, __real_free
+};
+
+static bool initComplete;
+static uint32_t initAllocations;
+static uint32_t steadyStateAllocations;
+static uint32_t steadyStateFrees;
+static void *firstSteadyStateCaller;
+
+static void countAllocation(void *caller)
+{
+   if(!initComplete) {
+      initAllocations++;
+      return;
+   }
+   if(steadyStateAllocations++ == 0) {
+      firstSteadyStateCaller = caller;
+   }
+   // Halts under a debugger; without one the breakpoint escalates to a
+   // HardFault. If a debugger resumes, reset rather than run on the heap.
+   __BKPT(0);
+   NVIC_SystemReset();
+}
+
+void *__wrap_malloc(size_t size)
+{
+   countAllocation(__builtin_return_address(0));
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+   countAllocation(__builtin_return_address(0));
+   return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   countAllocation(__builtin_return_address(0));
+   return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+   if(initComplete && ptr != NULL) {
+      steadyStateFrees++;
+   }
+   __real_free(ptr);
+}
+
+void HeapGuard_initComplete(void)
+{
+   (void) realAllocator.malloc;
+   initComplete = true;
+}
+
+uint32_t HeapGuard_getSteadyStateAllocations(void)
+{
+   return steadyStateAllocations;
+}
+
+void HeapGuard_print(void)
+{
+   printLog("{\"heap_guard\":1,\"init_allocations\":%lu,\"steady_state_allocations\":%lu,"
+            "\"steady_state_frees\":%lu,\"first_caller\":\"%p\"}\r\n",
+            (unsigned long) initAllocations, (unsigned long) steadyStateAllocations,
+            (unsigned long) steadyStateFrees, firstSteadyStateCaller);
+}
+
+#endif
@@ -0,0 +1,63 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_HEAP_GUARD_H
+#define ALEXA_GADGETS_SAMPLE_CODE_HEAP_GUARD_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SAMPLE_HEAP_GUARD
+
+/**
+ * Marks the end of initialization. From here on every heap allocation is a
+ * fault: it halts at a breakpoint with a debugger attached and raises a
+ * HardFault without one.
+ */
+void HeapGuard_initComplete(void);
+
+/**
+ * Returns the heap allocations made since HeapGuard_initComplete().
+ */
+uint32_t HeapGuard_getSteadyStateAllocations(void);
+
+/**
+ * Prints the allocation counts as a single line of JSON.
+ */
+void HeapGuard_print(void);
+
+#else
+
+static inline void HeapGuard_initComplete(void)
+{
+}
+
+static inline uint32_t HeapGuard_getSteadyStateAllocations(void)
+{
+   return 0;
+}
+
+static inline void HeapGuard_print(void)
+{
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_HEAP_GUARD_H
@@ -13,25 +13,24 @@
 #include "common.h"
 #include "helpers.h"
 #include "app.h"
+#include "packet_pool.h"
 
 packet_list_t *PacketList_addToTail(packet_list_t *const list, packet_t const *const packet) 
 {
    if(packet == NULL) return list;
    if(packet->data == NULL)
       return list;
-   packet_list_t *node = malloc(sizeof(packet_list_t));
+   packet_list_t *node = PacketPool_alloc(sizeof(packet_list_t));
    if(!node) {
       return list;
    }
    node->packet = *packet;
    node->next = NULL;
+   node->tail = node;
 
-   packet_list_t *tail = list;
-   while(tail && tail->next) {
-      tail = tail->next;
-   }
-   if(tail) {
-      tail->next = node;
+   if(list) {
+      list->tail->next = node;
+      list->tail = node;
       return list;
    }
    else {
@@ -44,12 +43,9 @@ packet_list_t *PacketList_appendList(packet_list_t *dst, packet_list_t *src)
    if(src == NULL) return dst;
    if(dst == NULL) return src;
 
-   packet_list_t *tail = dst;
-   while(tail->next != NULL) {
-      tail = tail->next;
-   }
    // Append the src list.
-   tail->next = src;
+   dst->tail->next = src;
+   dst->tail = src->tail;
    return dst;
 }
 
@@ -57,9 +53,8 @@ void PacketList_freeList(packet_list_t *list) {
    while(list) {
       packet_list_t *temp = list;
       list = list->next;
-      if(temp->packet.data)
-         free(temp->packet.data);
-      free(temp);
+      PacketPool_free(temp->packet.data);
+      PacketPool_free(temp);
    }
 }
 
@@ -85,7 +80,7 @@ void PacketList_PrintAll(packet_list_t const *const list) {
 
 void freePacket(packet_t *packet) {
    if(packet->data != NULL) {
-      free(packet->data);
+      PacketPool_free(packet->data);
       packet->data = NULL;
       packet->dataSize = 0;
    }
@@ -108,7 +103,7 @@ size_t streamToIndex(stream_id_t streamId) {
       case OTA_STREAM:
          return 2;
       default:
-         return -1;
+         return STREAM_INDEX_INVALID;
    }
 }
 
@@ -19,11 +19,13 @@ extern "C" {
 #endif
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define ARRAY_SIZE(a) (sizeof((a))/sizeof((a)[0]))
+#define STREAM_INDEX_INVALID ((size_t) -1)
 
 /**
  * Represents a single packet that is exchanged between Echo device and the gadget.
- * The data member need to be malloced on the heap and can be freed using freePacket().
+ * The data member is allocated with PacketPool_alloc() and can be freed using freePacket().
  * @sa freePacket().
  */
 typedef struct {
@@ -32,7 +34,8 @@ typedef struct {
 } packet_t;
 
 /**
- * A linked list of packets.
+ * A linked list of packets. The tail member is only kept up to date on the
+ * head node, so appending does not have to walk the list.
  * @sa PacketList_addToTail.
  * @sa PacketList_appendList.
  * @sa PacketList_PrintAll.
@@ -41,6 +44,7 @@ typedef struct {
 typedef struct packet_list_s {
     packet_t packet;
     struct packet_list_s *next;
+    struct packet_list_s *tail;
 } packet_list_t;
 
 /**
@@ -49,7 +53,7 @@ typedef struct packet_list_s {
  * pointed to by \p list.
  * @param packet a pointer to a packet structure. This can be allocated on the stack.
  * A copy of the content of the packet structure is duplicated and saved in the list.
- * The data pointer of the packet structure must be malloced on the heap and it is not duplicated.
+ * The data pointer of the packet structure must come from PacketPool_alloc() and it is not duplicated.
  * @return  returns a pointer to the new list head if a new list has been created, or the same value as
  * \p list value if the a new \p packet was appended. If \p packet is NULL, the value of \p list is returned as is.
  */
@@ -98,7 +102,7 @@ void printPacket(packet_t const *packet, int indentSize);
 /**
  * Maps a Gadgets stream id to a continuous array index.
  * @param streamId value as enumerated in stream_id_t.
- * @return the array index value or -1 if the \p streamId value is not valid.
+ * @return the array index value or STREAM_INDEX_INVALID if the \p streamId value is not valid.
  */
 size_t streamToIndex(stream_id_t streamId);
 
@@ -0,0 +1,45 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "message_scratch.h"
+#include "pb.h"
+
+// A struct that grows past the budget after a .proto change fails the build
+// here rather than quietly taking more RAM.
+PB_STATIC_ASSERT(sizeof(alexaDiscovery_DiscoverResponseEventProto) <= SAMPLE_MESSAGE_SCRATCH_SIZE,
+                 DISCOVER_RESPONSE_EXCEEDS_SAMPLE_MESSAGE_SCRATCH_SIZE)
+PB_STATIC_ASSERT(sizeof(message_scratch_t) <= SAMPLE_MESSAGE_SCRATCH_SIZE,
+                 MESSAGE_SCRATCH_EXCEEDS_SAMPLE_MESSAGE_SCRATCH_SIZE)
+
+static message_scratch_t scratch;
+static bool scratchInUse;
+
+message_scratch_t *MessageScratch_acquire(void)
+{
+   if(scratchInUse) {
+      return NULL;
+   }
+   scratchInUse = true;
+   return &scratch;
+}
+
+void MessageScratch_release(message_scratch_t *released)
+{
+   if(released != NULL) {
+      assert(released == &scratch && scratchInUse);
+      scratchInUse = false;
+   }
+}
@@ -0,0 +1,46 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_MESSAGE_SCRATCH_H
+#define ALEXA_GADGETS_SAMPLE_CODE_MESSAGE_SCRATCH_H
+
+#include "alexaDiscoveryDiscoverResponseEvent.pb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Work area for message structs too large for the stack. Only one message is
+ * built or decoded in it at a time, so the members share their storage. Add a
+ * member for each such message; config.h sets the budget the area must fit.
+ */
+typedef union {
+   alexaDiscovery_DiscoverResponseEventProto discoverResponse;
+} message_scratch_t;
+
+/**
+ * Claims the work area.
+ * @return the area, or NULL if it is already claimed.
+ */
+message_scratch_t *MessageScratch_acquire(void);
+
+/**
+ * Gives the work area back.
+ * @param scratch the area returned by MessageScratch_acquire(), or NULL.
+ */
+void MessageScratch_release(message_scratch_t *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_MESSAGE_SCRATCH_H
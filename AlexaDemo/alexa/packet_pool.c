@@ -0,0 +1,154 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "app.h"
+#include "common.h"
+#include "helpers.h"
+#include "packet_pool.h"
+
+// Each pool is a static array of equal blocks. A free block holds the link to
+// the next free one; blocks that were never handed out are taken in order
+// from the end of the array, so the pools need no initialization.
+typedef union pool_block_u {
+   union pool_block_u *next;
+   uint64_t align;
+} pool_block_t;
+
+#define POOL_BLOCK_UNITS(size) (((size) + sizeof(pool_block_t) - 1) / sizeof(pool_block_t))
+
+#define NODE_BLOCK_UNITS      POOL_BLOCK_UNITS(sizeof(packet_list_t))
+#define SHORT_BLOCK_UNITS     POOL_BLOCK_UNITS(MAX(PROTOCOL_VERSION_PACKET_SIZE, ADV_DATA_LEN))
+#define FRAGMENT_BLOCK_UNITS  POOL_BLOCK_UNITS(SAMPLE_MAX_ATT_MTU)
+
+static pool_block_t nodeBlocks[SAMPLE_PACKET_POOL_NODES * NODE_BLOCK_UNITS];
+static pool_block_t shortBlocks[SAMPLE_PACKET_POOL_SHORT_PACKETS * SHORT_BLOCK_UNITS];
+static pool_block_t fragmentBlocks[SAMPLE_PACKET_POOL_FRAGMENTS * FRAGMENT_BLOCK_UNITS];
+
+typedef struct {
+   char const *name;
+   pool_block_t *start;
+   pool_block_t *end;
+   size_t blockUnits;
+   pool_block_t *freeList;
+   pool_block_t *unused;
+   size_t inUse;
+   size_t highWater;
+   uint32_t failures;
+} pool_t;
+
+#define POOL(name, blocks, units) \
+   { (name), (blocks), (blocks) + ARRAY_SIZE(blocks), (units), NULL, (blocks), 0, 0, 0 }
+
+static pool_t pools[PACKET_POOL_COUNT] = {
+   [PACKET_POOL_NODE]     = POOL("node", nodeBlocks, NODE_BLOCK_UNITS),
+   [PACKET_POOL_SHORT]    = POOL("short", shortBlocks, SHORT_BLOCK_UNITS),
+   [PACKET_POOL_FRAGMENT] = POOL("fragment", fragmentBlocks, FRAGMENT_BLOCK_UNITS),
+};
+
+static pool_block_t *takeBlock(pool_t *pool)
+{
+   pool_block_t *block = pool->freeList;
+   if(block != NULL) {
+      pool->freeList = block->next;
+   }
+   else if(pool->unused < pool->end) {
+      block = pool->unused;
+      pool->unused += pool->blockUnits;
+   }
+   else {
+      return NULL;
+   }
+
+   pool->inUse++;
+   pool->highWater = MAX(pool->highWater, pool->inUse);
+   return block;
+}
+
+void *PacketPool_alloc(size_t size)
+{
+   size_t units = POOL_BLOCK_UNITS(size);
+   pool_t *fitting = NULL;
+
+   for(size_t i = 0; i < PACKET_POOL_COUNT; i++) {
+      pool_t *pool = &pools[i];
+      if(units > pool->blockUnits) {
+         continue;
+      }
+      if(fitting == NULL) {
+         fitting = pool;
+      }
+      pool_block_t *block = takeBlock(pool);
+      if(block != NULL) {
+         return block;
+      }
+   }
+
+   if(fitting != NULL) {
+      fitting->failures++;
+   }
+   printLog("PacketPool: no block for %u bytes\n", size);
+   return NULL;
+}
+
+void PacketPool_free(void *ptr)
+{
+   pool_block_t *block = ptr;
+   if(block == NULL) {
+      return;
+   }
+
+   for(size_t i = 0; i < PACKET_POOL_COUNT; i++) {
+      pool_t *pool = &pools[i];
+      if(block >= pool->start && block < pool->end) {
+         assert((size_t) (block - pool->start) % pool->blockUnits == 0);
+         block->next = pool->freeList;
+         pool->freeList = block;
+         pool->inUse--;
+         return;
+      }
+   }
+   assert(false);
+}
+
+size_t PacketPool_getInUse(packet_pool_t pool)
+{
+   return pools[pool].inUse;
+}
+
+size_t PacketPool_getHighWater(packet_pool_t pool)
+{
+   return pools[pool].highWater;
+}
+
+uint32_t PacketPool_getFailures(packet_pool_t pool)
+{
+   return pools[pool].failures;
+}
+
+void PacketPool_print(void)
+{
+   printLog("{\"packet_pools\":1,\"pools\":[");
+   for(size_t i = 0; i < PACKET_POOL_COUNT; i++) {
+      pool_t const *pool = &pools[i];
+      printLog("%s{\"pool\":\"%s\",\"block_size\":%u,\"blocks\":%u,\"in_use\":%u,"
+               "\"high_water\":%u,\"failures\":%lu}",
+               (i > 0) ? "," : "", pool->name,
+               (unsigned) (pool->blockUnits * sizeof(pool_block_t)),
+               (unsigned) ((pool->end - pool->start) / pool->blockUnits),
+               (unsigned) pool->inUse, (unsigned) pool->highWater,
+               (unsigned long) pool->failures);
+   }
+   printLog("]}\r\n");
+}
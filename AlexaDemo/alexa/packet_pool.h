@@ -0,0 +1,76 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_PACKET_POOL_H
+#define ALEXA_GADGETS_SAMPLE_CODE_PACKET_POOL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The block sizes packet buffers and list nodes are allocated in, smallest
+ * first. The number of blocks in each is set in config.h.
+ */
+typedef enum {
+   PACKET_POOL_NODE,       // packet_list_t nodes.
+   PACKET_POOL_SHORT,      // ACKs, the protocol version and advertising data.
+   PACKET_POOL_FRAGMENT,   // a packet of up to SAMPLE_MAX_ATT_MTU.
+   PACKET_POOL_COUNT
+} packet_pool_t;
+
+/**
+ * Allocates a block from the smallest pool that has one free and is large
+ * enough. Blocks are never split or merged, so the time taken does not
+ * depend on what was allocated before.
+ * @param size the bytes needed.
+ * @return the block, or NULL if no pool can supply one.
+ */
+void *PacketPool_alloc(size_t size);
+
+/**
+ * Returns a block to its pool.
+ * @param ptr a block from PacketPool_alloc(), or NULL.
+ */
+void PacketPool_free(void *ptr);
+
+/**
+ * Returns the blocks of a pool that are allocated now.
+ * @param pool the pool.
+ */
+size_t PacketPool_getInUse(packet_pool_t pool);
+
+/**
+ * Returns the most blocks of a pool in use at the same time since boot.
+ * @param pool the pool.
+ */
+size_t PacketPool_getHighWater(packet_pool_t pool);
+
+/**
+ * Returns how often a request that fits a pool was refused, because that pool
+ * and every larger one were exhausted.
+ * @param pool the smallest pool the request fitted.
+ */
+uint32_t PacketPool_getFailures(packet_pool_t pool);
+
+/**
+ * Prints the usage of every pool as a single line of JSON.
+ */
+void PacketPool_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_PACKET_POOL_H
@@ -53,6 +53,12 @@
  * the string processing slightly and slightly increases code size. */
 /* #define PB_VALIDATE_UTF8 1 */
 
+/* Give every message descriptor a constant tag to field lookup table, so
+ * the decoder jumps straight to the field for each tag instead of
+ * searching the descriptor. Costs one byte per tag number up to the
+ * highest tag, plus 4 * sizeof(pb_size_t) per field. */
+#define PB_FIELD_TAG_INDEX 1
+
 /******************************************************************
  * You usually don't need to change anything below this line.     *
  * Feel free to look around and use the defined macros, though.   *
@@ -229,8 +235,14 @@ typedef uint_least8_t pb_type_t;
  * pb_byte_t[data_size] rather than pb_bytes_array_t. */
 #define PB_LTYPE_FIXED_LENGTH_BYTES 0x0BU
 
+/* String or byte array referenced in place through a pb_view_t.
+ * data_size is sizeof(pb_view_t). The data is not copied into the message:
+ * when encoding it is owned by the caller, and when decoding the view
+ * points into the input buffer, which has to outlive the message. */
+#define PB_LTYPE_VIEW 0x0CU
+
 /* Number of declared LTYPES */
-#define PB_LTYPES_COUNT 0x0CU
+#define PB_LTYPES_COUNT 0x0DU
 #define PB_LTYPE_MASK 0x0FU
 
 /**** Field repetition rules ****/
@@ -279,6 +291,16 @@ typedef struct pb_istream_s pb_istream_t;
 typedef struct pb_ostream_s pb_ostream_t;
 typedef struct pb_field_iter_s pb_field_iter_t;
 
+#ifdef PB_FIELD_TAG_INDEX
+/* Iterator position of a field, used by the tag lookup table. */
+typedef struct pb_field_pos_s {
+    pb_size_t index;
+    pb_size_t field_info_index;
+    pb_size_t submessage_index;
+    pb_size_t required_field_index;
+} pb_field_pos_t;
+#endif
+
 /* This structure is used in auto-generated constants
  * to specify struct fields.
  */
@@ -291,6 +313,12 @@ struct pb_msgdesc_s {
     const pb_byte_t *default_value;
 
     bool (*field_callback)(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_iter_t *field);
+
+#ifdef PB_FIELD_TAG_INDEX
+    pb_size_t max_tag;
+    const pb_byte_t *tag_index;      /* Field index + 1 for each tag, 0 if unknown */
+    const pb_field_pos_t *field_pos; /* Iterator position of each field */
+#endif
 } pb_packed;
 PB_PACKED_STRUCT_END
 
@@ -343,6 +371,16 @@ struct pb_bytes_array_s {
 };
 typedef struct pb_bytes_array_s pb_bytes_array_t;
 
+/* This structure is used for PB_LTYPE_VIEW fields.
+ * It points at data that must stay valid while the message is in use.
+ * Strings are not null terminated; size gives their length.
+ */
+struct pb_view_s {
+    const pb_byte_t *bytes;
+    pb_size_t size;
+};
+typedef struct pb_view_s pb_view_t;
+
 /* This structure is used for giving the callback function.
  * It is stored in the message structure and filled in by the method that
  * calls pb_decode.
@@ -463,6 +501,7 @@ struct pb_extension_s {
 
 /* Binding of a message field set into a specific structure */
 #define PB_BIND(msgname, structname, width) \
+    PB_BIND_TAG_INDEX(msgname, structname, width) \
     const uint32_t structname ## _field_info[] PB_PROGMEM = \
     { \
         msgname ## _FIELDLIST(PB_GEN_FIELD_INFO_ ## width, structname) \
@@ -480,11 +519,86 @@ struct pb_extension_s {
        structname ## _submsg_info, \
        msgname ## _DEFAULT, \
        msgname ## _CALLBACK, \
+       PB_TAG_INDEX_INIT(structname) \
     }; \
     msgname ## _FIELDLIST(PB_GEN_FIELD_INFO_ASSERT_ ## width, structname)
 
 #define PB_GEN_FIELD_COUNT(structname, atype, htype, ltype, fieldname, tag) +1
 
+#ifdef PB_FIELD_TAG_INDEX
+/* The tag lookup table is computed by the compiler. Each helper struct has
+ * one member per field, named after its tag and sized by how much that
+ * field advances one of the iterator indexes, so the offset of a member is
+ * the index value at that field. */
+#define PB_BIND_TAG_INDEX(msgname, structname, width) \
+    struct structname ## _pb_index { \
+        msgname ## _FIELDLIST(PB_GEN_INDEX_FIELD, structname) \
+        char pb_end; \
+    }; \
+    struct structname ## _pb_words { \
+        msgname ## _FIELDLIST(PB_GEN_INDEX_WORDS_ ## width, structname) \
+        char pb_end; \
+    }; \
+    struct structname ## _pb_submsgs { \
+        msgname ## _FIELDLIST(PB_GEN_INDEX_SUBMSG, structname) \
+        char pb_end; \
+    }; \
+    struct structname ## _pb_required { \
+        msgname ## _FIELDLIST(PB_GEN_INDEX_REQUIRED, structname) \
+        char pb_end; \
+    }; \
+    PB_STATIC_ASSERT(offsetof(struct structname ## _pb_index, pb_end) < 255, TAG_INDEX_TOO_MANY_FIELDS_ ## structname) \
+    static const pb_byte_t structname ## _tag_index[] = \
+    { \
+        0, \
+        msgname ## _FIELDLIST(PB_GEN_TAG_INDEX, structname) \
+    }; \
+    static const pb_field_pos_t structname ## _field_pos[] = \
+    { \
+        msgname ## _FIELDLIST(PB_GEN_FIELD_POS, structname) \
+        {0, 0, 0, 0} \
+    };
+
+#define PB_TAG_INDEX_INIT(structname) \
+       (pb_size_t)(sizeof(structname ## _tag_index) - 1), \
+       structname ## _tag_index, \
+       structname ## _field_pos,
+
+#define PB_GEN_INDEX_FIELD(structname, atype, htype, ltype, fieldname, tag) \
+    char f ## tag;
+
+#define PB_GEN_INDEX_WORDS_1(structname, atype, htype, ltype, fieldname, tag) char f ## tag[1];
+#define PB_GEN_INDEX_WORDS_2(structname, atype, htype, ltype, fieldname, tag) char f ## tag[2];
+#define PB_GEN_INDEX_WORDS_4(structname, atype, htype, ltype, fieldname, tag) char f ## tag[4];
+#define PB_GEN_INDEX_WORDS_8(structname, atype, htype, ltype, fieldname, tag) char f ## tag[8];
+#define PB_GEN_INDEX_WORDS_AUTO(structname, atype, htype, ltype, fieldname, tag) \
+    char f ## tag[PB_FIELDINFO_WIDTH_AUTO(atype, htype, ltype)];
+
+#define PB_GEN_INDEX_SUBMSG(structname, atype, htype, ltype, fieldname, tag) \
+    char f ## tag[1 + PB_LTYPE_IS_SUBMSG(PB_LTYPE_MAP_ ## ltype)];
+
+#define PB_GEN_INDEX_REQUIRED(structname, atype, htype, ltype, fieldname, tag) \
+    char f ## tag[1 + (PB_HTYPE_ ## htype == PB_HTYPE_REQUIRED)];
+
+#define PB_GEN_INDEX_OFFSET(structname, kind, tag) \
+    offsetof(struct structname ## _pb_ ## kind, f ## tag)
+
+#define PB_GEN_TAG_INDEX(structname, atype, htype, ltype, fieldname, tag) \
+    [tag] = (pb_byte_t)((PB_LTYPE_MAP_ ## ltype == PB_LTYPE_EXTENSION) ? 0 : \
+                        PB_GEN_INDEX_OFFSET(structname, index, tag) + 1),
+
+#define PB_GEN_FIELD_POS(structname, atype, htype, ltype, fieldname, tag) \
+    { \
+        (pb_size_t)PB_GEN_INDEX_OFFSET(structname, index, tag), \
+        (pb_size_t)PB_GEN_INDEX_OFFSET(structname, words, tag), \
+        (pb_size_t)(PB_GEN_INDEX_OFFSET(structname, submsgs, tag) - PB_GEN_INDEX_OFFSET(structname, index, tag)), \
+        (pb_size_t)(PB_GEN_INDEX_OFFSET(structname, required, tag) - PB_GEN_INDEX_OFFSET(structname, index, tag)) \
+    },
+#else
+#define PB_BIND_TAG_INDEX(msgname, structname, width)
+#define PB_TAG_INDEX_INIT(structname)
+#endif
+
 #define PB_GEN_FIELD_INFO_1(structname, atype, htype, ltype, fieldname, tag) \
     PB_GEN_FIELD_INFO(1, structname, atype, htype, ltype, fieldname, tag)
 
@@ -638,6 +752,7 @@ struct pb_extension_s {
 #define PB_SUBMSG_INFO_UINT64(t)
 #define PB_SUBMSG_INFO_EXTENSION(t)
 #define PB_SUBMSG_INFO_FIXED_LENGTH_BYTES(t)
+#define PB_SUBMSG_INFO_VIEW(t)
 #define PB_SUBMSG_DESCRIPTOR(t)    &(t ## _msg),
 
 /* The field descriptors use a variable width format, with width of either
@@ -755,6 +870,7 @@ struct pb_extension_s {
 #define PB_FIELDINFO_WIDTH_UINT64    1
 #define PB_FIELDINFO_WIDTH_EXTENSION 1
 #define PB_FIELDINFO_WIDTH_FIXED_LENGTH_BYTES 2
+#define PB_FIELDINFO_WIDTH_VIEW      2
 #else
 #define PB_FIELDINFO_WIDTH_AUTO(atype, htype, ltype) PB_FIELDINFO_WIDTH
 #endif
@@ -781,6 +897,7 @@ struct pb_extension_s {
 #define PB_LTYPE_MAP_UINT64             PB_LTYPE_UVARINT
 #define PB_LTYPE_MAP_EXTENSION          PB_LTYPE_EXTENSION
 #define PB_LTYPE_MAP_FIXED_LENGTH_BYTES PB_LTYPE_FIXED_LENGTH_BYTES
+#define PB_LTYPE_MAP_VIEW               PB_LTYPE_VIEW
 
 /* These macros are used for giving out error messages.
  * They are mostly a debugging aid; the main error information
@@ -189,6 +189,26 @@ bool pb_field_iter_find(pb_field_iter_t *iter, uint32_t tag)
     {
         return true; /* Nothing to do, correct field already. */
     }
+#ifdef PB_FIELD_TAG_INDEX
+    else
+    {
+        const pb_msgdesc_t *desc = iter->descriptor;
+        const pb_field_pos_t *pos;
+        pb_size_t field = (tag <= desc->max_tag) ? desc->tag_index[tag] : 0;
+
+        if (field == 0)
+        {
+            return false;
+        }
+
+        pos = &desc->field_pos[field - 1];
+        iter->index = pos->index;
+        iter->field_info_index = pos->field_info_index;
+        iter->submessage_index = pos->submessage_index;
+        iter->required_field_index = pos->required_field_index;
+        return load_descriptor_values(iter);
+    }
+#else
     else
     {
         pb_size_t start = iter->index;
@@ -220,6 +240,7 @@ bool pb_field_iter_find(pb_field_iter_t *iter, uint32_t tag)
         (void)load_descriptor_values(iter);
         return false;
     }
+#endif
 }
 
 bool pb_default_field_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_t *field)
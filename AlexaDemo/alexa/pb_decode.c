@@ -23,6 +23,7 @@
 
 static bool checkreturn buf_read(pb_istream_t *stream, pb_byte_t *buf, size_t count);
 static bool checkreturn pb_decode_varint32_eof(pb_istream_t *stream, uint32_t *dest, bool *eof);
+static bool checkreturn pb_decode_varint32_buffer(pb_istream_t *stream, uint32_t *dest);
 static bool checkreturn read_raw_value(pb_istream_t *stream, pb_wire_type_t wire_type, pb_byte_t *buf, size_t *size);
 static bool checkreturn decode_basic_field(pb_istream_t *stream, pb_field_iter_t *field);
 static bool checkreturn decode_static_field(pb_istream_t *stream, pb_wire_type_t wire_type, pb_field_iter_t *field);
@@ -33,6 +34,7 @@ static bool checkreturn default_extension_decoder(pb_istream_t *stream, pb_exten
 static bool checkreturn decode_extension(pb_istream_t *stream, uint32_t tag, pb_wire_type_t wire_type, pb_field_iter_t *iter);
 static bool checkreturn find_extension_field(pb_field_iter_t *iter);
 static bool pb_message_set_to_defaults(pb_field_iter_t *iter);
+static bool pb_message_clear_presence(pb_field_iter_t *iter);
 static bool checkreturn pb_dec_bool(pb_istream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_dec_varint(pb_istream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_dec_fixed(pb_istream_t *stream, const pb_field_iter_t *field);
@@ -40,6 +42,7 @@ static bool checkreturn pb_dec_bytes(pb_istream_t *stream, const pb_field_iter_t
 static bool checkreturn pb_dec_string(pb_istream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_dec_submessage(pb_istream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_dec_fixed_length_bytes(pb_istream_t *stream, const pb_field_iter_t *field);
+static bool checkreturn pb_dec_view(pb_istream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_skip_varint(pb_istream_t *stream);
 static bool checkreturn pb_skip_string(pb_istream_t *stream);
 
@@ -58,6 +61,14 @@ static void pb_release_single_field(pb_field_iter_t *field);
 #define pb_uint64_t uint64_t
 #endif
 
+/* Varints in memory buffers are decoded a word at a time where the target
+ * is little endian and has a count-trailing-zeros builtin (RBIT+CLZ on
+ * Cortex-M33, TZCNT/BSF on x86). */
+#if !defined(PB_NO_VARINT_WORD_READ) && defined(__GNUC__) && \
+    defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PB_VARINT_WORD_READ 1
+#endif
+
 typedef struct {
     uint32_t bitfield[(PB_MAX_REQUIRED_FIELDS + 31) / 32];
 } pb_fields_seen_t;
@@ -166,11 +177,78 @@ pb_istream_t pb_istream_from_buffer(const pb_byte_t *buf, size_t bufsize)
  * Helper functions *
  ********************/
 
+/* Decode a varint of up to four bytes directly from a memory buffer
+ * stream, without going through the read callback for every byte.
+ * Returns false without consuming any input if the value is longer or
+ * runs into the end of the buffer; the caller then decodes it byte by byte
+ * to get the usual end-of-stream and overflow handling. */
+static bool checkreturn pb_decode_varint32_buffer(pb_istream_t *stream, uint32_t *dest)
+{
+    const pb_byte_t *source = (const pb_byte_t*)stream->state;
+    size_t size = 0;
+    uint32_t result = 0;
+
+    if (stream->bytes_left == 0)
+        return false;
+
+    if ((source[0] & 0x80) == 0)
+    {
+        /* Quick case, 1 byte value */
+        result = source[0];
+        size = 1;
+    }
+#ifdef PB_VARINT_WORD_READ
+    else if (stream->bytes_left >= sizeof(uint32_t))
+    {
+        uint32_t word;
+        uint32_t stop;
+
+        memcpy(&word, source, sizeof(word));
+        stop = ~word & 0x80808080U;
+        if (stop == 0)
+            return false;
+
+        size = (size_t)(__builtin_ctz(stop) / 8 + 1);
+        word &= 0x7F7F7F7FU >> (32 - 8 * size);
+        result = (word & 0x7FU) |
+                 ((word >> 1) & 0x3F80U) |
+                 ((word >> 2) & 0x1FC000U) |
+                 ((word >> 3) & 0xFE00000U);
+    }
+#endif
+    else
+    {
+        pb_byte_t byte;
+        do
+        {
+            if (size == stream->bytes_left || size == sizeof(uint32_t))
+                return false;
+
+            byte = source[size];
+            result |= (uint32_t)(byte & 0x7F) << (7 * size);
+            size++;
+        } while (byte & 0x80);
+    }
+
+    stream->state = (pb_byte_t*)stream->state + size;
+    stream->bytes_left -= size;
+    *dest = result;
+    return true;
+}
+
 static bool checkreturn pb_decode_varint32_eof(pb_istream_t *stream, uint32_t *dest, bool *eof)
 {
     pb_byte_t byte;
     uint32_t result;
     
+#ifndef PB_BUFFER_ONLY
+    if (stream->callback == &buf_read)
+#endif
+    {
+        if (pb_decode_varint32_buffer(stream, dest))
+            return true;
+    }
+
     if (!pb_readbyte(stream, &byte))
     {
         if (stream->bytes_left == 0)
@@ -240,6 +318,18 @@ bool checkreturn pb_decode_varint(pb_istream_t *stream, uint64_t *dest)
     uint_fast8_t bitpos = 0;
     uint64_t result = 0;
     
+#ifndef PB_BUFFER_ONLY
+    if (stream->callback == &buf_read)
+#endif
+    {
+        uint32_t value;
+        if (pb_decode_varint32_buffer(stream, &value))
+        {
+            *dest = value;
+            return true;
+        }
+    }
+
     do
     {
         if (bitpos >= 64)
@@ -416,6 +506,9 @@ static bool checkreturn decode_basic_field(pb_istream_t *stream, pb_field_iter_t
         case PB_LTYPE_FIXED_LENGTH_BYTES:
             return pb_dec_fixed_length_bytes(stream, field);
 
+        case PB_LTYPE_VIEW:
+            return pb_dec_view(stream, field);
+
         default:
             PB_RETURN_ERROR(stream, "invalid field type");
     }
@@ -920,6 +1013,78 @@ static bool pb_message_set_to_defaults(pb_field_iter_t *iter)
     return true;
 }
 
+/* Reset only what tells a decoded field from an absent one: has_ flags,
+ * array counts and oneof tags. The storage behind them is left as is.
+ * Fields without a presence flag still get an empty value, but with a
+ * single store where possible instead of clearing the whole field. */
+static bool pb_field_clear_presence(pb_field_iter_t *field)
+{
+    pb_type_t type = field->type;
+
+    if (PB_ATYPE(type) != PB_ATYPE_STATIC || PB_LTYPE(type) == PB_LTYPE_EXTENSION)
+        return pb_field_set_to_default(field);
+
+    if (PB_HTYPE(type) == PB_HTYPE_REPEATED ||
+        PB_HTYPE(type) == PB_HTYPE_ONEOF)
+    {
+        /* New array entries and oneof members are initialized when decoded. */
+        *(pb_size_t*)field->pSize = 0;
+        return true;
+    }
+
+    if (PB_HTYPE(type) == PB_HTYPE_OPTIONAL && field->pSize != NULL)
+    {
+        *(bool*)field->pSize = false;
+    }
+
+    if (PB_LTYPE_IS_SUBMSG(type))
+    {
+        /* Submessages are decoded on top of their current contents, so the
+         * fields inside need the same treatment even when has_ is false. */
+        pb_field_iter_t submsg_iter;
+        if (pb_field_iter_begin(&submsg_iter, field->submsg_desc, field->pData))
+            return pb_message_clear_presence(&submsg_iter);
+    }
+    else if (PB_HTYPE(type) == PB_HTYPE_OPTIONAL && field->pSize != NULL)
+    {
+        /* has_ field is enough */
+    }
+    else if (PB_LTYPE(type) == PB_LTYPE_STRING)
+    {
+        *(char*)field->pData = '\0';
+    }
+    else if (PB_LTYPE(type) == PB_LTYPE_BYTES)
+    {
+        ((pb_bytes_array_t*)field->pData)->size = 0;
+    }
+    else if (PB_LTYPE(type) == PB_LTYPE_VIEW)
+    {
+        ((pb_view_t*)field->pData)->bytes = NULL;
+        ((pb_view_t*)field->pData)->size = 0;
+    }
+    else
+    {
+        memset(field->pData, 0, (size_t)field->data_size);
+    }
+
+    return true;
+}
+
+static bool pb_message_clear_presence(pb_field_iter_t *iter)
+{
+    /* Default values come from an encoded message, apply them the usual way. */
+    if (iter->descriptor->default_value)
+        return pb_message_set_to_defaults(iter);
+
+    do
+    {
+        if (!pb_field_clear_presence(iter))
+            return false;
+    } while (pb_field_iter_next(iter));
+
+    return true;
+}
+
 /*********************
  * Decode all fields *
  *********************/
@@ -1098,7 +1263,14 @@ bool checkreturn pb_decode_ex(pb_istream_t *stream, const pb_msgdesc_t *fields,
 
         if (pb_field_iter_begin(&iter, fields, dest_struct))
         {
-            if (!pb_message_set_to_defaults(&iter))
+            bool initialized;
+
+            if (flags & PB_DECODE_NOCLEAR)
+                initialized = pb_message_clear_presence(&iter);
+            else
+                initialized = pb_message_set_to_defaults(&iter);
+
+            if (!initialized)
                 PB_RETURN_ERROR(stream, "failed to set defaults");
         }
     }
@@ -1596,6 +1768,28 @@ static bool checkreturn pb_dec_fixed_length_bytes(pb_istream_t *stream, const pb
     return pb_read(stream, (pb_byte_t*)field->pData, (size_t)field->data_size);
 }
 
+static bool checkreturn pb_dec_view(pb_istream_t *stream, const pb_field_iter_t *field)
+{
+    uint32_t size;
+    pb_view_t *view = (pb_view_t*)field->pData;
+
+#ifndef PB_BUFFER_ONLY
+    /* The view points into the input, so it has to be in memory. */
+    if (stream->callback != &buf_read)
+        PB_RETURN_ERROR(stream, "view needs buffer stream");
+#endif
+
+    if (!pb_decode_varint32(stream, &size))
+        return false;
+
+    if (size > PB_SIZE_MAX)
+        PB_RETURN_ERROR(stream, "bytes overflow");
+
+    view->bytes = (const pb_byte_t*)stream->state;
+    view->size = (pb_size_t)size;
+    return pb_read(stream, NULL, (size_t)size);
+}
+
 #ifdef PB_CONVERT_DOUBLE_FLOAT
 bool pb_decode_double_as_float(pb_istream_t *stream, float *dest)
 {
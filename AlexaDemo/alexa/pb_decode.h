@@ -94,11 +94,20 @@ bool pb_decode(pb_istream_t *stream, const pb_msgdesc_t *fields, void *dest_stru
  *                           most other protobuf implementations, so PB_DECODE_DELIMITED
  *                           is a better option for compatibility.
  *
+ * PB_DECODE_NOCLEAR:        Only reset field presence before decoding: has_ fields,
+ *                           array counts and oneof which_ fields. Field contents are
+ *                           not cleared, except that fields without a has_ field are
+ *                           set empty, strings by their first byte only. Use this for large
+ *                           structures where the caller checks presence before
+ *                           using a field. The structure does not need to be
+ *                           initialized beforehand. Ignored with PB_DECODE_NOINIT.
+ *
  * Multiple flags can be combined with bitwise or (| operator)
  */
 #define PB_DECODE_NOINIT          0x01U
 #define PB_DECODE_DELIMITED       0x02U
 #define PB_DECODE_NULLTERMINATED  0x04U
+#define PB_DECODE_NOCLEAR         0x08U
 bool pb_decode_ex(pb_istream_t *stream, const pb_msgdesc_t *fields, void *dest_struct, unsigned int flags);
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
@@ -30,6 +30,7 @@ static bool checkreturn encode_extension_field(pb_ostream_t *stream, const pb_fi
 static bool checkreturn default_extension_encoder(pb_ostream_t *stream, const pb_extension_t *extension);
 static void *pb_const_cast(const void *p);
 static bool checkreturn pb_encode_varint_32(pb_ostream_t *stream, uint32_t low, uint32_t high);
+static bool checkreturn encode_submessage_in_place(pb_ostream_t *stream, const pb_msgdesc_t *fields, const void *src_struct);
 static bool checkreturn pb_enc_bool(pb_ostream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_enc_varint(pb_ostream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_enc_fixed(pb_ostream_t *stream, const pb_field_iter_t *field);
@@ -37,6 +38,7 @@ static bool checkreturn pb_enc_bytes(pb_ostream_t *stream, const pb_field_iter_t
 static bool checkreturn pb_enc_string(pb_ostream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_enc_submessage(pb_ostream_t *stream, const pb_field_iter_t *field);
 static bool checkreturn pb_enc_fixed_length_bytes(pb_ostream_t *stream, const pb_field_iter_t *field);
+static bool checkreturn pb_enc_view(pb_ostream_t *stream, const pb_field_iter_t *field);
 
 #ifdef PB_WITHOUT_64BIT
 #define pb_int64_t int32_t
@@ -281,6 +283,11 @@ static bool checkreturn pb_check_proto3_default_value(const pb_field_iter_t *fie
              * it anyway. */
             return field->data_size == 0;
         }
+        else if (PB_LTYPE(type) == PB_LTYPE_VIEW)
+        {
+            const pb_view_t *view = (const pb_view_t*)field->pData;
+            return view->size == 0;
+        }
         else if (PB_LTYPE_IS_SUBMSG(type))
         {
             /* Check all fields in the submessage to find if any of them
@@ -366,6 +373,9 @@ static bool checkreturn encode_basic_field(pb_ostream_t *stream, const pb_field_
         case PB_LTYPE_FIXED_LENGTH_BYTES:
             return pb_enc_fixed_length_bytes(stream, field);
 
+        case PB_LTYPE_VIEW:
+            return pb_enc_view(stream, field);
+
         default:
             PB_RETURN_ERROR(stream, "invalid field type");
     }
@@ -673,6 +683,7 @@ bool pb_encode_tag_for_field ( pb_ostream_t* stream, const pb_field_iter_t* fiel
         case PB_LTYPE_SUBMESSAGE:
         case PB_LTYPE_SUBMSG_W_CB:
         case PB_LTYPE_FIXED_LENGTH_BYTES:
+        case PB_LTYPE_VIEW:
             wiretype = PB_WT_STRING;
             break;
         
@@ -691,6 +702,48 @@ bool checkreturn pb_encode_string(pb_ostream_t *stream, const pb_byte_t *buffer,
     return pb_write(stream, buffer, size);
 }
 
+/* Encode a submessage into a memory buffer in a single pass.
+ * One byte is reserved for the length, which is enough for submessages
+ * shorter than 128 bytes. A longer submessage is moved forward once its
+ * size is known to make room for the rest of the length varint, so the
+ * output is the same as with the two-pass encoding. */
+static bool checkreturn encode_submessage_in_place(pb_ostream_t *stream, const pb_msgdesc_t *fields, const void *src_struct)
+{
+    static const pb_byte_t placeholder = 0;
+    pb_byte_t *start = (pb_byte_t*)stream->state;
+    size_t start_written = stream->bytes_written;
+    pb_byte_t length[10];
+    pb_ostream_t lengthstream = pb_ostream_from_buffer(length, sizeof(length));
+    size_t size;
+    size_t extra;
+
+    if (!pb_write(stream, &placeholder, 1))
+        return false;
+
+    if (!pb_encode(stream, fields, src_struct))
+        return false;
+
+    size = stream->bytes_written - start_written - 1;
+    if (size < 0x80)
+    {
+        *start = (pb_byte_t)size;
+        return true;
+    }
+
+    if (!pb_encode_varint(&lengthstream, (pb_uint64_t)size))
+        PB_RETURN_ERROR(stream, PB_GET_ERROR(&lengthstream));
+
+    extra = lengthstream.bytes_written - 1;
+    if (stream->bytes_written + extra > stream->max_size)
+        PB_RETURN_ERROR(stream, "stream full");
+
+    memmove(start + lengthstream.bytes_written, start + 1, size);
+    memcpy(start, length, lengthstream.bytes_written);
+    stream->state = start + lengthstream.bytes_written + size;
+    stream->bytes_written += extra;
+    return true;
+}
+
 bool checkreturn pb_encode_submessage(pb_ostream_t *stream, const pb_msgdesc_t *fields, const void *src_struct)
 {
     /* First calculate the message size using a non-writing substream. */
@@ -698,6 +751,17 @@ bool checkreturn pb_encode_submessage(pb_ostream_t *stream, const pb_msgdesc_t *
     size_t size;
     bool status;
     
+#ifdef PB_BUFFER_ONLY
+    if (stream->callback != NULL)
+#else
+    if (stream->callback == &buf_write)
+#endif
+    {
+        /* Memory buffers can be written back to, so the size is
+         * filled in after the submessage has been encoded once. */
+        return encode_submessage_in_place(stream, fields, src_struct);
+    }
+
     if (!pb_encode(&substream, fields, src_struct))
     {
 #ifndef PB_NO_ERRMSG
@@ -921,6 +985,18 @@ static bool checkreturn pb_enc_fixed_length_bytes(pb_ostream_t *stream, const pb
     return pb_encode_string(stream, (const pb_byte_t*)field->pData, (size_t)field->data_size);
 }
 
+static bool checkreturn pb_enc_view(pb_ostream_t *stream, const pb_field_iter_t *field)
+{
+    const pb_view_t *view = (const pb_view_t*)field->pData;
+
+    if (view->bytes == NULL && view->size != 0)
+    {
+        PB_RETURN_ERROR(stream, "invalid view");
+    }
+
+    return pb_encode_string(stream, view->bytes, (size_t)view->size);
+}
+
 #ifdef PB_CONVERT_DOUBLE_FLOAT
 bool pb_encode_float_as_double(pb_ostream_t *stream, float value)
 {
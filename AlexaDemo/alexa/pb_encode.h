@@ -173,8 +173,9 @@ bool pb_encode_float_as_double(pb_ostream_t *stream, float value);
 
 /* Encode a submessage field.
  * You need to pass the pb_field_t array and pointer to struct, just like
- * with pb_encode(). This internally encodes the submessage twice, first to
- * calculate message size and then to actually write it out.
+ * with pb_encode(). On a memory buffer stream the submessage is encoded
+ * once and its length filled in afterwards. Other streams encode it twice,
+ * first to calculate message size and then to actually write it out.
  */
 bool pb_encode_submessage(pb_ostream_t *stream, const pb_msgdesc_t *fields, const void *src_struct);
 
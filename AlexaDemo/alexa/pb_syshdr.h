@@ -0,0 +1,40 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// System header for nanopb, selected with PB_SYSTEM_HEADER in the project
+// build together with PB_ENABLE_MALLOC. It stands in for the standard headers
+// pb.h would otherwise include and sends nanopb's allocations to the
+// directive arena, so pb.h itself stays as shipped.
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_PB_SYSHDR_H
+#define ALEXA_GADGETS_SAMPLE_CODE_PB_SYSHDR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "directive_arena.h"
+
+#ifndef PB_ENABLE_MALLOC
+#error "PB_ENABLE_MALLOC must be defined: directive payloads use pointer fields"
+#endif
+
+// Dynamically allocated fields only appear in directive payloads, which are
+// released all at once when the directive has been handled. The arena only
+// serves allocations while a directive is being dispatched, so any other
+// message given a pointer field fails to decode instead of sharing it.
+#define pb_realloc(ptr, size) DirectiveArena_realloc(ptr, size)
+#define pb_free(ptr) DirectiveArena_free(ptr)
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_PB_SYSHDR_H
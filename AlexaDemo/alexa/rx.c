@@ -22,6 +22,8 @@
 #include <stdlib.h>
 
 #include "accessories.pb.h"
+#include "alexa_codec.h"
+#include "codec_stats.h"
 #include "common.h"
 #include "helpers.h"
 #include "ecode.h"
@@ -38,26 +40,123 @@
 #include "alexaGadgetMusicDataTempoDirectivePayload.pb.h"
 #include "alexaGadgetMusicDataTempoDirective.pb.h"
 #include "directiveParser.pb.h"
+#include "directive_arena.h"
+#include "directive_router.h"
+#include "directive_stream.h"
+#include "tx_ring.h"
 
 #include "native_gecko.h"
+#include "sl_sleeptimer.h"
 #define TIMER_TICKS_PER_SEC   (19200000/ 1024)
 
 bool gDumpRxPacket;
 bool gSendSensorData;
+uint32_t gRxExpiredTransactions;
+uint32_t gRxReclaimedBytes;
 
 typedef struct rx_buffer_s {
+   bool inUse;
+   bool dropping;
    transaction_id_t transactionId;
    stream_id_t streamId;
    uint8_t seqNum;
    size_t bufferSize;
    size_t dataSize;
-   uint8_t data[];
+   uint8_t *data;
+   directive_stream_t *directive;
+   uint32_t lastUsed;
+   uint32_t timestamp;
 } rx_buffer_t;
 
+// Transactions in flight are tracked in a fixed table keyed by stream and
+// transaction id. Control and OTA stream transactions are copied into a
+// statically carved region of the arena; Alexa stream transactions are
+// decoded as their fragments arrive and own a directive decoder instead.
+#define RX_BUFFERED_SLOTS  SAMPLE_RX_BUFFERED_TRANSACTIONS
+#define RX_DIRECTIVE_SLOTS SAMPLE_RX_DIRECTIVE_TRANSACTIONS
+#define RX_ARENA_SIZE      (RX_BUFFERED_SLOTS * SAMPLE_MAX_CONTROL_TRANSACTION_SIZE)
+
+static uint8_t rxArena[RX_ARENA_SIZE];
+static directive_stream_t rxDirectiveStreams[RX_DIRECTIVE_SLOTS];
+static rx_buffer_t rxSlots[RX_BUFFERED_SLOTS + RX_DIRECTIVE_SLOTS];
+static uint32_t rxUseCounter;
+
+static void initRxSlots(void)
+{
+   static bool initialized = false;
+   if(initialized) return;
+
+   for(size_t i = 0; i < ARRAY_SIZE(rxSlots); i++) {
+      if(i < RX_BUFFERED_SLOTS) {
+         rxSlots[i].data = &rxArena[i * SAMPLE_MAX_CONTROL_TRANSACTION_SIZE];
+      }
+      else {
+         rxSlots[i].directive = &rxDirectiveStreams[i - RX_BUFFERED_SLOTS];
+      }
+   }
+   initialized = true;
+}
+
+static rx_buffer_t *findRxBuffer(stream_id_t streamId, transaction_id_t transactionId)
+{
+   for(size_t i = 0; i < ARRAY_SIZE(rxSlots); i++) {
+      if(rxSlots[i].inUse && rxSlots[i].streamId == streamId &&
+         rxSlots[i].transactionId == transactionId)
+      {
+         return &rxSlots[i];
+      }
+   }
+   return NULL;
+}
+
+// Picks a free slot of the kind the stream needs, evicting the least recently
+// used transaction of that kind when all are busy.
+static rx_buffer_t *claimRxBuffer(stream_id_t streamId)
+{
+   bool directive = (streamId == ALEXA_STREAM);
+   rx_buffer_t *candidate = NULL;
+
+   for(size_t i = 0; i < ARRAY_SIZE(rxSlots); i++) {
+      if((rxSlots[i].directive != NULL) != directive) continue;
+      if(!rxSlots[i].inUse) {
+         return &rxSlots[i];
+      }
+      if(candidate == NULL || (int32_t) (rxSlots[i].lastUsed - candidate->lastUsed) < 0) {
+         candidate = &rxSlots[i];
+      }
+   }
+   if(candidate != NULL) {
+      printLog("Evicting Rx Transaction [%d] :: Stream [%d] :: Received [%u/%u]\n",
+           candidate->transactionId, candidate->streamId,
+           candidate->dataSize, candidate->bufferSize);
+   }
+   return candidate;
+}
+
+// Drops stalled transactions so that their slots can be reused.
+void AlexaRxExpireTransactions(bool bAll)
+{
+   uint32_t now = sl_sleeptimer_get_tick_count();
+   uint32_t timeout = sl_sleeptimer_ms_to_tick(SAMPLE_RX_TRANSACTION_TIMEOUT_MS);
+
+   for(size_t i = 0; i < ARRAY_SIZE(rxSlots); i++) {
+      if(!rxSlots[i].inUse) continue;
+      if(!bAll && now - rxSlots[i].timestamp < timeout) continue;
+
+      printLog("Rx Transaction [%d] :: Stream [%d] expired :: Received [%u/%u]\n",
+           rxSlots[i].transactionId, rxSlots[i].streamId,
+           rxSlots[i].dataSize, rxSlots[i].bufferSize);
+      gRxExpiredTransactions++;
+      gRxReclaimedBytes += rxSlots[i].bufferSize;
+      rxSlots[i].inUse = false;
+   }
+}
+
+// Releases the reassembly slot back to the table.
 static void freeRxBufferPtr(rx_buffer_t **ppRxBuffer) {
    if(!ppRxBuffer) return;
    if(*ppRxBuffer != NULL) {
-      free(*ppRxBuffer);
+      (*ppRxBuffer)->inUse = false;
       *ppRxBuffer = NULL;
    }
 }
@@ -84,7 +183,7 @@ static void handleDeviceFeaturesReceived(DeviceFeatures const *const devicefeatu
    printLog("attributes         : %llu\n", devicefeatures->device_attributes);
 }
 
-static packet_list_t *handleReceivedResponse(packet_list_t *rspPacketList, ControlEnvelope *controlEnvelope) 
+static void handleReceivedResponse(ControlEnvelope *controlEnvelope) 
 {
    printLog("Received response for command: %s\n", commandToString(controlEnvelope->command));
    switch(controlEnvelope->payload.response.which_payload) {
@@ -97,10 +196,9 @@ static packet_list_t *handleReceivedResponse(packet_list_t *rspPacketList, Contr
       default:
          break;
    }
-   return rspPacketList;
 }
 
-packet_list_t *handleCommandUpdateComponentSegment(packet_list_t *rspPacketList, UpdateComponentSegment *message) 
+void handleCommandUpdateComponentSegment(UpdateComponentSegment *message) 
 {
    printLog("Called\n");
    printLog("Segment size = %lu\n", message->segment_size);
@@ -109,11 +207,10 @@ packet_list_t *handleCommandUpdateComponentSegment(packet_list_t *rspPacketList,
    printLog("signature: ");
    DumpHex((uint8_t *) &message->segment_signature[0], sizeof(message->segment_signature));
 
-   rspPacketList = PacketList_appendList(rspPacketList, createResponseUpdateComponentSegment());
-   return rspPacketList;
+   createResponseUpdateComponentSegment();
 }
 
-packet_list_t *handleCommandApplyFirmware(packet_list_t *rspPacketList, ApplyFirmware *applyFirmware) {
+void handleCommandApplyFirmware(ApplyFirmware *applyFirmware) {
    printLog("Inside %s\n", __FUNCTION__);
    printLog("restart_required = %s\n", applyFirmware->restart_required ? "true" : "false");
    printLog("Firmware information is:\n");
@@ -130,170 +227,228 @@ packet_list_t *handleCommandApplyFirmware(packet_list_t *rspPacketList, ApplyFir
       DumpHex((uint8_t *) &applyFirmware->firmware_information.components[0].signature[0],
                      sizeof(applyFirmware->firmware_information.components[0].signature));
    }
-   rspPacketList = PacketList_appendList(rspPacketList, createResponseApplyFirmware());
-   return rspPacketList;
+   createResponseApplyFirmware();
 }
 
-packet_list_t *handleReceivedCommand(packet_list_t *rspPacketList, ControlEnvelope *controlEnvelope) {
+void handleReceivedCommand(ControlEnvelope *controlEnvelope) {
    switch(controlEnvelope->command) {
       case Command_GET_DEVICE_INFORMATION:
-         rspPacketList = PacketList_appendList(rspPacketList, createResponseGetDeviceInformation());
+         createResponseGetDeviceInformation();
          break;
       case Command_GET_DEVICE_FEATURES:
-         rspPacketList = PacketList_appendList(rspPacketList, createResponseGetDeviceFeatures());
+         createResponseGetDeviceFeatures();
          break;
       case Command_UPDATE_COMPONENT_SEGMENT:
-         rspPacketList = handleCommandUpdateComponentSegment(rspPacketList,
-                                                             &controlEnvelope->payload.update_component_segment);
+         if(controlEnvelope->which_payload != ControlEnvelope_update_component_segment_tag) {
+            createResponseError(controlEnvelope->command, ErrorCode_INVALID, 0);
+            break;
+         }
+         handleCommandUpdateComponentSegment(&controlEnvelope->payload.update_component_segment);
          break;
       case Command_APPLY_FIRMWARE:
-         rspPacketList = handleCommandApplyFirmware(rspPacketList, &controlEnvelope->payload.apply_firmware);
+         if(controlEnvelope->which_payload != ControlEnvelope_apply_firmware_tag) {
+            createResponseError(controlEnvelope->command, ErrorCode_INVALID, 0);
+            break;
+         }
+         handleCommandApplyFirmware(&controlEnvelope->payload.apply_firmware);
          break;
       default:
-         rspPacketList = PacketList_appendList(rspPacketList,
-                                               createResponseError(controlEnvelope->command,
-                                                                   ErrorCode_UNSUPPORTED,
-                                                                   0));
+         createResponseError(controlEnvelope->command, ErrorCode_UNSUPPORTED, 0);
          break;
    }
-   return rspPacketList;
 }
 
-packet_list_t *handleControlMessage(packet_list_t *rspPacketList, uint8_t *buffer, size_t bufferSize) 
+void handleControlMessage(uint8_t const *buffer, size_t bufferSize) 
 {
-   ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
+   // Only presence is reset before decoding; the handlers check which_payload
+   // and the has_ fields before touching anything.
+   ControlEnvelope controlEnvelope;
    pb_istream_t stream = pb_istream_from_buffer(buffer, bufferSize);
-   if(!pb_decode(&stream, ControlEnvelope_fields, &controlEnvelope)) {
+   uint32_t start = CodecStats_start();
+   bool status = pb_decode_ex(&stream, ControlEnvelope_fields, &controlEnvelope, PB_DECODE_NOCLEAR);
+   CodecStats_finish(CODEC_STATS_CONTROL_ENVELOPE_DECODE, start, bufferSize, status);
+   if(!status) {
       printLog("pb_decode Failed: %s\n", PB_GET_ERROR(&stream));
-      return rspPacketList;
+      return;
    }
    if(controlEnvelope.which_payload == ControlEnvelope_response_tag) {
-      rspPacketList = handleReceivedResponse(rspPacketList, &controlEnvelope);
+      handleReceivedResponse(&controlEnvelope);
    }
    else {
-      rspPacketList = handleReceivedCommand(rspPacketList, &controlEnvelope);
+      handleReceivedCommand(&controlEnvelope);
    }
-   return rspPacketList;
 }
 
-packet_list_t *handleAlexaDirective(
-   packet_list_t *rspPacketList,
-   uint8_t *buffer,
-   size_t len) 
+static void handleDiscover(uint8_t const *payload, size_t payloadSize)
 {
-   pb_istream_t stream = pb_istream_from_buffer(buffer, len);
-   directive_DirectiveParserProto *pEnv;
+   gDumpRxPacket = false;
+   CreateDiscoveryResponse();
+}
 
-   pEnv = (directive_DirectiveParserProto *) malloc(sizeof(directive_DirectiveParserProto));
-   do {
-      if(pEnv == NULL) {
-         printLog("malloc failed\n");
-         break;
-      }
+static void handleClearIndicator(uint8_t const *payload, size_t payloadSize)
+{
+}
 
-      if(!pb_decode(&stream,directive_DirectiveParserProto_fields,pEnv)) {
-         printLog("pb_decode failed: %s\n",PB_GET_ERROR(&stream));
-         gDumpRxPacket = false;
-         break;
+static void handleStateUpdate(uint8_t const *payload, size_t payloadSize)
+{
+   // The state names and values are views into the payload, which outlives
+   // this call, so the message can sit on the stack. The states themselves
+   // are allocated from the directive arena as they are decoded, as many as
+   // the payload carries.
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto statePayload;
+   pb_istream_t Temp;
+   uint32_t start;
+   bool status;
+
+   gDumpRxPacket = false;
+   Temp = pb_istream_from_buffer(payload,payloadSize);
+   start = CodecStats_start();
+   status = alexaGadgetStateListener_StateUpdateDirectivePayloadProto_decode(&Temp,&statePayload);
+   CodecStats_finish(CODEC_STATS_STATE_UPDATE_DECODE, start, payloadSize, status);
+   if(!status)
+   {
+      printLog("pb_decode Failed - %s\n", PB_GET_ERROR(&Temp));
+   }
+   else {
+      int i;
+      for(i = 0; i < statePayload.states_count; i++) {
+         printLog("  %.*s = %.*s\n",
+             (int) statePayload.states[i].name.size,
+             (char const *) statePayload.states[i].name.bytes,
+             (int) statePayload.states[i].value.size,
+             (char const *) statePayload.states[i].value.bytes);
       }
+   }
+}
 
-      printLog("Received directive %s/%s\n",pEnv->directive.header.namespace,
-           pEnv->directive.header.name);
+static void handleTempo(uint8_t const *payload, size_t payloadSize)
+{
+   pb_istream_t Temp;
+   printLog("Received Alexa.Gadget.MusicData/Tempo:\n");
 
-      if(strcmp(pEnv->directive.header.name, "Discover") == 0 &&
-         strcmp(pEnv->directive.header.namespace, "Alexa.Discovery") == 0) 
-      {
-         free(pEnv);
-         pEnv = NULL;
-         rspPacketList = PacketList_appendList(rspPacketList,CreateDiscoveryResponse());
-         break;
-      }
+   Temp = pb_istream_from_buffer(payload,payloadSize);
+   HandleTempoData(&Temp);
+}
 
-      if(strcmp(pEnv->directive.header.namespace,"Notifications") == 0 &&
-         strcmp(pEnv->directive.header.name,"ClearIndicator") == 0)
-      {
-         break;
-      }
+static void handleGetData(uint8_t const *payload, size_t payloadSize)
+{
+   gDumpRxPacket = false;
+   gSendSensorData = true;
+}
 
-      if(strcmp(pEnv->directive.header.namespace,"Alexa.Gadget.StateListener") == 0 &&
-         strcmp(pEnv->directive.header.name,"StateUpdate") == 0)
-      {
-         pb_istream_t Temp;
-         alexaGadgetStateListener_StateUpdateDirectivePayloadProto *pPayload;
+// Every directive the gadget handles. Directives are looked up by binary
+// search, so the table must stay in strcmp() order of namespace, then of name
+// within a namespace. Uppercase sorts before lowercase, so "Alexa.Gadget.X"
+// comes before "Alexa.Gadget.x". A table out of order is reported at boot and
+// then searched one entry at a time.
+static directive_route_t directiveRoutes[] = {
+   DIRECTIVE_ROUTE("Alexa.Discovery",            "Discover",       handleDiscover),
+   DIRECTIVE_ROUTE("Alexa.Gadget.MusicData",     "Tempo",          handleTempo),
+   DIRECTIVE_ROUTE("Alexa.Gadget.StateListener", "StateUpdate",    handleStateUpdate),
+   DIRECTIVE_ROUTE("Custom.ThunderGadget",       "GetData",        handleGetData),
+   DIRECTIVE_ROUTE("Notifications",              "ClearIndicator", handleClearIndicator),
+};
+
+static directive_router_t directiveRouter = DIRECTIVE_ROUTER(directiveRoutes);
+
+// Lets a streamed directive skip its payload when no handler wants it.
+static bool acceptDirective(header_DirectiveHeaderProto const *header)
+{
+   return DirectiveRouter_accepts(&directiveRouter, header);
+}
 
-         pPayload = (alexaGadgetStateListener_StateUpdateDirectivePayloadProto *)
-            malloc(sizeof(alexaGadgetStateListener_StateUpdateDirectivePayloadProto));
-         if(pPayload == NULL) {
-            printLog("malloc failed\n");
-         }
-         Temp = pb_istream_from_buffer(pEnv->directive.payload.bytes,
-                                       pEnv->directive.payload.size);
-         if(!pb_decode(&Temp,alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields,
-                       pPayload))
-         {
-            printLog("pb_decode Failed - %s\n", PB_GET_ERROR(&stream));
-         }
-         else {
-            int i;
-            for(i = 0; i < pPayload->states_count; i++) {
-            printLog("  %s = %s\n",pPayload->states[i].name,
-                pPayload->states[i].value);
-            }
-         }
-         free(pPayload);
-         gDumpRxPacket = false;
-         break;
-      }
-      if(strcmp(pEnv->directive.header.namespace,"Alexa.Gadget.MusicData") == 0 &&
-         strcmp(pEnv->directive.header.name,"Tempo") == 0) 
-      {
-         pb_istream_t Temp;
-         printLog("Received Alexa.Gadget.MusicData/Tempo:\n");
+void AlexaRxInit(void)
+{
+   DirectiveRouter_init(&directiveRouter);
+}
 
-         Temp = pb_istream_from_buffer(pEnv->directive.payload.bytes,
-                                       pEnv->directive.payload.size);
-         HandleTempoData(&Temp);
-         break;
-      }
-      if(strcmp(pEnv->directive.header.namespace,"Custom.ThunderGadget") == 0) {
-         if(strcmp(pEnv->directive.header.name,"GetData") == 0) {
-            gDumpRxPacket = false;
-            gSendSensorData = true;
-         }
-      }
+void AlexaRxPrintDirectiveStats(void)
+{
+   DirectiveRouter_print(&directiveRouter);
+}
+
+static void dispatchAlexaDirective(
+   header_DirectiveHeaderProto const *header,
+   uint8_t const *payload,
+   size_t payloadSize)
+{
+   printLog("Received directive %s/%s\n",header->namespace,header->name);
+
+   DirectiveArena_begin();
+   if(!DirectiveRouter_dispatch(&directiveRouter, header, payload, payloadSize)) {
       printLog("Error: unknown directive\n");
-   } while(false);
+   }
 
-   if(pEnv != NULL && gDumpRxPacket) {
-      if(pEnv->directive.payload.size > 0) {
-         printLog("%d byte payload:\n",pEnv->directive.payload.size);
-         DumpHex(pEnv->directive.payload.bytes,pEnv->directive.payload.size);
+   if(gDumpRxPacket) {
+      if(payloadSize > 0) {
+         printLog("%d byte payload:\n",payloadSize);
+         DumpHex(payload,payloadSize);
       }
    }
 
-   if(pEnv != NULL) {
-      free(pEnv);
+   // Repeated payload fields were allocated from the arena while decoding;
+   // none of them outlive the directive.
+   DirectiveArena_reset();
+}
+
+void handleAlexaDirective(
+   uint8_t const *buffer,
+   size_t len) 
+{
+   pb_istream_t stream = pb_istream_from_buffer(buffer, len);
+   // The payload is decoded as a view into buffer rather than copied out, so
+   // the envelope is only the header strings and fits on the stack. Absent
+   // header strings come out empty without clearing the whole header.
+   directive_DirectiveParserProto env;
+   uint32_t start = CodecStats_start();
+   bool status = directive_DirectiveParserProto_decode(&stream,&env);
+
+   CodecStats_finish(CODEC_STATS_DIRECTIVE_DECODE, start, len, status);
+   if(!status) {
+      printLog("pb_decode failed: %s\n",PB_GET_ERROR(&stream));
+      gDumpRxPacket = false;
+   }
+   else {
+      dispatchAlexaDirective(&env.directive.header,
+                             env.directive.payload.bytes,
+                             env.directive.payload.size);
    }
-   return rspPacketList;
 }
 
-static packet_list_t *handleDataReceived(
+// Completes an Alexa stream transaction that was decoded fragment by fragment.
+static void handleDirectiveStreamReceived(
+   stream_id_t streamId,
+   transaction_id_t transactionId,
+   directive_stream_t *directive,
+   bool ack)
+{
+   queueControlAck(streamId, transactionId, ack,
+                                                CONTROL_PACKET_RESULT_SUCCESS);
+
+   if(!DirectiveStream_finish(directive)) {
+      printLog("pb_decode failed: %s\n", DirectiveStream_error(directive));
+      gDumpRxPacket = false;
+      return;
+   }
+   dispatchAlexaDirective(&directive->header,
+                          directive->payload, directive->payloadSize);
+}
+
+static void handleDataReceived(
    role_t role,
-   packet_list_t *rspPacketList,
    stream_id_t streamId,
    transaction_id_t transactionId,
-   uint8_t *buffer,
+   uint8_t const *buffer,
    size_t bufferSize,
    bool ack) 
 {
    switch(streamId) {
       case CONTROL_STREAM: {
             if(role == ROLE_GADGET) {
-               packet_t controlAck = createControlAckPacket(streamId, transactionId, ack,
+               queueControlAck(streamId, transactionId, ack,
                                                             CONTROL_PACKET_RESULT_SUCCESS);
-               rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
             }
-            rspPacketList = handleControlMessage(rspPacketList, buffer, bufferSize);
+            handleControlMessage(buffer, bufferSize);
          }
          break;
       case OTA_STREAM: {
@@ -302,34 +457,32 @@ static packet_list_t *handleDataReceived(
          break;
 
       case ALEXA_STREAM: {
-         packet_t controlAck;
-         controlAck = createControlAckPacket(streamId,transactionId, ack,
-                                             CONTROL_PACKET_RESULT_SUCCESS);
-         rspPacketList = PacketList_addToTail(rspPacketList,&controlAck);
-         rspPacketList = handleAlexaDirective(rspPacketList,buffer,bufferSize);
+         queueControlAck(streamId,transactionId, ack,
+                         CONTROL_PACKET_RESULT_SUCCESS);
+         handleAlexaDirective(buffer,bufferSize);
          break;
       }
 
       default:
          printLog("Unhandled stream [%u]\n",streamId);
    }
-   return rspPacketList;
 }
 
-packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t const *const packet) 
+void decodePacket(role_t role, packet_t const *const packet) 
 {
-   if(!packet) return rspPacketList;
+   if(!packet) return;
 
    uint8_t const *const buffer = packet->data;
    size_t const bufferSize = packet->dataSize;
 
-   static rx_buffer_t *rxBuffers[3] = {NULL, NULL, NULL};
    size_t offset = 0;
 
+   initRxSlots();
+
    while(bufferSize > offset) {
       if(bufferSize - offset < 2) {
          printLog("Insufficient Length :: [%u/%d]\n",bufferSize - offset, 2);
-         return rspPacketList;
+         return;
       }
       stream_id_t streamId = (buffer[offset] >> STREAM_ID_SHIFT) & STREAM_ID_MASK;
       transaction_id_t transactionId = (buffer[offset] >> TRANSACTION_ID_SHIFT) & TRANSACTION_ID_MASK;
@@ -346,7 +499,7 @@ packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t
          if(bufferSize - offset < (CONTROL_PACKET_LENGTH - 2)) {
             printLog("Insufficient Length :: Control Packet [%u/%d]\n",
                   bufferSize - offset,CONTROL_PACKET_LENGTH - 2);
-            return rspPacketList;
+            return;
          }
          // Reserved: 1 byte.
          offset++;
@@ -362,11 +515,12 @@ packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t
          continue;
       }
 
-      int rxBufferIndex = -1;
+      rx_buffer_t *rxBuffer = NULL;
       if(transactionType == TRANSACTION_TYPE_INITIAL) {
          if(bufferSize - offset < 5) {
             printLog("Insufficient Length :: Initial Packet [%u/%d]\n",
                  bufferSize - offset, 5);
+            return;
          }
          // Reserved: 1 byte.
          offset++;
@@ -377,54 +531,84 @@ packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t
          transactionLength |= buffer[offset++] << 0U;
          printLog("New Rx Transaction %d, Stream %d, transactionLength %d\n",
              transactionId,streamId,transactionLength);
-         rxBufferIndex = streamToIndex(streamId);
-         if(rxBufferIndex < 0) {
+         if(streamToIndex(streamId) == STREAM_INDEX_INVALID) {
             printLog("Invalid streamId [%d]. Could not create an RX Buffer.\n",
                  streamId);
-            return rspPacketList;
+            return;
+         }
+
+         // A transaction carried whole by this fragment is handed straight from
+         // the write buffer, without claiming or copying into a reassembly slot.
+         size_t lengthFieldSize = extendLength ? 2 : 1;
+         if(seqNum == 0 && bufferSize - offset >= lengthFieldSize) {
+            size_t payloadLength = extendLength ?
+               ((size_t) buffer[offset] << 8U) | buffer[offset + 1] : buffer[offset];
+            if(payloadLength == transactionLength &&
+               bufferSize - offset - lengthFieldSize >= payloadLength)
+            {
+               offset += lengthFieldSize;
+               handleDataReceived(role, streamId, transactionId,
+                                  &buffer[offset], payloadLength, ack);
+               offset += payloadLength;
+               continue;
+            }
+         }
+
+         size_t capacity = (streamId == ALEXA_STREAM) ?
+            SAMPLE_MAX_TRANSACTION_SIZE : SAMPLE_MAX_CONTROL_TRANSACTION_SIZE;
+         bool dropping = (transactionLength > capacity);
+         if(dropping) {
+            printLog("Transaction too large [%u/%u] :: Transaction [%d] :: stream [%d]\n",
+                 transactionLength, capacity, transactionId, streamId);
+            queueControlAck(streamId, transactionId, ack,
+                                                         CONTROL_PACKET_RESULT_FAILURE);
          }
-         // Ensure that this packet does not exist and then create it.
-         assert(rxBuffers[rxBufferIndex] == NULL);
-         rxBuffers[rxBufferIndex] = malloc(sizeof(rx_buffer_t) + transactionLength);
-         if(!rxBuffers[rxBufferIndex]) {
+
+         // A reused transaction id supersedes whatever was left of the old one.
+         rxBuffer = findRxBuffer(streamId, transactionId);
+         if(rxBuffer == NULL) {
+            rxBuffer = claimRxBuffer(streamId);
+         }
+         if(rxBuffer == NULL) {
             printLog("Failed to alloc a new RX packet for Transaction [%d] :: stream [%d]\n",
                  transactionId, streamId);
-            return rspPacketList;
+            return;
          }
 
          // Initialize the new packet.
-         rxBuffers[rxBufferIndex]->streamId = streamId;
-         rxBuffers[rxBufferIndex]->transactionId = transactionId;
-         rxBuffers[rxBufferIndex]->bufferSize = transactionLength;
-         rxBuffers[rxBufferIndex]->seqNum = 0;
-         rxBuffers[rxBufferIndex]->dataSize = 0;
+         // A transaction that is too large still holds its slot, so that its
+         // remaining fragments are recognised and skipped rather than stalling
+         // the rest of the write they arrive in.
+         rxBuffer->inUse = true;
+         rxBuffer->dropping = dropping;
+         rxBuffer->streamId = streamId;
+         rxBuffer->transactionId = transactionId;
+         rxBuffer->bufferSize = transactionLength;
+         rxBuffer->seqNum = 0;
+         rxBuffer->dataSize = 0;
+         rxBuffer->timestamp = sl_sleeptimer_get_tick_count();
+         if(rxBuffer->directive != NULL && !dropping) {
+            DirectiveStream_reset(rxBuffer->directive, acceptDirective);
+         }
       }
       else {
          // Find an existing packet
-         rxBufferIndex = streamToIndex(streamId);
-         if(rxBufferIndex < 0) {
-            printLog("Invalid streamId [%d]. Could not find an RX Buffer\n",
-                 streamId);
-            return rspPacketList;
-         }
-         if(rxBuffers[rxBufferIndex] == NULL) { // Ensure that this packet exists.
+         rxBuffer = findRxBuffer(streamId, transactionId);
+         if(rxBuffer == NULL) { // Ensure that this packet exists.
             printLog("Unable to find Rx packet :: Transaction [%d] :: Stream [%d]\n",
                  transactionId, streamId);
-            return rspPacketList;
+            return;
          }
-         assert(rxBuffers[rxBufferIndex]->transactionId == transactionId);
-         assert(rxBuffers[rxBufferIndex]->streamId == streamId);
       }
       size_t currentPayloadLength = 0;
       if(extendLength) {
          if(bufferSize - offset < 2) {
             printLog("Insufficient Length :: Extended Payload Header [%u/%d]\n",
                   bufferSize - offset,2);
-            packet_t controlAck = createControlAckPacket(streamId, transactionId, ack,
+            queueControlAck(streamId, transactionId, ack,
                                                          CONTROL_PACKET_RESULT_FAILURE);
-            rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
-            freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
-            return rspPacketList;
+            freeRxBufferPtr(&rxBuffer);
+            return;
          }
          currentPayloadLength |= buffer[offset++] << 8U; // MSB of payload length.
       }
@@ -432,11 +616,10 @@ packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t
          if(bufferSize - offset < 1) {
             printLog("Insufficient Length :: Extended Payload Header [%u/%d]\n",
                  bufferSize - offset, 1);
-            packet_t controlAck = createControlAckPacket(streamId, transactionId, ack,
+            queueControlAck(streamId, transactionId, ack,
                                                          CONTROL_PACKET_RESULT_FAILURE);
-            rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
-            freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
-            return rspPacketList;
+            freeRxBufferPtr(&rxBuffer);
+            return;
          }
       }
       currentPayloadLength |= buffer[offset++] << 0U; // LSB of payload length.
@@ -444,89 +627,107 @@ packet_list_t *decodePacket(role_t role, packet_list_t *rspPacketList, packet_t
       if(bufferSize - offset < currentPayloadLength) {
          printLog("Insufficient Length :: payload [%u/%u]\n",
                bufferSize - offset,currentPayloadLength);
-         packet_t controlAck = createControlAckPacket(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
-         rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
-         freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
-         return rspPacketList;
+         queueControlAck(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
+         freeRxBufferPtr(&rxBuffer);
+         return;
       }
 
-      if(rxBuffers[rxBufferIndex]->seqNum != seqNum) {
-         printLog("Sequence Failed [%d] :: Expected [%d]\n", seqNum, rxBuffers[rxBufferIndex]->seqNum);
-         packet_t controlAck = createControlAckPacket(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
-         rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
-         freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
-         return rspPacketList;
+      if(rxBuffer->seqNum != seqNum) {
+         printLog("Sequence Failed [%d] :: Expected [%d]\n", seqNum, rxBuffer->seqNum);
+         queueControlAck(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
+         freeRxBufferPtr(&rxBuffer);
+         offset += currentPayloadLength;
+         continue;
       }
 
       // Check if destination packet has sufficient length.
-      if(rxBuffers[rxBufferIndex]->bufferSize - rxBuffers[rxBufferIndex]->dataSize < currentPayloadLength) {
+      if(rxBuffer->bufferSize - rxBuffer->dataSize < currentPayloadLength) {
          printLog("Buffer Overflow :: Transaction [%d] :: Received [%u/%u] :: Packet %u\n",
-              transactionId,rxBuffers[rxBufferIndex]->dataSize,
-              rxBuffers[rxBufferIndex]->bufferSize, currentPayloadLength);
-         packet_t controlAck = createControlAckPacket(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
-         rspPacketList = PacketList_addToTail(rspPacketList, &controlAck);
-         freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
-         return rspPacketList;
+              transactionId,rxBuffer->dataSize,
+              rxBuffer->bufferSize, currentPayloadLength);
+         queueControlAck(streamId, transactionId, ack, CONTROL_PACKET_RESULT_FAILURE);
+         freeRxBufferPtr(&rxBuffer);
+         offset += currentPayloadLength;
+         continue;
       }
-      memcpy(rxBuffers[rxBufferIndex]->data + rxBuffers[rxBufferIndex]->dataSize,
-             &buffer[offset],
-             currentPayloadLength);
-      rxBuffers[rxBufferIndex]->dataSize += currentPayloadLength;
+      if(rxBuffer->dropping) {
+         // Skipped; the failure was acknowledged with the initial fragment.
+      }
+      else if(rxBuffer->directive != NULL) {
+         // A decode error is reported once the whole transaction has arrived.
+         DirectiveStream_feed(rxBuffer->directive, &buffer[offset],
+                              currentPayloadLength);
+      }
+      else {
+         memcpy(rxBuffer->data + rxBuffer->dataSize,
+                &buffer[offset],
+                currentPayloadLength);
+      }
+      rxBuffer->dataSize += currentPayloadLength;
       offset += currentPayloadLength;
-      rxBuffers[rxBufferIndex]->seqNum = (rxBuffers[rxBufferIndex]->seqNum + 1) & 0x0FU;
+      rxBuffer->seqNum = (rxBuffer->seqNum + 1) & 0x0FU;
+      rxBuffer->lastUsed = ++rxUseCounter;
+      rxBuffer->timestamp = sl_sleeptimer_get_tick_count();
       printLog("Rx Progress [%u/%u] :: Stream [%d] :: Transaction [%d]\n",
-             rxBuffers[rxBufferIndex]->dataSize, rxBuffers[rxBufferIndex]->bufferSize, streamId, transactionId);
-      if(rxBuffers[rxBufferIndex]->dataSize == rxBuffers[rxBufferIndex]->bufferSize) {
-         rspPacketList = handleDataReceived(role, rspPacketList, streamId, transactionId,
-                                            rxBuffers[rxBufferIndex]->data, rxBuffers[rxBufferIndex]->dataSize, ack);
-         freeRxBufferPtr(&rxBuffers[rxBufferIndex]);
+             rxBuffer->dataSize, rxBuffer->bufferSize, streamId, transactionId);
+      if(rxBuffer->dataSize == rxBuffer->bufferSize) {
+         if(rxBuffer->dropping) {
+            printLog("Dropped Rx Transaction [%d] :: Stream [%d]\n", transactionId, streamId);
+         }
+         else if(rxBuffer->directive != NULL) {
+            handleDirectiveStreamReceived(streamId, transactionId,
+                                          rxBuffer->directive, ack);
+         }
+         else {
+            handleDataReceived(role, streamId, transactionId,
+                               rxBuffer->data, rxBuffer->dataSize, ack);
+         }
+         freeRxBufferPtr(&rxBuffer);
       }
    }
-   return rspPacketList;
 }
 
 
 int AlexaRxPacket(uint8_t *pData,uint8_t Len)
 {
    packet_t Pkt;
-   packet_list_t *response = NULL;
-   packet_list_t *pLastResp;
-   int Responses = 0;
+   int Responses;
+   int Notifications;
 
    Pkt.data = pData;
    Pkt.dataSize = Len;
 
+   // Writes are bounded by the largest MTU we offer. The central may write at
+   // the negotiated MTU before the exchange event reaches us.
+   if(Len > SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE) {
+      printLog("Packet exceeds fragment size [%u/%u], dropped\n",Len,SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE);
+      return 0;
+   }
+
    gDumpRxPacket = true;
 
-   response = decodePacket(ROLE_GADGET,response,&Pkt);
-   while(response != NULL) {
-      Responses++;
-      AlexaTxPacket(response->packet.data,response->packet.dataSize);
-      pLastResp = response;
-      response = response->next;
-      free(pLastResp->packet.data);
-      free(pLastResp);  // data is free'ed after ack is received
-   }
-   printLog("%d responses sent\n",Responses);
+   decodePacket(ROLE_GADGET,&Pkt);
+   Responses = TxRing_getDepth();
+   Notifications = AlexaTxPump();
+   printLog("%d responses sent in %d notifications\n",Responses,Notifications);
 
    return 0;
 }
 
 void HandleTempoData(pb_istream_t *pStream)
 {
-   //pb_istream_t Temp;
-   alexaGadgetMusicData_TempoDirectivePayloadProto *pPayload = NULL;
+   alexaGadgetMusicData_TempoDirectivePayloadProto tempoPayload;
+   alexaGadgetMusicData_TempoDirectivePayloadProto *pPayload = &tempoPayload;
+   size_t payloadSize = pStream->bytes_left;
+   uint32_t start;
+   bool status;
    int i;
 
    do {
-      pPayload = (alexaGadgetMusicData_TempoDirectivePayloadProto *)
-         malloc(sizeof(alexaGadgetStateListener_StateUpdateDirectivePayloadProto));
-      if(pPayload == NULL) {
-         printLog("malloc failed\n");
-         break;
-      }
-      if(!pb_decode(pStream,alexaGadgetMusicData_TempoDirectivePayloadProto_fields,
-                    pPayload))
+      start = CodecStats_start();
+      status = alexaGadgetMusicData_TempoDirectivePayloadProto_decode(pStream,pPayload);
+      CodecStats_finish(CODEC_STATS_TEMPO_DECODE, start, payloadSize, status);
+      if(!status)
       {
          printLog("pb_decode Failed - %s\n", PB_GET_ERROR(pStream));
          break;
@@ -535,27 +736,24 @@ void HandleTempoData(pb_istream_t *pStream)
           pPayload->playerOffsetInMilliSeconds);
       printLog("  tempoData_count: %u\n",pPayload->tempoData_count);
       for(i = 0; i < pPayload->tempoData_count; i++) {
-      printLog("    @%lu: %lu\n",pPayload->tempoData[i].startOffsetInMilliSeconds,
-          pPayload->tempoData[i].value);
+         printLog("    @%lu: %lu\n",pPayload->tempoData[i].startOffsetInMilliSeconds,
+             pPayload->tempoData[i].value);
       }
-      if(pPayload->tempoData[0].value == 0) {
+      if(pPayload->tempoData_count == 0 || pPayload->tempoData[0].value == 0) {
       // End of song, turn off LEDs
          printLog("Turning off LEDS\n");
          gLedOn = false;
          SetLeds(0,0,0);
-         gecko_cmd_hardware_set_soft_timer(0, 0, 0);  // Disable the timer
+         gecko_cmd_hardware_set_soft_timer(0, TEMPO_TIMER_HANDLE, 0);  // Disable the timer
       }
       else {
     	  // Start LED flashing with the temp
 		  // Flash @ BPM, 50% duty cycle
 		  // native Gecko timer units are 1/32768s
     	  // Set timer to value based on beats per minute from MusicTempo
-    	  gecko_cmd_hardware_set_soft_timer((32768*60)/(pPayload->tempoData[0].value * 2), 0, 0);
+    	  gecko_cmd_hardware_set_soft_timer((32768*60)/(pPayload->tempoData[0].value * 2),
+    	                                    TEMPO_TIMER_HANDLE, 0);
       }
       gDumpRxPacket = false;
    } while(false);
-
-   if(pPayload != NULL) {
-      free(pPayload);
-   }
 }
@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include "accessories.pb.h"
+#include "alexa_codec.h"
+#include "codec_stats.h"
 #include "alexaDiscoveryDiscoverResponseEventPayload.pb.h"
 #include "alexaDiscoveryDiscoverResponseEvent.pb.h"
 #include "eventParser.pb.h"
@@ -22,15 +24,62 @@
 #include "alexa.h"
 #include "app.h"
 #include "gatt_db.h"
+#include "native_gecko.h"
+#include "message_scratch.h"
+#include "packet_pool.h"
+#include "tx_ring.h"
+#include "bg_errorcodes.h"
 
 void InitMusicData(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities *p);
 
+static uint16_t attMtu = SAMPLE_DEFAULT_ATT_MTU;
+// The protocol version packet advertises the fragment size, so it is held
+// back until the MTU exchange completes or MTU_EXCHANGE_TIMEOUT expires and
+// then sent once.
+static bool mtuExchanged;
+static bool protocolVersionPending;
+
+uint32_t gTxRetries;
+uint32_t gTxRejected;
+uint32_t gTxDroppedFrames;
+
+// Frames taken off the TX ring and packed into the next notification. They
+// stay here until the stack accepts the notification.
+static uint8_t txPending[SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE];
+static size_t txPendingSize;
+static size_t txPendingFrames;
+
+size_t getFragmentSize(void)
+{
+   return attMtu - ATT_HEADER_SIZE;
+}
+
+static void sendProtocolVersion(void);
+
+void AlexaSetAttMtu(uint16_t Mtu)
+{
+   attMtu = MAX(SAMPLE_DEFAULT_ATT_MTU, MIN(Mtu, SAMPLE_MAX_ATT_MTU));
+   mtuExchanged = true;
+   printLog("ATT MTU %u, fragment size %u\n", attMtu, getFragmentSize());
+   if(protocolVersionPending) {
+      gecko_cmd_hardware_set_soft_timer(0, PROTOCOL_VERSION_TIMER_HANDLE, 0);
+      sendProtocolVersion();
+   }
+}
+
+void AlexaResetAttMtu(void)
+{
+   attMtu = SAMPLE_DEFAULT_ATT_MTU;
+   mtuExchanged = false;
+   protocolVersionPending = false;
+}
+
 static transaction_id_t getNextTransactionId(stream_id_t streamId) 
 {
    static uint8_t lastTransactionId[3] = {0xff, 0xff, 0xff};
 
-   int index = streamToIndex(streamId);
-   if(index < 0) {
+   size_t index = streamToIndex(streamId);
+   if(index == STREAM_INDEX_INVALID) {
       return 0;
    }
 
@@ -41,7 +90,7 @@ static transaction_id_t getNextTransactionId(stream_id_t streamId)
 packet_t createProtocolVersionPacket() 
 {
    packet_t packet = {};
-   uint8_t *buffer = malloc(PROTOCOL_VERSION_PACKET_SIZE);
+   uint8_t *buffer = PacketPool_alloc(PROTOCOL_VERSION_PACKET_SIZE);
    if(buffer) {
       packet.data = buffer;
       packet.dataSize = PROTOCOL_VERSION_PACKET_SIZE;
@@ -50,8 +99,8 @@ packet_t createProtocolVersionPacket()
       buffer[1] = (uint8_t) (PROTOCOL_IDENTIFIER >> 0U);
       buffer[2] = PROTOCOL_VERSION_MAJOR;
       buffer[3] = PROTOCOL_VERSION_MINOR;
-      buffer[4] = (uint8_t) (SAMPLE_NEGOTIATED_MTU >> 8U);
-      buffer[5] = (uint8_t) (SAMPLE_NEGOTIATED_MTU >> 0U);
+      buffer[4] = (uint8_t) (getFragmentSize() >> 8U);
+      buffer[5] = (uint8_t) (getFragmentSize() >> 0U);
       buffer[6] = (uint8_t) (SAMPLE_MAX_TRANSACTION_SIZE >> 8U);
       buffer[7] = (uint8_t) (SAMPLE_MAX_TRANSACTION_SIZE >> 0U);
    }
@@ -64,7 +113,7 @@ packet_t createAdvertisingPacket(bool bPairingMode)
    packet_t packet = {};
 
    // Advertising data (AD) is organized in LTV (Length/Tag/Value) triplets.
-   uint8_t *buffer = malloc(ADV_DATA_LEN);
+   uint8_t *buffer = PacketPool_alloc(ADV_DATA_LEN);
    if(buffer) {
       memset(buffer,0,ADV_DATA_LEN);
    // Flags
@@ -103,6 +152,24 @@ packet_t createAdvertisingPacket(bool bPairingMode)
    return packet;
 }
 
+// Writes the CONTROL_PACKET_LENGTH bytes of a control ACK.
+static void writeControlAck(
+   uint8_t *buffer,
+   stream_id_t streamId,
+   transaction_id_t transactionId,
+   control_ack_result_t result)
+{
+   printLog("transactionId: %d, result: %d\n", transactionId, result);
+   buffer[0] = (streamId & STREAM_ID_MASK) << STREAM_ID_SHIFT;
+   buffer[0] |= (transactionId & TRANSACTION_ID_MASK) << TRANSACTION_ID_SHIFT;
+   buffer[1] = (TRANSACTION_TYPE_CONTROL & TRANSACTION_TYPE_MASK) << TRANSACTION_TYPE_SHIFT;
+   buffer[1] |= (result == CONTROL_PACKET_RESULT_SUCCESS) ? (1U << ACK_BIT_SHIFT) : 0;
+   buffer[2] = 0; // Reserved.
+   buffer[3] = 2; // Length 2 bytes.
+   buffer[4] = 1; // Reserved
+   buffer[5] = result;
+}
+
 packet_t createControlAckPacket(
    stream_id_t streamId,
    transaction_id_t transactionId,
@@ -112,153 +179,271 @@ packet_t createControlAckPacket(
    packet_t packet = {};
    uint8_t *buffer;
 
-   if(ack && (buffer = malloc(CONTROL_PACKET_LENGTH)) != NULL) {
-      printLog("transactionId: %d, result: %d\n", transactionId, result); //  ack,
-      buffer[0] = (streamId & STREAM_ID_MASK) << STREAM_ID_SHIFT;
-      buffer[0] |= (transactionId & TRANSACTION_ID_MASK) << TRANSACTION_ID_SHIFT;
-      buffer[1] = (TRANSACTION_TYPE_CONTROL & TRANSACTION_TYPE_MASK) << TRANSACTION_TYPE_SHIFT;
-      buffer[1] |= (result == CONTROL_PACKET_RESULT_SUCCESS) ? (1U << ACK_BIT_SHIFT) : 0;
-      buffer[2] = 0; // Reserved.
-      buffer[3] = 2; // Length 2 bytes.
-      buffer[4] = 1; // Reserved
-      buffer[5] = result;
-
+   if(ack && (buffer = PacketPool_alloc(CONTROL_PACKET_LENGTH)) != NULL) {
+      writeControlAck(buffer, streamId, transactionId, result);
       packet.data = buffer;
       packet.dataSize = CONTROL_PACKET_LENGTH;
    }
    else if(ack) {
-      printLog("malloc failed\n");
+      printLog("PacketPool_alloc failed\n");
    }
    return packet;
 }
 
-static packet_list_t *buildStreamPacket(stream_id_t streamId, bool ack, uint8_t *payload, size_t payloadSize) 
+void queueControlAck(
+   stream_id_t streamId,
+   transaction_id_t transactionId,
+   bool ack,
+   control_ack_result_t result) 
 {
-   packet_list_t *Ret = NULL;
-   size_t remainingSize = payloadSize;
-   packet_list_t *packetListHead = NULL;
-   uint8_t seqNum = 0;
-   transaction_id_t transactionId = 0;
-   size_t srcIndex = 0;
+   if(!ack) return;
 
-   do {
-      // https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#packet-format
-      if(streamId != CONTROL_STREAM && streamId != OTA_STREAM && streamId != ALEXA_STREAM) {
-         printLog( "Invalid argument streamId");
-         break;
-      }
-      if(payloadSize > 0xffff) {
-         printLog( "Invalid argument payloadSize");
-         break;
-      }
+   uint8_t *buffer = TxRing_reserve(CONTROL_PACKET_LENGTH);
+   if(buffer == NULL) {
+      printLog("TX ring full, dropping ACK for Transaction [%d]\n", transactionId);
+      gTxRejected++;
+      return;
+   }
+   writeControlAck(buffer, streamId, transactionId, result);
+   TxRing_commit();
+}
 
-      while(remainingSize > 0) {
-         // Calculate the current size.
-         size_t currentPacketHeaderSize = 3;
-         transaction_type_t transactionType = TRANSACTION_TYPE_CONTINUE;
-         if(srcIndex == 0) { // First packet header
-            transactionType = TRANSACTION_TYPE_INITIAL;
-            transactionId = getNextTransactionId(streamId);
-            printLog("New Tx Transaction [%d] :: Stream [%d]\n", transactionId, streamId);
-            currentPacketHeaderSize += 3;
-         }
-         size_t currentPacketPayloadSize = MIN(SAMPLE_NEGOTIATED_MTU - currentPacketHeaderSize, remainingSize);
-         bool extendedLength = false;
-         if(currentPacketPayloadSize > 0xff) {
-            extendedLength = true;
-            currentPacketHeaderSize++;
-            if(currentPacketPayloadSize > SAMPLE_NEGOTIATED_MTU - currentPacketHeaderSize) {
-               currentPacketPayloadSize--;
-            }
-         }
+// Encoder output sink that frames a transaction straight into the TX ring.
+// Each fragment is reserved at full size and filled as pb_encode produces
+// bytes; its length, the FINAL type of the last fragment and the total
+// length in the INITIAL header are patched in once they are known. A pooled
+// sink takes each fragment from the packet pool instead and collects the
+// fragments in a packet list.
+typedef struct {
+   stream_id_t streamId;
+   transaction_id_t transactionId;
+   bool ack;
+   size_t fragmentSize;
+   uint8_t seqNum;
+   uint8_t *initial;       // INITIAL fragment, holds the total length
+   uint8_t *fragment;      // fragment being filled
+   size_t headerSize;      // header bytes ahead of the fragment payload
+   size_t payloadSize;     // payload bytes in the fragment so far
+   size_t totalSize;
+   bool ringFull;
+   bool pooled;
+   packet_list_t *list;    // fragments of a pooled sink
+} fragment_sink_t;
+
+// Patches the length of the fragment being filled.
+static void closeFragment(fragment_sink_t *sink)
+{
+   // Length: 8 bits, the last header byte.
+   sink->fragment[sink->headerSize - 1] = (uint8_t) sink->payloadSize;
+}
 
-         // Make the last packet as final.
-         if(transactionType == TRANSACTION_TYPE_CONTINUE && currentPacketPayloadSize == remainingSize) {
-            transactionType = TRANSACTION_TYPE_FINAL;
-         }
+// Appends a pool block for the next fragment to the list of a pooled sink.
+static uint8_t *allocPooledFragment(fragment_sink_t *sink)
+{
+   packet_t packet = { sink->fragmentSize, PacketPool_alloc(sink->fragmentSize) };
+   if(packet.data == NULL) {
+      return NULL;
+   }
+   packet_list_t *list = PacketList_addToTail(sink->list, &packet);
+   if(list == NULL || list->tail->packet.data != packet.data) {
+      PacketPool_free(packet.data);
+      return NULL;
+   }
+   sink->list = list;
+   return packet.data;
+}
 
-         size_t currentPacketSize = currentPacketHeaderSize + currentPacketPayloadSize;
-         uint8_t *const buffer = malloc(currentPacketSize);
-         if(buffer) {
-            size_t dstIndex = 0;
-            // StreamId: 4 bits
-            buffer[dstIndex] = (streamId & STREAM_ID_MASK) << STREAM_ID_SHIFT;
-            // TransactionId: 4 bits
-            buffer[dstIndex] |= (transactionId & TRANSACTION_ID_MASK) << TRANSACTION_ID_SHIFT;
-            dstIndex++;
-
-            // Sequence number: 4 bits
-            buffer[dstIndex] = (seqNum & SEQ_NUM_ID_MASK) << SEQ_NUM_ID_SHIFT;
-            seqNum = (seqNum + 1) & SEQ_NUM_ID_MASK;
-            // Transaction type: 4 bits
-            buffer[dstIndex] |= (transactionType & TRANSACTION_TYPE_MASK) << TRANSACTION_TYPE_SHIFT;
-            // ACK: 1 bit
-            buffer[dstIndex] |= (ack) ? (1U << ACK_BIT_SHIFT) : 0;
-            // LengthExtender: 1 bit
-            buffer[dstIndex] |= (extendedLength) ? (1U << EXTENDED_LENGTH_BIT_SHIFT) : 0;
-            dstIndex++;
-
-            if(transactionType == TRANSACTION_TYPE_INITIAL) {
-               // Reserved: 8 bits
-               buffer[dstIndex++] = 0x00;
-               // Total transaction length.
-               buffer[dstIndex++] = payloadSize >> 8U;
-               buffer[dstIndex++] = payloadSize >> 0U;
-            }
-
-            if(extendedLength) {
-               // ExtendedLength: extra 8 bits in payload length.
-               buffer[dstIndex++] = currentPacketPayloadSize >> 8U;
-            }
-            // Length: 8 bits.
-            buffer[dstIndex++] = currentPacketPayloadSize >> 0U;
-
-            // Payload
-            memcpy(&buffer[dstIndex],&payload[srcIndex],currentPacketPayloadSize);
-            dstIndex += currentPacketPayloadSize;
-            srcIndex += currentPacketPayloadSize;
-            printLog("Tx Progress [%d/%d] :: Stream [%d] :: Transaction [%d]\n",
-                srcIndex, payloadSize, streamId,transactionId);
-
-            // Append this packet to the list of buffers ready for TX.
-            packet_t packet = {};
-            packet.data = buffer;
-            packet.dataSize = currentPacketSize;
-            packetListHead = PacketList_addToTail(packetListHead, &packet);
-         }
-         else {
-            printLog("Failed to allocate memory for TX packet.");
-            break;
+static bool openFragment(fragment_sink_t *sink)
+{
+   uint8_t *buffer = sink->pooled ?
+      allocPooledFragment(sink) : TxRing_reserve(sink->fragmentSize);
+   if(buffer == NULL) {
+      printLog("%s, dropping Transaction [%d] :: Stream [%d]\n",
+          sink->pooled ? "Packet pool empty" : "TX ring full",
+          sink->transactionId, sink->streamId);
+      sink->ringFull = !sink->pooled;
+      return false;
+   }
+
+   transaction_type_t transactionType = TRANSACTION_TYPE_CONTINUE;
+   if(sink->initial == NULL) {
+      transactionType = TRANSACTION_TYPE_INITIAL;
+      sink->initial = buffer;
+   }
+   else {
+      closeFragment(sink);
+   }
+
+   size_t dstIndex = 0;
+   // StreamId: 4 bits
+   buffer[dstIndex] = (sink->streamId & STREAM_ID_MASK) << STREAM_ID_SHIFT;
+   // TransactionId: 4 bits
+   buffer[dstIndex] |= (sink->transactionId & TRANSACTION_ID_MASK) << TRANSACTION_ID_SHIFT;
+   dstIndex++;
+
+   // Sequence number: 4 bits
+   buffer[dstIndex] = (sink->seqNum & SEQ_NUM_ID_MASK) << SEQ_NUM_ID_SHIFT;
+   sink->seqNum = (sink->seqNum + 1) & SEQ_NUM_ID_MASK;
+   // Transaction type: 4 bits, the last fragment is marked FINAL when it is closed.
+   buffer[dstIndex] |= (transactionType & TRANSACTION_TYPE_MASK) << TRANSACTION_TYPE_SHIFT;
+   // ACK: 1 bit
+   buffer[dstIndex] |= (sink->ack) ? (1U << ACK_BIT_SHIFT) : 0;
+   // LengthExtender: 1 bit, never set as a fragment is at most 0xff bytes long.
+   dstIndex++;
+
+   if(transactionType == TRANSACTION_TYPE_INITIAL) {
+      // Reserved: 8 bits
+      buffer[dstIndex++] = 0x00;
+      // Total transaction length, patched in when the transaction is complete.
+      buffer[dstIndex++] = 0x00;
+      buffer[dstIndex++] = 0x00;
+   }
+   // Length: 8 bits, patched in when the fragment is closed.
+   buffer[dstIndex++] = 0x00;
+
+   sink->fragment = buffer;
+   sink->headerSize = dstIndex;
+   sink->payloadSize = 0;
+   return true;
+}
+
+static bool writeFragments(pb_ostream_t *stream, const pb_byte_t *buf, size_t count)
+{
+   fragment_sink_t *sink = (fragment_sink_t *) stream->state;
+
+   while(count > 0) {
+      if(sink->fragment == NULL ||
+         sink->headerSize + sink->payloadSize == sink->fragmentSize)
+      {
+         if(!openFragment(sink)) {
+            return false;
          }
-         // Update the remaining size.
-         remainingSize -= currentPacketPayloadSize;
       }
-      if(remainingSize == 0) {
-         Ret = packetListHead;
-      }
-   } while(false);
+      size_t size = MIN(count, sink->fragmentSize - sink->headerSize - sink->payloadSize);
+      memcpy(&sink->fragment[sink->headerSize + sink->payloadSize], buf, size);
+      sink->payloadSize += size;
+      sink->totalSize += size;
+      buf += size;
+      count -= size;
+   }
+   return true;
+}
 
-   return Ret;
+// Returns an output stream that frames everything written to it as one
+// transaction on streamId. The stream writes into the TX ring as it goes,
+// or into pool blocks if the sink is set to pooled before the first write;
+// finishStreamPacket() publishes or drops the transaction.
+static pb_ostream_t openStreamPacket(fragment_sink_t *sink, stream_id_t streamId, bool ack)
+{
+   memset(sink, 0, sizeof(*sink));
+   sink->streamId = streamId;
+   sink->ack = ack;
+   sink->fragmentSize = MIN(getFragmentSize(), TX_RING_MAX_FRAME_SIZE);
+   sink->transactionId = getNextTransactionId(streamId);
+   printLog("New Tx Transaction [%d] :: Stream [%d]\n", sink->transactionId, streamId);
+
+   pb_ostream_t stream = {&writeFragments, sink, 0xffff, 0};
+   return stream;
 }
 
-static packet_list_t *createControlPacket(ControlEnvelope const *const controlEnvelope, bool ackRequired) 
+static bool finishStreamPacket(fragment_sink_t *sink, pb_ostream_t *stream, bool status)
 {
-   size_t encoded_size;
-   if(!pb_get_encoded_size(&encoded_size, ControlEnvelope_fields, controlEnvelope)) {
-      printLog( "Failed To Calculate Control Envelope Encoded Size");
-      return NULL;
+   if(!status || sink->totalSize == 0) {
+      if(!status) {
+         printLog("pb_encode failed: %s\n",PB_GET_ERROR(stream));
+      }
+      if(sink->pooled) {
+         PacketList_freeList(sink->list);
+         sink->list = NULL;
+         return false;
+      }
+      TxRing_abort();
+      if(sink->ringFull) {
+         gTxRejected++;
+      }
+      return false;
    }
-   uint8_t buffer[encoded_size];
-   pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
-   bool status = pb_encode(&stream, ControlEnvelope_fields, controlEnvelope);
-   if(!status) {
-      printLog("pb_encode failed: %s\n",PB_GET_ERROR(&stream));
-      return NULL;
+
+   closeFragment(sink);
+   if(sink->fragment != sink->initial) {
+      sink->fragment[1] &= ~(TRANSACTION_TYPE_MASK << TRANSACTION_TYPE_SHIFT);
+      sink->fragment[1] |= (TRANSACTION_TYPE_FINAL & TRANSACTION_TYPE_MASK) << TRANSACTION_TYPE_SHIFT;
+   }
+
+   // Total transaction length.
+   sink->initial[3] = sink->totalSize >> 8U;
+   sink->initial[4] = sink->totalSize >> 0U;
+   if(sink->pooled) {
+      sink->list->tail->packet.dataSize = sink->headerSize + sink->payloadSize;
+   }
+   else {
+      TxRing_trim(sink->headerSize + sink->payloadSize);
+      TxRing_commit();
    }
-   return buildStreamPacket(CONTROL_STREAM, ackRequired, buffer, stream.bytes_written);
+   printLog("Tx Queued [%u] :: Stream [%d] :: Transaction [%d]\n",
+       sink->totalSize, sink->streamId, sink->transactionId);
+   return true;
+}
+
+packet_list_t *buildStreamPacket(stream_id_t streamId, bool ack, uint8_t const *payload,
+                                 size_t payloadSize)
+{
+   fragment_sink_t sink;
+   pb_ostream_t stream = openStreamPacket(&sink, streamId, ack);
+   sink.pooled = true;
+   bool status = pb_write(&stream, payload, payloadSize);
+   return finishStreamPacket(&sink, &stream, status) ? sink.list : NULL;
+}
+
+static bool createControlPacket(ControlEnvelope const *const controlEnvelope, bool ackRequired) 
+{
+   fragment_sink_t sink;
+   pb_ostream_t stream = openStreamPacket(&sink, CONTROL_STREAM, ackRequired);
+   uint32_t start = CodecStats_start();
+   bool status = pb_encode(&stream, ControlEnvelope_fields, controlEnvelope);
+   CodecStats_finish(CODEC_STATS_CONTROL_ENVELOPE_ENCODE, start, stream.bytes_written, status);
+   return finishStreamPacket(&sink, &stream, status);
+}
+
+// An encoded response that only changes with the gadget identity.
+typedef struct {
+   size_t size;             // 0 until encoded, or if it did not fit
+   size_t capacity;
+   uint8_t *data;
+} cached_response_t;
+
+typedef bool (*response_encoder_t)(pb_ostream_t *stream);
+
+static uint8_t deviceInformationBytes[ControlEnvelope_size];
+static uint8_t deviceFeaturesBytes[ControlEnvelope_size];
+static uint8_t discoveryResponseBytes[SAMPLE_DISCOVERY_CACHE_SIZE];
+
+static cached_response_t cachedDeviceInformation =
+   {0, sizeof(deviceInformationBytes), deviceInformationBytes};
+static cached_response_t cachedDeviceFeatures =
+   {0, sizeof(deviceFeaturesBytes), deviceFeaturesBytes};
+static cached_response_t cachedDiscoveryResponse =
+   {0, sizeof(discoveryResponseBytes), discoveryResponseBytes};
+
+static void refreshCachedResponse(cached_response_t *cache, response_encoder_t encode)
+{
+   pb_ostream_t stream = pb_ostream_from_buffer(cache->data, cache->capacity);
+   cache->size = encode(&stream) ? stream.bytes_written : 0;
+}
+
+// Frames a response from its cached encoding, or encodes it on the spot if
+// there is none.
+static bool queueCachedResponse(stream_id_t streamId, cached_response_t const *cache,
+                                response_encoder_t encode)
+{
+   fragment_sink_t sink;
+   pb_ostream_t stream = openStreamPacket(&sink, streamId, false);
+   bool status = (cache->size > 0) ?
+      pb_write(&stream, cache->data, cache->size) : encode(&stream);
+   return finishStreamPacket(&sink, &stream, status);
 }
 
-packet_list_t *createResponseError(Command cmd, ErrorCode errorCode, uint16_t tag) 
+bool createResponseError(Command cmd, ErrorCode errorCode, uint16_t tag) 
 {
    ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
    controlEnvelope.command = cmd;
@@ -272,7 +457,16 @@ packet_list_t *createResponseError(Command cmd, ErrorCode errorCode, uint16_t ta
    return createControlPacket(&controlEnvelope, false);
 }
 
-packet_list_t *createResponseGetDeviceInformation() 
+static bool encodeControlEnvelope(pb_ostream_t *stream, ControlEnvelope const *controlEnvelope)
+{
+   size_t offset = stream->bytes_written;
+   uint32_t start = CodecStats_start();
+   bool status = pb_encode(stream, ControlEnvelope_fields, controlEnvelope);
+   CodecStats_finish(CODEC_STATS_CONTROL_ENVELOPE_ENCODE, start, stream->bytes_written - offset, status);
+   return status;
+}
+
+static bool encodeDeviceInformation(pb_ostream_t *stream)
 {
    ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
    controlEnvelope.command = Command_GET_DEVICE_INFORMATION;
@@ -287,11 +481,10 @@ packet_list_t *createResponseGetDeviceInformation()
    deviceInformation->supported_transports[0] = Transport_BLUETOOTH_LOW_ENERGY;
    strcpy(deviceInformation->device_type,AMAZON_DEVICE_TYPE);
 
-   printLog("Creating response: %s\n", commandToString(controlEnvelope.command));
-   return createControlPacket(&controlEnvelope, false);
+   return encodeControlEnvelope(stream, &controlEnvelope);
 }
 
-packet_list_t *createResponseGetDeviceFeatures() 
+static bool encodeDeviceFeatures(pb_ostream_t *stream)
 {
    ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
    controlEnvelope.command = Command_GET_DEVICE_FEATURES;
@@ -303,11 +496,22 @@ packet_list_t *createResponseGetDeviceFeatures()
    deviceFeatures->features = 0x13; // Support Alexa Gadgets Toolkit and OTA.
    // deviceFeatures->features = 0x11; // Support Alexa Gadgets Toolkit
 
-   printLog("Creating response: %s\n", commandToString(controlEnvelope.command));
-   return createControlPacket(&controlEnvelope, false);
+   return encodeControlEnvelope(stream, &controlEnvelope);
+}
+
+bool createResponseGetDeviceInformation() 
+{
+   printLog("Creating response: %s\n", commandToString(Command_GET_DEVICE_INFORMATION));
+   return queueCachedResponse(CONTROL_STREAM, &cachedDeviceInformation, encodeDeviceInformation);
+}
+
+bool createResponseGetDeviceFeatures() 
+{
+   printLog("Creating response: %s\n", commandToString(Command_GET_DEVICE_FEATURES));
+   return queueCachedResponse(CONTROL_STREAM, &cachedDeviceFeatures, encodeDeviceFeatures);
 }
 
-packet_list_t *createResponseUpdateComponentSegment() 
+bool createResponseUpdateComponentSegment() 
 {
    ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
    controlEnvelope.command = Command_UPDATE_COMPONENT_SEGMENT;
@@ -318,7 +522,7 @@ packet_list_t *createResponseUpdateComponentSegment()
    return createControlPacket(&controlEnvelope, false);
 }
 
-packet_list_t *createResponseApplyFirmware() 
+bool createResponseApplyFirmware() 
 {
    ControlEnvelope controlEnvelope = ControlEnvelope_init_default;
    controlEnvelope.command = Command_APPLY_FIRMWARE;
@@ -329,61 +533,58 @@ packet_list_t *createResponseApplyFirmware()
    return createControlPacket(&controlEnvelope, false);
 }
 
-packet_list_t *CreateDiscoveryResponse() 
+// Event strings are encoded from where they already live rather than copied
+// into the message, so the string must outlive the pb_encode call.
+static pb_view_t stringView(char const *string)
 {
-   packet_list_t *packetList = NULL;
-   uint8_t *pBuf;
-   pb_ostream_t stream;
-   alexaDiscovery_DiscoverResponseEventProto *pResp;
-
-   printLog("Creating discover response event:\n");
-
-   printLog("sizeof(alexaDiscovery_DiscoverResponseEventProto): %u %u:\n",
-       sizeof(alexaDiscovery_DiscoverResponseEventProto),
-       sizeof(*pResp));
+   pb_view_t view = { (pb_byte_t const *) string, (pb_size_t) strlen(string) };
+   return view;
+}
 
-   pResp = (alexaDiscovery_DiscoverResponseEventProto *) 
-            malloc(sizeof(*pResp));
-   pBuf = malloc(BP_RESPONSE_BUF_LEN);
+static bool encodeDiscoveryResponse(pb_ostream_t *stream)
+{
+   bool status = false;
+   message_scratch_t *scratch = MessageScratch_acquire();
+   alexaDiscovery_DiscoverResponseEventProto *pResp = NULL;
 
    do {
-      if(pResp == NULL || pBuf == NULL) {
-         printLog("malloc failed\n");
+      if(scratch == NULL) {
+         printLog("Message scratch area in use\n");
          break;
       }
+      pResp = &scratch->discoverResponse;
       memset(pResp,0,sizeof(*pResp));
-      stream = pb_ostream_from_buffer(pBuf,BP_RESPONSE_BUF_LEN);
 
       pResp->has_event = true;
       pResp->event.has_header = true;
-      strcpy(pResp->event.header.namespace, "Alexa.Discovery");
-      strcpy(pResp->event.header.name, "Discover.Response");
+      pResp->event.header.namespace = stringView("Alexa.Discovery");
+      pResp->event.header.name = stringView("Discover.Response");
 
       pResp->event.has_payload = true;
       pResp->event.payload.endpoints_count = 1;
-      strcpy(pResp->event.payload.endpoints[0].endpointId,gAlexaSn);
-      strcpy(pResp->event.payload.endpoints[0].friendlyName,FRIENDLY_NAME);
-      strcpy(pResp->event.payload.endpoints[0].manufacturerName,MANUFACTURE_NAME);
+      pResp->event.payload.endpoints[0].endpointId = stringView(gAlexaSn);
+      pResp->event.payload.endpoints[0].friendlyName = stringView(FRIENDLY_NAME);
+      pResp->event.payload.endpoints[0].manufacturerName = stringView(MANUFACTURE_NAME);
 
       pResp->event.payload.endpoints[0].capabilities_count = 4;
-      strcpy(pResp->event.payload.endpoints[0].capabilities[0].type, "AlexaInterface");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[0].interface, "Notifications");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[0].version, "1.0");
+      pResp->event.payload.endpoints[0].capabilities[0].type = stringView("AlexaInterface");
+      pResp->event.payload.endpoints[0].capabilities[0].interface = stringView("Notifications");
+      pResp->event.payload.endpoints[0].capabilities[0].version = stringView("1.0");
 
-      strcpy(pResp->event.payload.endpoints[0].capabilities[1].type, "AlexaInterface");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[1].interface, "Custom.ThunderGadget");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[1].version, "1.0");
+      pResp->event.payload.endpoints[0].capabilities[1].type = stringView("AlexaInterface");
+      pResp->event.payload.endpoints[0].capabilities[1].interface = stringView("Custom.ThunderGadget");
+      pResp->event.payload.endpoints[0].capabilities[1].version = stringView("1.0");
 
-      strcpy(pResp->event.payload.endpoints[0].capabilities[2].type, "AlexaInterface");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[2].interface, "Alexa.Gadget.StateListener");
-      strcpy(pResp->event.payload.endpoints[0].capabilities[2].version, "1.0");
+      pResp->event.payload.endpoints[0].capabilities[2].type = stringView("AlexaInterface");
+      pResp->event.payload.endpoints[0].capabilities[2].interface = stringView("Alexa.Gadget.StateListener");
+      pResp->event.payload.endpoints[0].capabilities[2].version = stringView("1.0");
       pResp->event.payload.endpoints[0].capabilities[2].has_configuration = 1;
       pResp->event.payload.endpoints[0].capabilities[2].configuration.supportedTypes_count = 1;
-      strcpy(pResp->event.payload.endpoints[0].capabilities[2].configuration.supportedTypes[0].name,
-             "wakeword");
+      pResp->event.payload.endpoints[0].capabilities[2].configuration.supportedTypes[0].name =
+         stringView("wakeword");
 
       pResp->event.payload.endpoints[0].has_additionalIdentification = true;
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.firmwareVersion,gFwVer);
+      pResp->event.payload.endpoints[0].additionalIdentification.firmwareVersion = stringView(gFwVer);
 
       InitMusicData(&pResp->event.payload.endpoints[0].capabilities[3]);
 
@@ -391,37 +592,40 @@ packet_list_t *CreateDiscoveryResponse()
    // endpointId concatenated with the Alexa Gadget Secret that is shown in the 
    // developer portal after you register your gadget.
 
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.deviceToken,(const char *)gDeviceToken);
+      pResp->event.payload.endpoints[0].additionalIdentification.deviceToken = stringView((char const *) gDeviceToken);
    // The device secret algorithm. The only valid value is currently 1, which means that the algorithm is SHA256.
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.deviceTokenEncryptionType,"1");
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.amazonDeviceType,AMAZON_DEVICE_TYPE);
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.modelName,MODEL_NAME);
-      strcpy(pResp->event.payload.endpoints[0].additionalIdentification.radioAddress,&gAlexaSn[4]);
-
-      printLog("pResp: \n");
-      DumpHex(pResp,sizeof(*pResp));
-      bool status = pb_encode(&stream,alexaDiscovery_DiscoverResponseEventProto_fields,pResp);
-      if(!status) {
-         printLog("pb_encode failed: %s\n",PB_GET_ERROR(&stream));
-      }
-      else {
-         printLog("bytes written: %u\n",stream.bytes_written);
-         DumpHex(pBuf,stream.bytes_written);
-         free(pResp);
-         pResp = NULL;
-         packetList = buildStreamPacket(ALEXA_STREAM,false,pBuf,
-                                        stream.bytes_written);
-      }
+      pResp->event.payload.endpoints[0].additionalIdentification.deviceTokenEncryptionType = stringView("1");
+      pResp->event.payload.endpoints[0].additionalIdentification.amazonDeviceType = stringView(AMAZON_DEVICE_TYPE);
+      pResp->event.payload.endpoints[0].additionalIdentification.modelName = stringView(MODEL_NAME);
+      pResp->event.payload.endpoints[0].additionalIdentification.radioAddress = stringView(&gAlexaSn[4]);
+
+      size_t offset = stream->bytes_written;
+      uint32_t start = CodecStats_start();
+      status = pb_encode(stream,alexaDiscovery_DiscoverResponseEventProto_fields,pResp);
+      CodecStats_finish(CODEC_STATS_DISCOVERY_RESPONSE_ENCODE, start,
+                        stream->bytes_written - offset, status);
    } while(false);
 
-   if(pResp != NULL) {
-      free(pResp);
-   }
+   MessageScratch_release(scratch);
+   return status;
+}
 
-   if(pBuf != NULL) {
-      free(pBuf);
-   }
-   return packetList;
+bool CreateDiscoveryResponse() 
+{
+   printLog("Creating discover response event:\n");
+   return queueCachedResponse(ALEXA_STREAM, &cachedDiscoveryResponse, encodeDiscoveryResponse);
+}
+
+// Encodes the responses whose content is fixed once the gadget identity is
+// known. Anything that does not fit its cache is encoded on every request.
+// CheckDeviceName() calls this each time it sets gAlexaSn and gDeviceToken.
+void AlexaRefreshResponseCache(void)
+{
+   refreshCachedResponse(&cachedDeviceInformation, encodeDeviceInformation);
+   refreshCachedResponse(&cachedDeviceFeatures, encodeDeviceFeatures);
+   refreshCachedResponse(&cachedDiscoveryResponse, encodeDiscoveryResponse);
+   printLog("Response cache: device information %u, device features %u, discovery %u bytes\n",
+       cachedDeviceInformation.size, cachedDeviceFeatures.size, cachedDiscoveryResponse.size);
 }
 
 
@@ -429,81 +633,163 @@ void InitMusicData(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Ca
 {
    printLog("Adding AlexaInterface: Alexa.Gadget.MusicData\n");
 
-   strcpy(p->type,"AlexaInterface");
-   strcpy(p->interface,"Alexa.Gadget.MusicData");
-   strcpy(p->version,"1.0");
+   p->type = stringView("AlexaInterface");
+   p->interface = stringView("Alexa.Gadget.MusicData");
+   p->version = stringView("1.0");
    p->has_configuration = true;
    p->configuration.supportedTypes_count = 1;
-   strcpy(p->configuration.supportedTypes[0].name,"tempo");
+   p->configuration.supportedTypes[0].name = stringView("tempo");
 }
 
-void SendAlexaProtocolVerPkt()
+// Hands the pending notification to the stack. Returns false when the stack
+// is out of buffers and the notification has to be retried later.
+static bool sendPendingNotification(void)
 {
-   packet_t Pkt = createProtocolVersionPacket();
-   AlexaTxPacket(Pkt.data,Pkt.dataSize);
-   free(Pkt.data);
+   uint16_t result = AlexaTxPacket(txPending,txPendingSize);
+   if(result == bg_err_out_of_memory) {
+      gTxRetries++;
+      return false;
+   }
+   if(result != bg_err_success) {
+      printLog("Notification failed (0x%x), %u frames dropped\n",result,txPendingFrames);
+      gTxDroppedFrames += txPendingFrames;
+   }
+   txPendingSize = 0;
+   txPendingFrames = 0;
+   return true;
 }
 
-uint8_t CreateAlexaAdvertisingData(bool bPairingMode,uint8_t **pAdvData)
+int AlexaTxPump(void)
 {
-   packet_t Pkt = createAdvertisingPacket(bPairingMode);
-   *pAdvData = Pkt.data;
-
-   return (uint8_t) Pkt.dataSize;
+   size_t const fragmentSize = getFragmentSize();
+   int notifications = 0;
+   packet_t frame;
+
+   for(;;) {
+      while(TxRing_peek(&frame) &&
+            (txPendingSize == 0 || txPendingSize + frame.dataSize <= fragmentSize))
+      {
+         if(frame.dataSize > sizeof(txPending)) {
+            printLog("Frame too large [%u], dropped\n",frame.dataSize);
+            gTxDroppedFrames++;
+         }
+         else {
+            memcpy(&txPending[txPendingSize],frame.data,frame.dataSize);
+            txPendingSize += frame.dataSize;
+            txPendingFrames++;
+         }
+         TxRing_pop();
+      }
+      if(txPendingSize == 0 || !sendPendingNotification()) {
+         break;
+      }
+      notifications++;
+   }
+   return notifications;
 }
 
-void SendSensorData(int32_t F,uint32_t rhData)
+size_t AlexaTxQueueDepth(void)
 {
-   packet_list_t *packetList = NULL;
-   uint8_t *pBuf;
-   pb_ostream_t stream;
-   event_EventParserProto *pResp;
+   return TxRing_getDepth() + txPendingFrames;
+}
 
-   pResp = (event_EventParserProto *) malloc(sizeof(*pResp));
-   pBuf = malloc(BP_RESPONSE_BUF_LEN);
+void AlexaTxFlush(void)
+{
+   packet_t frame;
+
+   gTxDroppedFrames += txPendingFrames;
+   txPendingSize = 0;
+   txPendingFrames = 0;
+   while(TxRing_peek(&frame)) {
+      gTxDroppedFrames++;
+      TxRing_pop();
+   }
+}
 
-   do {
-      if(pResp == NULL || pBuf == NULL) {
-         printLog("malloc failed\n");
-         break;
+int sendPacketList(packet_list_t *list)
+{
+   for(packet_list_t const *node = list; node != NULL; node = node->next) {
+      if(!TxRing_enqueue(node->packet.data,node->packet.dataSize)) {
+         printLog("TX ring full, dropping %u byte packet\n",node->packet.dataSize);
+         gTxRejected++;
       }
-      memset(pResp,0,sizeof(*pResp));
-      stream = pb_ostream_from_buffer(pBuf,BP_RESPONSE_BUF_LEN);
+   }
+   PacketList_freeList(list);
+   return AlexaTxPump();
+}
 
-      pResp->has_event = true;
-      pResp->event.has_header = true;
-      strcpy(pResp->event.header.namespace, "Custom.ThunderGadget");
-      strcpy(pResp->event.header.name, "GetDataReport");
-      pResp->event.payload.size = 
-         snprintf((char *) pResp->event.payload.bytes,
-                  sizeof(pResp->event.payload.bytes),
-                  "{\"temperature\": %ld, \"RH\": %ld}",F, rhData);
-      printLog("Payload: \n");
-      DumpHex(pResp->event.payload.bytes,pResp->event.payload.size);
-
-      bool status = pb_encode(&stream,&event_EventParserProto_msg,pResp);
-      if(!status) {
-         printLog("pb_encode failed: %s\n",PB_GET_ERROR(&stream));
-      }
-      else {
-         printLog("bytes written: %u\n",stream.bytes_written);
-         DumpHex(pBuf,stream.bytes_written);
-         free(pResp);
-         pResp = NULL;
-         packetList = buildStreamPacket(ALEXA_STREAM,false,pBuf,
-                                        stream.bytes_written);
+static void sendProtocolVersion(void)
+{
+   packet_t Pkt = createProtocolVersionPacket();
+   protocolVersionPending = false;
+   if(Pkt.data != NULL) {
+      if(!TxRing_enqueue(Pkt.data,Pkt.dataSize)) {
+         gTxRejected++;
       }
-   } while(false);
+      freePacket(&Pkt);
+   }
+   AlexaTxPump();
+}
 
-   if(pResp != NULL) {
-      free(pResp);
+void SendAlexaProtocolVerPkt()
+{
+   if(mtuExchanged) {
+      sendProtocolVersion();
+   }
+   else if(!protocolVersionPending) {
+      protocolVersionPending = true;
+      gecko_cmd_hardware_set_soft_timer(MTU_EXCHANGE_TIMEOUT, PROTOCOL_VERSION_TIMER_HANDLE, 1);
    }
+}
+
+void AlexaProtocolVerTimeout(void)
+{
+   if(protocolVersionPending) {
+      printLog("No MTU exchange, sending protocol version at ATT MTU %u\n", attMtu);
+      sendProtocolVersion();
+   }
+}
 
-   if(pBuf != NULL) {
-      free(pBuf);
+uint8_t CreateAlexaAdvertisingData(bool bPairingMode,uint8_t **pAdvData)
+{
+   packet_t Pkt = createAdvertisingPacket(bPairingMode);
+   *pAdvData = Pkt.data;
+
+   return (uint8_t) Pkt.dataSize;
+}
+
+void SendSensorData(int32_t F,uint32_t rhData)
+{
+   fragment_sink_t sink;
+   pb_ostream_t stream;
+   event_EventParserProto event = event_EventParserProto_init_zero;
+   char payload[64];
+   int payloadSize;
+   uint32_t start;
+   bool status;
+
+   payloadSize = snprintf(payload,sizeof(payload),
+                          "{\"temperature\": %ld, \"RH\": %ld}",F, rhData);
+   if(payloadSize < 0 || (size_t) payloadSize >= sizeof(payload)) {
+      printLog("Payload too long\n");
+      return;
    }
 
-   AlexaTxPacket(packetList->packet.data,packetList->packet.dataSize);
-   PacketList_freeList(packetList);
+   event.has_event = true;
+   event.event.has_header = true;
+   event.event.header.namespace = stringView("Custom.ThunderGadget");
+   event.event.header.name = stringView("GetDataReport");
+   event.event.payload.bytes = (pb_byte_t const *) payload;
+   event.event.payload.size = (pb_size_t) payloadSize;
+   printLog("Payload: \n");
+   DumpHex(payload,payloadSize);
+
+   stream = openStreamPacket(&sink,ALEXA_STREAM,false);
+   start = CodecStats_start();
+   status = event_EventParserProto_encode(&stream,&event);
+   CodecStats_finish(CODEC_STATS_EVENT_ENCODE, start, stream.bytes_written, status);
+   finishStreamPacket(&sink,&stream,status);
+
+   AlexaTxPump();
 }
 
@@ -18,40 +18,40 @@ extern "C" {
 #endif
 
 /**
- * Create sample ApplyFirmware response as sent from Gadget.
+ * Queue sample ApplyFirmware response as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#apply-firmware-response
  */
-packet_list_t *createResponseApplyFirmware();
+bool createResponseApplyFirmware();
 
 /**
- * Create sample error response as sent from Gadget.
+ * Queue sample error response as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#response
  */
-packet_list_t *createResponseError(Command cmd, ErrorCode errorCode, uint16_t tag);
+bool createResponseError(Command cmd, ErrorCode errorCode, uint16_t tag);
 
 /**
- * Create sample GetDeviceFeatures response as sent from Gadget.
+ * Queue sample GetDeviceFeatures response as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#device-features-response
  */
-packet_list_t *createResponseGetDeviceFeatures();
+bool createResponseGetDeviceFeatures();
 
 /**
- * Create sample GetDeviceInformation response as sent from Gadget.
+ * Queue sample GetDeviceInformation response as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#device-information-response
  */
-packet_list_t *createResponseGetDeviceInformation();
+bool createResponseGetDeviceInformation();
 
 /**
- * Create sample UpdateComponentSegment response as sent from Gadget.
+ * Queue sample UpdateComponentSegment response as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#update-component-segment-response
  */
-packet_list_t *createResponseUpdateComponentSegment();
+bool createResponseUpdateComponentSegment();
 
 /**
- * Create sample Alexa.Discovery DiscoveryResponse as sent from Gadget.
+ * Queue sample Alexa.Discovery DiscoveryResponse as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/proto-buffer-format.html#event-proto-files
  */
-packet_list_t *CreateDiscoveryResponse();
+bool CreateDiscoveryResponse();
 
 /**
  * Create sample advertising packet payload as sent from Gadget.
@@ -62,19 +62,59 @@ packet_t createAdvertisingPacket(bool bPairingMode);
 /**
  * Create sample control ACK packet as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/packet-ble.html#ack-packet
+ * The data is allocated with PacketPool_alloc(); it is NULL when \p ack is
+ * false or the pool is empty.
  */
 packet_t
 createControlAckPacket(stream_id_t streamId, transaction_id_t transactionId, bool ack, control_ack_result_t result);
 
+/**
+ * Queue a control ACK packet, as built by createControlAckPacket(), in the TX ring.
+ * Nothing is queued when \p ack is false.
+ */
+void queueControlAck(stream_id_t streamId, transaction_id_t transactionId, bool ack, control_ack_result_t result);
+
 /**
  * Create sample Protocol Version packet as sent from Gadget.
  * https://developer.amazon.com/docs/alexa-gadgets-toolkit/bluetooth-le-settings.html#pvp
  */
 packet_t createProtocolVersionPacket();
 
-#ifdef COLOR_CYCLER_GADGET
-packet_list_t *CreateReportColor(char *Color);
-#endif
+/**
+ * Frames a payload as one transaction on \p streamId, a fragment per packet
+ * of getFragmentSize() bytes at most. Each fragment and list node comes from
+ * the packet pool.
+ * @param ack true to ask the Echo to acknowledge the transaction.
+ * @return the fragments in order, to be freed with PacketList_freeList(), or
+ *         NULL if the pool ran out of blocks.
+ */
+packet_list_t *buildStreamPacket(stream_id_t streamId, bool ack, uint8_t const *payload,
+                                 size_t payloadSize);
+
+/**
+ * Returns the largest packet that fits in one write or notification at the
+ * ATT MTU negotiated on the current connection.
+ * @sa AlexaSetAttMtu.
+ */
+size_t getFragmentSize(void);
+
+/**
+ * Sends the frames waiting in the TX ring. Consecutive frames are packed
+ * into one notification as long as they fit in getFragmentSize() bytes;
+ * the Echo parses several packets from one notification. Sending stops when
+ * the stack runs out of buffers; the unsent notification is kept and retried
+ * by the next call.
+ * @return the number of notifications accepted by the stack.
+ */
+int AlexaTxPump(void);
+
+/**
+ * Queues every packet in the list behind the frames already in the TX ring,
+ * frees the list and sends as much as the stack accepts.
+ * @param list the packets to send, in order.
+ * @return the number of notifications sent.
+ */
+int sendPacketList(packet_list_t *list);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,135 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <string.h>
+
+#include "common.h"
+#include "tx_ring.h"
+
+// Frames are stored back to back as a one byte length followed by the frame.
+// A frame never wraps; when it does not fit before the end of the buffer, a
+// zero length marks the rest of the buffer as padding and the frame starts
+// again at offset 0.
+static uint8_t txRing[SAMPLE_TX_RING_SIZE];
+static size_t txTail;          // oldest published frame
+static size_t txHead;          // end of the published frames
+static size_t txReserved;      // end of the reserved frames
+static size_t txUsed;          // bytes from txTail to txReserved, padding included
+static size_t txReservedBytes; // part of txUsed not yet published
+static size_t txFrames;
+static size_t txReservedFrames;
+static size_t txLastReserved;  // length byte of the newest reserved frame
+
+uint8_t *TxRing_reserve(size_t size)
+{
+   size_t position = txReserved;
+   size_t padding = 0;
+   size_t need = size + 1;
+
+   if(size == 0 || size > TX_RING_MAX_FRAME_SIZE) {
+      return NULL;
+   }
+   if(sizeof(txRing) - position < need) {
+      padding = sizeof(txRing) - position;
+      position = 0;
+   }
+   if(txUsed + padding + need > sizeof(txRing)) {
+      return NULL;
+   }
+   if(padding > 0) {
+      txRing[txReserved] = 0;
+   }
+   txRing[position] = (uint8_t) size;
+   txLastReserved = position;
+   txReserved = position + need;
+   txUsed += padding + need;
+   txReservedBytes += padding + need;
+   txReservedFrames++;
+   return &txRing[position + 1];
+}
+
+void TxRing_commit(void)
+{
+   txHead = txReserved;
+   txFrames += txReservedFrames;
+   txReservedFrames = 0;
+   txReservedBytes = 0;
+}
+
+void TxRing_trim(size_t size)
+{
+   size_t excess;
+
+   if(txReservedFrames == 0 || size == 0 || size > txRing[txLastReserved]) {
+      return;
+   }
+   excess = txRing[txLastReserved] - size;
+   txRing[txLastReserved] = (uint8_t) size;
+   txReserved -= excess;
+   txUsed -= excess;
+   txReservedBytes -= excess;
+}
+
+void TxRing_abort(void)
+{
+   txReserved = txHead;
+   txUsed -= txReservedBytes;
+   txReservedFrames = 0;
+   txReservedBytes = 0;
+}
+
+bool TxRing_enqueue(uint8_t const *data, size_t size)
+{
+   uint8_t *frame = TxRing_reserve(size);
+   if(frame == NULL) {
+      return false;
+   }
+   memcpy(frame, data, size);
+   TxRing_commit();
+   return true;
+}
+
+// Moves the tail past an end-of-buffer padding marker.
+static void skipPadding(void)
+{
+   if(txTail == sizeof(txRing) || txRing[txTail] == 0) {
+      txUsed -= sizeof(txRing) - txTail;
+      txTail = 0;
+   }
+}
+
+bool TxRing_peek(packet_t *frame)
+{
+   if(txFrames == 0) {
+      return false;
+   }
+   skipPadding();
+   frame->dataSize = txRing[txTail];
+   frame->data = &txRing[txTail + 1];
+   return true;
+}
+
+void TxRing_pop(void)
+{
+   if(txFrames == 0) {
+      return;
+   }
+   skipPadding();
+   size_t need = (size_t) txRing[txTail] + 1;
+   txTail += need;
+   txUsed -= need;
+   txFrames--;
+}
+
+size_t TxRing_getDepth(void)
+{
+   return txFrames;
+}
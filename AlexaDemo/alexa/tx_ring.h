@@ -0,0 +1,84 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_TX_RING_H
+#define ALEXA_GADGETS_SAMPLE_CODE_TX_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "helpers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Largest frame the ring accepts; the length prefix of each frame is one byte.
+ */
+#define TX_RING_MAX_FRAME_SIZE   0xffU
+
+/**
+ * Reserves contiguous space for one outbound frame. Reserved frames stay
+ * invisible to the sender until TxRing_commit() is called, so a transaction
+ * can be framed in place and published, or dropped, as a whole.
+ * @param size the frame length in bytes, at most TX_RING_MAX_FRAME_SIZE.
+ * @return where to write the frame, or NULL if the ring is full.
+ */
+uint8_t *TxRing_reserve(size_t size);
+
+/**
+ * Publishes every frame reserved since the last commit or abort.
+ */
+void TxRing_commit(void);
+
+/**
+ * Shortens the most recently reserved frame, returning the unused space.
+ * @param size the new frame length in bytes, at most the reserved length.
+ */
+void TxRing_trim(size_t size);
+
+/**
+ * Releases every frame reserved since the last commit or abort.
+ */
+void TxRing_abort(void);
+
+/**
+ * Copies a whole frame into the ring and publishes it.
+ * @param data the frame content.
+ * @param size the frame length in bytes.
+ * @return false if the frame did not fit.
+ */
+bool TxRing_enqueue(uint8_t const *data, size_t size);
+
+/**
+ * Returns the oldest published frame without removing it.
+ * @param frame set to point at the frame inside the ring.
+ * @return false if no frame is waiting.
+ */
+bool TxRing_peek(packet_t *frame);
+
+/**
+ * Removes the oldest published frame.
+ */
+void TxRing_pop(void);
+
+/**
+ * Returns the number of published frames waiting to be sent.
+ */
+size_t TxRing_getDepth(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_TX_RING_H
@@ -29,6 +29,10 @@
 #include "si7021.h"
 #include "app.h"
 #include "alexa.h"
+#include "codec_stats.h"
+#include "heap_guard.h"
+#include "packet_pool.h"
+#include "config.h"
 
 #define CON_NO_CONNECTION         0xFF
 
@@ -108,6 +112,7 @@ void appMain(gecko_configuration_t *pconfig)
        * Here the system is set to start advertising immediately after boot procedure. */
       case gecko_evt_system_boot_id:
         CheckDeviceName();
+        AlexaRxInit();
         bootMessage(&(evt->data.evt_system_boot));
         printLog("boot event - starting advertising\r\n");
     /*
@@ -121,6 +126,7 @@ void appMain(gecko_configuration_t *pconfig)
         ERR_CHK(gecko_cmd_sm_configure(0x0A,sm_io_capability_noinputnooutput));
         ERR_CHK(gecko_cmd_sm_store_bonding_configuration(2,1));
         ERR_CHK(gecko_cmd_sm_set_bondable_mode(1));
+        ERR_CHK(gecko_cmd_gatt_set_max_mtu(SAMPLE_MAX_ATT_MTU));
 
         SetAlexaAdvertisingData(!gAlexaPaired);
 
@@ -142,6 +148,9 @@ void appMain(gecko_configuration_t *pconfig)
         /* Start general advertising and enable connections. */
         gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_connectable_scannable);
         gecko_cmd_le_gap_start_advertising(1,le_gap_user_data,le_gap_connectable_scannable);
+
+        /* Everything after this runs from static or pool storage */
+        HeapGuard_initComplete();
         break;
 
       case gecko_evt_le_connection_opened_id:
@@ -151,9 +160,11 @@ void appMain(gecko_configuration_t *pconfig)
          }
          else {
             gConnection = evt->data.evt_le_connection_opened.connection;
+            AlexaResetAttMtu();
             if(evt->data.evt_le_connection_opened.bonding != 0xff) {
                gBonded = true;
             }
+            gecko_cmd_hardware_set_soft_timer(RX_SWEEP_INTERVAL,RX_SWEEP_TIMER_HANDLE,0);
          }
         break;
 
@@ -161,6 +172,22 @@ void appMain(gecko_configuration_t *pconfig)
         printLog("connection closed, reason: 0x%2.2x\r\n", evt->data.evt_le_connection_closed.reason);
         gConnection = CON_NO_CONNECTION;
         gBonded = false;
+        AlexaResetAttMtu();
+
+        /* Nothing in flight can complete without the link */
+        gecko_cmd_hardware_set_soft_timer(0,RX_SWEEP_TIMER_HANDLE,0);
+        AlexaRxExpireTransactions(true);
+        printLog("Rx expired transactions: %lu, reclaimed bytes: %lu\r\n",
+                 gRxExpiredTransactions,gRxReclaimedBytes);
+        gecko_cmd_hardware_set_soft_timer(0,TX_RETRY_TIMER_HANDLE,0);
+        gecko_cmd_hardware_set_soft_timer(0,PROTOCOL_VERSION_TIMER_HANDLE,0);
+        AlexaTxFlush();
+        printLog("Tx retries: %lu, rejected: %lu, dropped frames: %lu\r\n",
+                 gTxRetries,gTxRejected,gTxDroppedFrames);
+        CodecStats_print();
+        AlexaRxPrintDirectiveStats();
+        PacketPool_print();
+        HeapGuard_print();
 
         /* Check if need to boot to OTA DFU mode */
         if (boot_to_dfu) {
@@ -172,6 +199,12 @@ void appMain(gecko_configuration_t *pconfig)
         }
         break;
 
+      case gecko_evt_gatt_mtu_exchanged_id:
+        if(evt->data.evt_gatt_mtu_exchanged.connection == gConnection) {
+           AlexaSetAttMtu(evt->data.evt_gatt_mtu_exchanged.mtu);
+        }
+        break;
+
       /* Events related to OTA upgrading
          ----------------------------------------------------------------------------- */
 
@@ -270,6 +303,18 @@ void appMain(gecko_configuration_t *pconfig)
           break;
 
        case gecko_evt_hardware_soft_timer_id:
+          if(evt->data.evt_hardware_soft_timer.handle == RX_SWEEP_TIMER_HANDLE) {
+             AlexaRxExpireTransactions(false);
+             break;
+          }
+          if(evt->data.evt_hardware_soft_timer.handle == TX_RETRY_TIMER_HANDLE) {
+             /* Queue is pumped below */
+             break;
+          }
+          if(evt->data.evt_hardware_soft_timer.handle == PROTOCOL_VERSION_TIMER_HANDLE) {
+             AlexaProtocolVerTimeout();
+             break;
+          }
 
     	   /* Toggle LEDs on a timer event */
     	      if(gLedOn) {
@@ -285,6 +330,15 @@ void appMain(gecko_configuration_t *pconfig)
       default:
         break;
     }
+
+    /* Resume transmission the stack pushed back on. Any stack event may mean
+     * buffers were freed; the retry timer covers an otherwise idle link. */
+    if(AlexaTxQueueDepth() > 0 && gConnection != CON_NO_CONNECTION) {
+       AlexaTxPump();
+       if(AlexaTxQueueDepth() > 0) {
+          gecko_cmd_hardware_set_soft_timer(TX_RETRY_INTERVAL,TX_RETRY_TIMER_HANDLE,1);
+       }
+    }
   }
 }
 
@@ -421,27 +475,25 @@ void DumpHex(const void *AdrIn,int Len)
 
 void SetAlexaAdvertisingData(bool bPairingMode)
 {
-   static uint8_t *pAdvData = NULL;
+   uint8_t *pAdvData = NULL;
    uint8_t AdvDataLen;
 
    printLog("Creating broadcast data for %s mode:\r\n",
             bPairingMode ? "pairing" : "reconnect");
-   if(pAdvData != NULL) {
-      free(pAdvData);
-      pAdvData = NULL;
-   }
    AdvDataLen = CreateAlexaAdvertisingData(bPairingMode,&pAdvData);
 
    printLog("AdvDataLen: %d, pAdvData: %p\r\n",AdvDataLen,pAdvData);
    DumpHex(pAdvData,AdvDataLen);
+   /* The stack keeps its own copy, so the pool block goes straight back */
    ERR_CHK(gecko_cmd_le_gap_bt5_set_adv_data(1,0,AdvDataLen,pAdvData));
+   PacketPool_free(pAdvData);
 }
 
-void AlexaTxPacket(uint8_t *pData,uint8_t Len)
+uint16_t AlexaTxPacket(uint8_t *pData,uint8_t Len)
 {
    printLog("Alexa tx packet %d bytes:\r\n",Len);
-   gecko_cmd_gatt_server_send_characteristic_notification(
-      gConnection,gattdb_AlexaRx,Len,pData);
+   return gecko_cmd_gatt_server_send_characteristic_notification(
+      gConnection,gattdb_AlexaRx,Len,pData)->result;
 }
 
 // If the device name is the default (contains ????) then replace
@@ -487,6 +539,8 @@ void CheckDeviceName()
          sprintf((char*)&gDeviceToken[i * 2],"%02x",Temp[i]);
       }
       printLog("gDeviceToken: %s\r\n",gDeviceToken);
+   // The cached identity responses carry gAlexaSn and gDeviceToken
+      AlexaRefreshResponseCache();
    } while(false);
 }
 
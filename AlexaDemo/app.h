@@ -40,12 +40,28 @@
 #define printLog(...)
 #endif
 
+/* Soft timer handles */
+#define TEMPO_TIMER_HANDLE       0
+#define RX_SWEEP_TIMER_HANDLE    1
+#define TX_RETRY_TIMER_HANDLE    2
+#define PROTOCOL_VERSION_TIMER_HANDLE 3
+
+/* Reassembly expiry sweep interval, in 1/32768 s units */
+#define RX_SWEEP_INTERVAL        32768
+
+/* Delay before retrying notifications the stack had no buffers for, in 1/32768 s units */
+#define TX_RETRY_INTERVAL        328
+
+/* Longest wait for the MTU exchange before the protocol version packet is sent
+ * at the default MTU, in 1/32768 s units */
+#define MTU_EXCHANGE_TIMEOUT     32768
+
 extern uint8_t gConnection;
 extern bool gLedOn;
 
 /* Main application */
 void appMain(gecko_configuration_t *pconfig);
-void AlexaTxPacket(uint8_t *pData,uint8_t Len);
+uint16_t AlexaTxPacket(uint8_t *pData,uint8_t Len);
 void DumpHex(const void *AdrIn,int Len);
 void SetLeds(uint8_t Red,uint8_t Green,uint8_t Blue);
 
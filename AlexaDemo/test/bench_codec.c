@@ -0,0 +1,111 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// pb_decode() and pb_encode() over the recorded corpus: every message is
+// decoded as the gadget receives it and encoded back from the decoded struct.
+// One JSON line per message and direction, keys always in the same order, so
+// runs can be compared when nanopb options or the generated structs change.
+// Repeated fields are decoded into the directive arena, which is reported
+// next to the heap.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "directive_arena.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+#define ITERATIONS (20000U)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t reencoded[CORPUS_MAX_MESSAGE_SIZE];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+static __attribute__((noinline)) bool decode(corpus_entry_t const *entry, size_t size)
+{
+   pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+   DirectiveArena_begin();
+   return pb_decode(&stream, entry->fields, decoded.bytes);
+}
+
+static __attribute__((noinline)) size_t encode(corpus_entry_t const *entry)
+{
+   pb_ostream_t stream = pb_ostream_from_buffer(reencoded, sizeof(reencoded));
+   return pb_encode(&stream, entry->fields, decoded.bytes) ? stream.bytes_written : 0;
+}
+
+static void report(corpus_entry_t const *entry, char const *direction, size_t size,
+                   double ns, size_t stackPeak, size_t arenaBytes, bool status)
+{
+   printf("{\"bench\":\"codec\",\"message\":\"%s\",\"corpus\":\"%s\",\"origin\":\"%s\","
+          "\"direction\":\"%s\",\"ok\":%s,\"bytes\":%zu,\"ns_per_message\":%.1f,"
+          "\"bytes_per_s\":%.0f,\"stack_peak_bytes\":%zu,\"heap_allocations\":%.3f,"
+          "\"heap_peak_bytes\":%zu,\"arena_bytes\":%zu}\n",
+          entry->message, entry->name,
+          entry->direction == CORPUS_RECEIVED ? "received" : "sent",
+          direction, status ? "true" : "false", size, ns, (double) size * 1e9 / ns, stackPeak,
+          (double) Host_allocations / (ITERATIONS + 1), Host_heapPeak - Host_heapInUse, arenaBytes);
+}
+
+static void benchEntry(corpus_entry_t const *entry)
+{
+   size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+   size_t stackPeak;
+   size_t arenaBytes;
+   bool status;
+
+   if(size == 0) {
+      fprintf(stderr, "bench_codec: %s/%s.bin missing\n", CORPUS_DIRECTORY, entry->name);
+      return;
+   }
+
+   Host_resetAllocations();
+   Host_stackPaint();
+   status = decode(entry, size);
+   stackPeak = Host_stackPeak();
+   arenaBytes = DirectiveArena_getUsed();
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      decode(entry, size);
+   }
+   report(entry, "decode", size, (double) (Host_nowNs() - start) / ITERATIONS,
+          stackPeak, arenaBytes, status);
+
+   // The last decode is left in place to encode from.
+   Host_resetAllocations();
+   Host_stackPaint();
+   size_t encodedSize = encode(entry);
+   stackPeak = Host_stackPeak();
+   start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      encode(entry);
+   }
+   report(entry, "encode", encodedSize, (double) (Host_nowNs() - start) / ITERATIONS,
+          stackPeak, 0, status && encodedSize == size && memcmp(encoded, reencoded, size) == 0);
+   DirectiveArena_reset();
+}
+
+int main(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      benchEntry(&Corpus_entries[e]);
+   }
+   return 0;
+}
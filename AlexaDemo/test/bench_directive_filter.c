@@ -0,0 +1,142 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Cycles per streamed directive with and without the header filter, over a
+// mix of the recorded directives and directives nothing is routed to. The
+// routes are the ones rx.c registers.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "corpus.h"
+#include "directive_router.h"
+#include "directive_stream.h"
+#include "helpers.h"
+#include "host.h"
+
+#define ITERATIONS (20000U)
+#define FRAGMENT_SIZE (240U)
+
+static void handleDirective(uint8_t const *payload, size_t payloadSize)
+{
+}
+
+static directive_route_t routes[] = {
+   DIRECTIVE_ROUTE("Alexa.Discovery",            "Discover",       handleDirective),
+   DIRECTIVE_ROUTE("Alexa.Gadget.MusicData",     "Tempo",          handleDirective),
+   DIRECTIVE_ROUTE("Alexa.Gadget.StateListener", "StateUpdate",    handleDirective),
+   DIRECTIVE_ROUTE("Custom.ThunderGadget",       "GetData",        handleDirective),
+   DIRECTIVE_ROUTE("Notifications",              "ClearIndicator", handleDirective),
+};
+
+static directive_router_t router = DIRECTIVE_ROUTER(routes);
+static directive_stream_t directive;
+
+typedef struct {
+   char const *name;
+   size_t size;
+   uint8_t encoded[DIRECTIVE_STREAM_PAYLOAD_SIZE + 128];
+} directive_case_t;
+
+static directive_case_t cases[8];
+static size_t caseCount;
+
+static bool acceptDirective(header_DirectiveHeaderProto const *header)
+{
+   return DirectiveRouter_accepts(&router, header);
+}
+
+static void addRecorded(char const *name)
+{
+   directive_case_t *c = &cases[caseCount++];
+   c->name = name;
+   c->size = Corpus_load(name, c->encoded, sizeof(c->encoded));
+}
+
+static void addUnrouted(char const *name, char const *ns, char const *directiveName,
+                        size_t payloadSize)
+{
+   static uint8_t payload[DIRECTIVE_STREAM_PAYLOAD_SIZE];
+   directive_case_t *c = &cases[caseCount++];
+   c->name = name;
+   c->size = Host_encodeDirective(c->encoded, sizeof(c->encoded), ns, directiveName,
+                                  payload, payloadSize);
+}
+
+static void feed(directive_case_t const *c, directive_stream_filter_t filter)
+{
+   DirectiveStream_reset(&directive, filter);
+   for(size_t offset = 0; offset < c->size; offset += FRAGMENT_SIZE) {
+      DirectiveStream_feed(&directive, &c->encoded[offset], MIN(FRAGMENT_SIZE, c->size - offset));
+   }
+   DirectiveStream_finish(&directive);
+}
+
+// Returns the cycles per directive for one case, or for the whole mix in
+// turn when c is NULL.
+static double measure(directive_case_t const *c, directive_stream_filter_t filter, double *ns)
+{
+   uint32_t directives = 0;
+   uint64_t startCycles = Host_cycles();
+   uint64_t start = Host_nowNs();
+
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      if(c != NULL) {
+         feed(c, filter);
+         directives++;
+      }
+      else {
+         for(size_t k = 0; k < caseCount; k++) {
+            feed(&cases[k], filter);
+            directives++;
+         }
+      }
+   }
+   *ns = (double) (Host_nowNs() - start) / directives;
+   return (double) (Host_cycles() - startCycles) / directives;
+}
+
+static void report(char const *name, size_t size, directive_case_t const *c)
+{
+   double nsAll;
+   double nsFiltered;
+   double cyclesAll = measure(c, NULL, &nsAll);
+   double cyclesFiltered = measure(c, acceptDirective, &nsFiltered);
+
+   printf("{\"bench\":\"directive_filter\",\"case\":\"%s\",\"bytes\":%zu,"
+          "\"ns_unfiltered\":%.1f,\"ns_filtered\":%.1f,"
+          "\"cycles_unfiltered\":%.0f,\"cycles_filtered\":%.0f}\n",
+          name, size, nsAll, nsFiltered, cyclesAll, cyclesFiltered);
+}
+
+int main(void)
+{
+   size_t total = 0;
+
+   DirectiveRouter_init(&router);
+   addRecorded("directive_discover");
+   addRecorded("directive_state_update");
+   addRecorded("directive_tempo");
+   addRecorded("directive_get_data");
+   addRecorded("directive_clear_indicator");
+   addUnrouted("unrouted_speechmarks", "Alexa.Gadget.SpeechData", "Speechmarks", 300);
+   addUnrouted("unrouted_set_indicator", "Notifications", "SetIndicator", 100);
+   addUnrouted("unrouted_2000_bytes", "Custom.Unrouted", "Ignored", 2000);
+
+   for(size_t k = 0; k < caseCount; k++) {
+      report(cases[k].name, cases[k].size, &cases[k]);
+      total += cases[k].size;
+   }
+   report("mixed", total / caseCount, NULL);
+   return 0;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Discovery round trip: an Alexa.Discovery/Discover directive written by the
+// Echo until the last notification of the response is handed to the stack.
+// Measured with the response encoded on every request, then answered from the
+// response cache.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+#define ITERATIONS (20000U)
+
+static uint8_t discover[128];
+static size_t discoverSize;
+static uint8_t writes[16][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[16];
+
+static void benchDiscovery(char const *mode, uint16_t mtu)
+{
+   AlexaSetAttMtu(mtu);
+   size_t count = Host_frameTransaction(writes, writeSizes, ARRAY_SIZE(writes), ALEXA_STREAM, 0, true,
+                                        discover, discoverSize, getFragmentSize() - 7);
+
+   Host_resetAllocations();
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      Host_resetNotifications();
+      for(size_t w = 0; w < count; w++) {
+         AlexaRxPacket(writes[w], (uint8_t) writeSizes[w]);
+      }
+   }
+   double nsPerDiscovery = (double) (Host_nowNs() - start) / ITERATIONS;
+
+   printf("{\"bench\":\"discovery\",\"mode\":\"%s\",\"mtu\":%u,\"writes\":%zu,\"notifications\":%zu,"
+          "\"ns_per_discovery\":%.1f,\"allocations_per_discovery\":%.3f}\n",
+          mode, mtu, count, Host_notificationCount, nsPerDiscovery,
+          (double) Host_allocations / ITERATIONS);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   discoverSize = Host_encodeDirective(discover, sizeof(discover), "Alexa.Discovery", "Discover", NULL, 0);
+
+   benchDiscovery("encoded", SAMPLE_DEFAULT_ATT_MTU);
+   benchDiscovery("encoded", SAMPLE_MAX_ATT_MTU);
+   AlexaRefreshResponseCache();
+   benchDiscovery("cached", SAMPLE_DEFAULT_ATT_MTU);
+   benchDiscovery("cached", SAMPLE_MAX_ATT_MTU);
+   return 0;
+}
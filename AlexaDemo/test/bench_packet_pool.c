@@ -0,0 +1,137 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Time per packet pool allocation and free under a random mix of block sizes,
+// and per packet list built and freed. The spread between the mean and the
+// slowest calls shows that the time does not grow with pool history; the
+// blocks still free at the end show that none were lost.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "packet_pool.h"
+#include "tx.h"
+
+#define CYCLES        (2000000U)
+#define TOTAL_BLOCKS  (SAMPLE_PACKET_POOL_NODES + SAMPLE_PACKET_POOL_SHORT_PACKETS + \
+                       SAMPLE_PACKET_POOL_FRAGMENTS)
+#define BUCKETS       (4096U)
+
+typedef struct {
+   uint64_t count;
+   uint64_t totalNs;
+   uint64_t maxNs;
+   uint32_t histogram[BUCKETS];   // 1 ns buckets, the last one open ended
+} latency_t;
+
+static latency_t allocLatency;
+static latency_t freeLatency;
+static latency_t listLatency;
+
+static void record(latency_t *latency, uint64_t ns)
+{
+   latency->count++;
+   latency->totalNs += ns;
+   latency->maxNs = MAX(latency->maxNs, ns);
+   latency->histogram[MIN(ns, BUCKETS - 1)]++;
+}
+
+static uint64_t percentile(latency_t const *latency, double fraction)
+{
+   uint64_t target = (uint64_t) (fraction * (double) latency->count);
+   uint64_t seen = 0;
+   for(size_t i = 0; i < BUCKETS; i++) {
+      seen += latency->histogram[i];
+      if(seen >= target) return i;
+   }
+   return BUCKETS - 1;
+}
+
+static void print(char const *op, latency_t const *latency, size_t blocksFree)
+{
+   printf("{\"bench\":\"packet_pool\",\"op\":\"%s\",\"calls\":%llu,\"mean_ns\":%.1f,"
+          "\"p50_ns\":%llu,\"p9999_ns\":%llu,\"max_ns\":%llu,\"heap_allocations\":%lu,"
+          "\"blocks_free_after\":%zu,\"blocks\":%u}\n",
+          op, (unsigned long long) latency->count,
+          (double) latency->totalNs / (double) latency->count,
+          (unsigned long long) percentile(latency, 0.5),
+          (unsigned long long) percentile(latency, 0.9999),
+          (unsigned long long) latency->maxNs, (unsigned long) Host_allocations,
+          blocksFree, TOTAL_BLOCKS);
+}
+
+// Allocates single bytes until the pools are empty, then frees them again.
+static size_t countFreeBlocks(void)
+{
+   static void *blocks[TOTAL_BLOCKS + 1];
+   size_t count = 0;
+   while(count <= TOTAL_BLOCKS && (blocks[count] = PacketPool_alloc(1)) != NULL) {
+      count++;
+   }
+   for(size_t i = 0; i < count; i++) {
+      PacketPool_free(blocks[i]);
+   }
+   return count;
+}
+
+int main(void)
+{
+   static size_t const sizes[] = {
+      CONTROL_PACKET_LENGTH, sizeof(packet_list_t), PROTOCOL_VERSION_PACKET_SIZE,
+      ADV_DATA_LEN, SAMPLE_DEFAULT_ATT_MTU - ATT_HEADER_SIZE, SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE,
+   };
+   static void *live[TOTAL_BLOCKS];
+   static uint8_t payload[600];
+   size_t liveCount = 0;
+
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   srand(1);
+   Host_resetAllocations();
+   for(uint32_t cycle = 0; cycle < CYCLES; cycle++) {
+      if(liveCount > 0 && (liveCount == TOTAL_BLOCKS || (rand() & 1))) {
+         size_t victim = (size_t) rand() % liveCount;
+         void *block = live[victim];
+         live[victim] = live[--liveCount];
+         uint64_t start = Host_nowNs();
+         PacketPool_free(block);
+         record(&freeLatency, Host_nowNs() - start);
+         continue;
+      }
+      size_t size = sizes[(size_t) rand() % ARRAY_SIZE(sizes)];
+      uint64_t start = Host_nowNs();
+      void *block = PacketPool_alloc(size);
+      record(&allocLatency, Host_nowNs() - start);
+      if(block != NULL) {
+         live[liveCount++] = block;
+      }
+   }
+   while(liveCount > 0) {
+      PacketPool_free(live[--liveCount]);
+   }
+   size_t blocksFree = countFreeBlocks();
+   print("alloc", &allocLatency, blocksFree);
+   print("free", &freeLatency, blocksFree);
+
+   Host_resetAllocations();
+   for(uint32_t cycle = 0; cycle < CYCLES / 4; cycle++) {
+      uint64_t start = Host_nowNs();
+      PacketList_freeList(buildStreamPacket(ALEXA_STREAM, true, payload, 1 + cycle % sizeof(payload)));
+      record(&listLatency, Host_nowNs() - start);
+   }
+   print("build_and_free_list", &listLatency, countFreeBlocks());
+   return 0;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Encode cost of the nested responses with submessages encoded once in place
+// (memory buffer streams) against the sizing pass every other stream takes.
+// Cycles come from the time stamp counter where the host has one.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "directive_arena.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+#define ITERATIONS (50000U)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t output[CORPUS_MAX_MESSAGE_SIZE];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+static bool writeCallback(pb_ostream_t *stream, pb_byte_t const *buf, size_t count)
+{
+   memcpy(stream->state, buf, count);
+   stream->state = (uint8_t *) stream->state + count;
+   return true;
+}
+
+static void benchMessage(char const *name, pb_msgdesc_t const *fields)
+{
+   size_t size = Corpus_load(name, encoded, sizeof(encoded));
+   pb_istream_t input = pb_istream_from_buffer(encoded, size);
+   double ns[2];
+   double cyclesPerEncode[2];
+
+   DirectiveArena_begin();
+   if(size == 0 || !pb_decode(&input, fields, decoded.bytes)) {
+      fprintf(stderr, "bench_pb_encode: %s not decoded\n", name);
+      return;
+   }
+   for(int twoPass = 0; twoPass < 2; twoPass++) {
+      uint64_t startCycles = Host_cycles();
+      uint64_t start = Host_nowNs();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         pb_ostream_t stream = pb_ostream_from_buffer(output, sizeof(output));
+         if(twoPass) {
+            stream.callback = writeCallback;
+            stream.state = output;
+         }
+         pb_encode(&stream, fields, decoded.bytes);
+      }
+      ns[twoPass] = (double) (Host_nowNs() - start) / ITERATIONS;
+      cyclesPerEncode[twoPass] = (double) (Host_cycles() - startCycles) / ITERATIONS;
+   }
+   printf("{\"bench\":\"pb_encode\",\"corpus\":\"%s\",\"bytes\":%zu,"
+          "\"ns_single_pass\":%.1f,\"ns_two_pass\":%.1f,"
+          "\"cycles_single_pass\":%.0f,\"cycles_two_pass\":%.0f}\n",
+          name, size, ns[0], ns[1], cyclesPerEncode[0], cyclesPerEncode[1]);
+   DirectiveArena_reset();
+}
+
+int main(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      if(strcmp(Corpus_entries[e].message, "alexaDiscovery_DiscoverResponseEventProto") == 0 ||
+         strcmp(Corpus_entries[e].message, "ControlEnvelope") == 0)
+      {
+         benchMessage(Corpus_entries[e].name, Corpus_entries[e].fields);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Field lookup by tag through the descriptor's tag table against the search
+// that pb_field_iter_find() used to do: advance from the current field,
+// wrapping around, until the tag matches. Each lookup starts where the
+// previous one left off, as it does while decoding. Whole message decode
+// times for the same descriptors follow.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "accessories.pb.h"
+#include "alexaDiscoveryDiscoverResponseEventPayload.pb.h"
+#include "corpus.h"
+#include "directive_arena.h"
+#include "directiveParser.pb.h"
+#include "host.h"
+#include "pb_common.h"
+#include "pb_decode.h"
+
+#define ITERATIONS (200000U)
+#define MAX_FIELDS (32U)
+
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} message;
+
+static bool searchField(pb_field_iter_t *iter, uint32_t tag)
+{
+   pb_size_t start = iter->index;
+   do {
+      pb_field_iter_next(iter);
+      if(iter->tag == tag) {
+         return true;
+      }
+   } while(iter->index != start);
+   return false;
+}
+
+static void benchLookup(char const *name, pb_msgdesc_t const *fields)
+{
+   uint32_t tags[MAX_FIELDS];
+   size_t tagCount = 0;
+   pb_field_iter_t iter;
+   double cycles[2];
+
+   pb_field_iter_begin(&iter, fields, message.bytes);
+   do {
+      tags[tagCount++] = iter.tag;
+   } while(pb_field_iter_next(&iter) && tagCount < MAX_FIELDS);
+
+   for(int search = 0; search < 2; search++) {
+      pb_field_iter_begin(&iter, fields, message.bytes);
+      uint64_t start = Host_cycles();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         // Fields in reverse order, the worst case for the search.
+         uint32_t tag = tags[tagCount - 1 - i % tagCount];
+         if(search) {
+            searchField(&iter, tag);
+         }
+         else {
+            pb_field_iter_find(&iter, tag);
+         }
+      }
+      cycles[search] = (double) (Host_cycles() - start) / ITERATIONS;
+   }
+   printf("{\"bench\":\"pb_field_find\",\"message\":\"%s\",\"fields\":%zu,"
+          "\"cycles_table\":%.1f,\"cycles_search\":%.1f}\n",
+          name, tagCount, cycles[0], cycles[1]);
+}
+
+static void benchDecode(corpus_entry_t const *entry)
+{
+   static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+   size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+
+   uint64_t startCycles = Host_cycles();
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS / 10; i++) {
+      pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+      DirectiveArena_begin();
+      pb_decode(&stream, entry->fields, message.bytes);
+   }
+   DirectiveArena_reset();
+   printf("{\"bench\":\"pb_field_find\",\"message\":\"%s\",\"corpus\":\"%s\",\"bytes\":%zu,"
+          "\"ns_decode\":%.1f,\"cycles_decode\":%.0f}\n",
+          entry->message, entry->name, size, (double) (Host_nowNs() - start) / (ITERATIONS / 10),
+          (double) (Host_cycles() - startCycles) / (ITERATIONS / 10));
+}
+
+int main(void)
+{
+   benchLookup("ControlEnvelope", ControlEnvelope_fields);
+   benchLookup("Response", Response_fields);
+   benchLookup("directive_DirectiveParserProto_Directive", directive_DirectiveParserProto_Directive_fields);
+   benchLookup("alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints",
+               alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_fields);
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      if(strcmp(Corpus_entries[e].message, "ControlEnvelope") == 0 ||
+         strcmp(Corpus_entries[e].message, "directive_DirectiveParserProto") == 0)
+      {
+         benchDecode(&Corpus_entries[e]);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Cycles per decode with pb_decode(), which sets the whole destination to its
+// defaults first, against PB_DECODE_NOCLEAR, which only resets presence, for
+// every message in the corpus.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "corpus.h"
+#include "directive_arena.h"
+#include "host.h"
+#include "pb_decode.h"
+
+#define ITERATIONS (50000U)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+static void benchEntry(corpus_entry_t const *entry)
+{
+   static unsigned int const flags[] = { 0, PB_DECODE_NOCLEAR };
+   size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+   double cycles[2];
+   double ns[2];
+
+   for(int f = 0; f < 2; f++) {
+      uint64_t startCycles = Host_cycles();
+      uint64_t start = Host_nowNs();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+         DirectiveArena_begin();
+         pb_decode_ex(&stream, entry->fields, decoded.bytes, flags[f]);
+         DirectiveArena_reset();
+      }
+      ns[f] = (double) (Host_nowNs() - start) / ITERATIONS;
+      cycles[f] = (double) (Host_cycles() - startCycles) / ITERATIONS;
+   }
+   printf("{\"bench\":\"pb_noclear\",\"message\":\"%s\",\"corpus\":\"%s\",\"bytes\":%zu,"
+          "\"ns_init\":%.1f,\"ns_noclear\":%.1f,"
+          "\"cycles_init\":%.0f,\"cycles_noclear\":%.0f}\n",
+          entry->message, entry->name, size,
+          ns[0], ns[1], cycles[0], cycles[1]);
+}
+
+int main(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      benchEntry(&Corpus_entries[e]);
+   }
+   return 0;
+}
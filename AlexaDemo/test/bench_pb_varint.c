@@ -0,0 +1,135 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Varint decoding straight from memory buffers against the byte by byte
+// decoder that streams with their own read callback take: a run of mixed
+// length varints, then every message the gadget receives in the corpus.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "directive_arena.h"
+#include "host.h"
+#include "pb_decode.h"
+
+#define ITERATIONS (50000U)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+static bool readCallback(pb_istream_t *stream, pb_byte_t *buf, size_t count)
+{
+   memcpy(buf, stream->state, count);
+   stream->state = (pb_byte_t *) stream->state + count;
+   return true;
+}
+
+static pb_istream_t openStream(bool callback, uint8_t const *buffer, size_t size)
+{
+   pb_istream_t stream = pb_istream_from_buffer(buffer, size);
+   if(callback) {
+      stream.callback = readCallback;
+   }
+   return stream;
+}
+
+static void report(char const *name, size_t size, double const *cycles, double const *ns)
+{
+   printf("{\"bench\":\"pb_varint\",\"input\":\"%s\",\"bytes\":%zu,"
+          "\"ns_buffer\":%.1f,\"ns_callback\":%.1f,"
+          "\"cycles_buffer\":%.0f,\"cycles_callback\":%.0f}\n",
+          name, size, ns[0], ns[1], cycles[0], cycles[1]);
+}
+
+static bool decodes(bool callback, corpus_entry_t const *entry, size_t size)
+{
+   pb_istream_t stream = openStream(callback, encoded, size);
+   DirectiveArena_begin();
+   bool status = pb_decode(&stream, entry->fields, decoded.bytes);
+   DirectiveArena_reset();
+   return status;
+}
+
+static void benchVarints(void)
+{
+   static uint8_t varints[512];
+   size_t size = 0;
+   uint32_t value = 1;
+   double cycles[2];
+   double ns[2];
+
+   // 1 to 3 byte values, as tags, lengths and enums are in directives.
+   while(size + 3 <= sizeof(varints)) {
+      value = (value * 1103515245U + 12345U) & 0x1FFFFFU;
+      uint32_t v = value >> (7 * (value % 3));
+      do {
+         varints[size++] = (uint8_t) ((v & 0x7F) | (v > 0x7F ? 0x80 : 0));
+         v >>= 7;
+      } while(v != 0);
+   }
+   for(int callback = 0; callback < 2; callback++) {
+      uint64_t startCycles = Host_cycles();
+      uint64_t start = Host_nowNs();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         pb_istream_t stream = openStream(callback, varints, size);
+         while(stream.bytes_left > 0 && pb_decode_varint32(&stream, &value)) {
+         }
+      }
+      ns[callback] = (double) (Host_nowNs() - start) / ITERATIONS;
+      cycles[callback] = (double) (Host_cycles() - startCycles) / ITERATIONS;
+   }
+   report("mixed_varints", size, cycles, ns);
+}
+
+static void benchMessage(corpus_entry_t const *entry)
+{
+   size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+   double cycles[2];
+   double ns[2];
+
+   // Views into the input need a memory buffer, so messages with view
+   // fields cannot be decoded from a callback stream.
+   if(!decodes(false, entry, size) || !decodes(true, entry, size)) {
+      return;
+   }
+
+   for(int callback = 0; callback < 2; callback++) {
+      uint64_t startCycles = Host_cycles();
+      uint64_t start = Host_nowNs();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         pb_istream_t stream = openStream(callback, encoded, size);
+         DirectiveArena_begin();
+         pb_decode(&stream, entry->fields, decoded.bytes);
+         DirectiveArena_reset();
+      }
+      ns[callback] = (double) (Host_nowNs() - start) / ITERATIONS;
+      cycles[callback] = (double) (Host_cycles() - startCycles) / ITERATIONS;
+   }
+   report(entry->name, size, cycles, ns);
+}
+
+int main(void)
+{
+   benchVarints();
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      if(Corpus_entries[e].direction == CORPUS_RECEIVED) {
+         benchMessage(&Corpus_entries[e]);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Cost per received fragment and heap allocations per transaction for
+// transactions reassembled in the RX slots.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+#define ITERATIONS (20000U)
+
+static uint8_t writes[64][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[64];
+
+static void benchTransaction(char const *name, stream_id_t streamId,
+                             uint8_t const *payload, size_t payloadSize,
+                             size_t fragmentPayload)
+{
+   size_t count = Host_frameTransaction(writes, writeSizes, ARRAY_SIZE(writes), streamId, 0,
+                                        true, payload, payloadSize, fragmentPayload);
+
+   Host_resetAllocations();
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      Host_resetNotifications();
+      for(size_t w = 0; w < count; w++) {
+         AlexaRxPacket(writes[w], (uint8_t) writeSizes[w]);
+      }
+   }
+   uint64_t elapsed = Host_nowNs() - start;
+
+   printf("{\"bench\":\"rx_reassembly\",\"case\":\"%s\",\"bytes\":%zu,\"fragments\":%zu,"
+          "\"ns_per_fragment\":%.1f,\"allocations_per_transaction\":%.3f}\n",
+          name, payloadSize, count, (double) elapsed / ((double) ITERATIONS * count),
+          (double) Host_allocations / ITERATIONS);
+}
+
+int main(void)
+{
+   static uint8_t payload[4000];
+   static uint8_t directive[4200];
+   uint8_t command[32];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_FEATURES);
+   size_t directiveSize = Host_encodeDirective(directive, sizeof(directive), "Custom.Unrouted",
+                                               "Ignored", payload, sizeof(payload));
+
+   AlexaRxInit();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   benchTransaction("control_command_1_byte_fragments", CONTROL_STREAM, command, commandSize, 1);
+   benchTransaction("control_command_single_fragment", CONTROL_STREAM, command, commandSize, 240);
+   benchTransaction("unrouted_directive_4000_bytes", ALEXA_STREAM, directive, directiveSize, 240);
+   return 0;
+}
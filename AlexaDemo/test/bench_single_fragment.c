@@ -0,0 +1,61 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Latency per control command when the command arrives in one fragment and
+// is handled from the write buffer, against the same command reassembled from
+// two fragments.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+#define ITERATIONS (20000U)
+
+static uint8_t writes[8][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[8];
+
+static void benchCommand(char const *name, Command command)
+{
+   uint8_t payload[32];
+   size_t payloadSize = Host_encodeCommand(payload, sizeof(payload), command);
+   static size_t const fragmentPayloads[] = { SAMPLE_MAX_ATT_MTU, 1 };
+   double nsPerCommand[ARRAY_SIZE(fragmentPayloads)];
+
+   for(size_t f = 0; f < ARRAY_SIZE(fragmentPayloads); f++) {
+      size_t count = Host_frameTransaction(writes, writeSizes, ARRAY_SIZE(writes),
+                                           CONTROL_STREAM, 0, true, payload, payloadSize,
+                                           fragmentPayloads[f]);
+      uint64_t start = Host_nowNs();
+      for(uint32_t i = 0; i < ITERATIONS; i++) {
+         Host_resetNotifications();
+         for(size_t w = 0; w < count; w++) {
+            AlexaRxPacket(writes[w], (uint8_t) writeSizes[w]);
+         }
+      }
+      nsPerCommand[f] = (double) (Host_nowNs() - start) / ITERATIONS;
+   }
+   printf("{\"bench\":\"single_fragment\",\"command\":\"%s\",\"ns_single_fragment\":%.1f,"
+          "\"ns_reassembled\":%.1f}\n", name, nsPerCommand[0], nsPerCommand[1]);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   benchCommand("GET_DEVICE_INFORMATION", Command_GET_DEVICE_INFORMATION);
+   benchCommand("GET_DEVICE_FEATURES", Command_GET_DEVICE_FEATURES);
+   return 0;
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Cost of every response type, encoded straight into TX fragments and then,
+// where a response is cached, framed from its cached encoding. Stack and heap
+// high-water marks cover building the response and handing it to the stack.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+#define ITERATIONS (20000U)
+
+typedef struct {
+   char const *name;
+   bool (*create)(void);
+   char const *mode;          // "encoded" by pb_encode, "raw" when built by hand
+} response_t;
+
+static bool createErrorResponse(void)
+{
+   return createResponseError(Command_UPDATE_COMPONENT_SEGMENT, ErrorCode_UNSUPPORTED, 0);
+}
+
+static bool createSensorData(void)
+{
+   SendSensorData(72, 40);
+   return true;
+}
+
+static bool createProtocolVersion(void)
+{
+   SendAlexaProtocolVerPkt();
+   return true;
+}
+
+static bool createControlAck(void)
+{
+   packet_t ack = createControlAckPacket(ALEXA_STREAM, 1, true, CONTROL_PACKET_RESULT_SUCCESS);
+   return sendPacketList(PacketList_addToTail(NULL, &ack)) > 0;
+}
+
+static response_t const responses[] = {
+   { "GET_DEVICE_INFORMATION", createResponseGetDeviceInformation, "encoded" },
+   { "GET_DEVICE_FEATURES", createResponseGetDeviceFeatures, "encoded" },
+   { "UPDATE_COMPONENT_SEGMENT", createResponseUpdateComponentSegment, "encoded" },
+   { "APPLY_FIRMWARE", createResponseApplyFirmware, "encoded" },
+   { "error", createErrorResponse, "encoded" },
+   { "Discover.Response", CreateDiscoveryResponse, "encoded" },
+   { "GetDataReport", createSensorData, "encoded" },
+   { "protocol_version", createProtocolVersion, "raw" },
+   { "control_ack", createControlAck, "raw" },
+};
+
+static __attribute__((noinline)) void respond(response_t const *response)
+{
+   Host_resetNotifications();
+   response->create();
+   AlexaTxPump();
+}
+
+static void benchResponse(response_t const *response, char const *mode)
+{
+   size_t bytes;
+   size_t stackPeak;
+
+   Host_resetAllocations();
+   Host_stackPaint();
+   respond(response);
+   stackPeak = Host_stackPeak();
+   bytes = 0;
+   for(size_t n = 0; n < Host_notificationCount; n++) {
+      bytes += Host_notificationLengths[n];
+   }
+
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      respond(response);
+   }
+   double nsPerResponse = (double) (Host_nowNs() - start) / ITERATIONS;
+
+   printf("{\"bench\":\"tx_encode\",\"response\":\"%s\",\"mode\":\"%s\",\"bytes\":%zu,"
+          "\"ns_per_response\":%.1f,\"stack_peak_bytes\":%zu,\"heap_peak_bytes\":%zu,"
+          "\"allocations_per_response\":%.3f}\n",
+          response->name, mode, bytes, nsPerResponse, stackPeak,
+          Host_heapPeak - Host_heapInUse, (double) Host_allocations / (ITERATIONS + 1));
+}
+
+int main(void)
+{
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   for(size_t r = 0; r < ARRAY_SIZE(responses); r++) {
+      benchResponse(&responses[r], responses[r].mode);
+   }
+   AlexaRefreshResponseCache();
+   benchResponse(&responses[0], "cached");
+   benchResponse(&responses[1], "cached");
+   benchResponse(&responses[5], "cached");
+   return 0;
+}
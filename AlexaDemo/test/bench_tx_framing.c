@@ -0,0 +1,80 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Framing throughput and heap allocations per transaction for responses
+// framed in place in the TX ring, against the same bytes framed into a
+// pooled packet list and queued with sendPacketList(). Both include handing
+// the notifications to the stack.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+#define ITERATIONS (100000U)
+
+static void benchResponse(char const *name, stream_id_t streamId, bool (*createResponse)(void))
+{
+   static uint8_t payload[1024];
+   size_t payloadSize;
+   double ringSeconds;
+   double listSeconds;
+   uint32_t ringAllocations;
+   uint32_t listAllocations;
+
+   Host_resetNotifications();
+   createResponse();
+   AlexaTxPump();
+   payloadSize = Host_parseNotifications(NULL, NULL, payload, sizeof(payload));
+
+   Host_resetAllocations();
+   uint64_t start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      Host_resetNotifications();
+      createResponse();
+      AlexaTxPump();
+   }
+   ringSeconds = (double) (Host_nowNs() - start) / 1e9;
+   ringAllocations = Host_allocations;
+
+   Host_resetAllocations();
+   start = Host_nowNs();
+   for(uint32_t i = 0; i < ITERATIONS; i++) {
+      Host_resetNotifications();
+      sendPacketList(buildStreamPacket(streamId, false, payload, payloadSize));
+   }
+   listSeconds = (double) (Host_nowNs() - start) / 1e9;
+   listAllocations = Host_allocations;
+
+   printf("{\"bench\":\"tx_framing\",\"message\":\"%s\",\"bytes\":%zu,\"notifications\":%zu,"
+          "\"ring_mb_per_s\":%.1f,\"list_mb_per_s\":%.1f,"
+          "\"ring_allocations_per_transaction\":%.3f,\"list_allocations_per_transaction\":%.3f}\n",
+          name, payloadSize, Host_notificationCount,
+          (double) payloadSize * ITERATIONS / ringSeconds / 1e6,
+          (double) payloadSize * ITERATIONS / listSeconds / 1e6,
+          (double) ringAllocations / ITERATIONS, (double) listAllocations / ITERATIONS);
+}
+
+int main(void)
+{
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   benchResponse("Alexa.Discovery.Discover.Response", ALEXA_STREAM, CreateDiscoveryResponse);
+   benchResponse("GET_DEVICE_INFORMATION", CONTROL_STREAM, createResponseGetDeviceInformation);
+   benchResponse("GET_DEVICE_FEATURES", CONTROL_STREAM, createResponseGetDeviceFeatures);
+   return 0;
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Notifications spent per directive and per command, ACK included, at the
+// smallest, a typical and the largest ATT MTU.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+static void countNotifications(char const *name, stream_id_t streamId,
+                               uint8_t const *payload, size_t payloadSize)
+{
+   static uint16_t const mtus[] = { SAMPLE_DEFAULT_ATT_MTU, 128, SAMPLE_MAX_ATT_MTU };
+
+   for(size_t m = 0; m < ARRAY_SIZE(mtus); m++) {
+      size_t acks;
+      AlexaSetAttMtu(mtus[m]);
+      Host_resetNotifications();
+      Host_writeTransaction(streamId, 0, payload, payloadSize, mtus[m] - ATT_HEADER_SIZE - 6);
+      size_t bytes = Host_parseNotifications(&acks, NULL, NULL, 0);
+      printf("{\"bench\":\"tx_packing\",\"message\":\"%s\",\"att_mtu\":%u,\"acks\":%zu,"
+             "\"response_bytes\":%zu,\"notifications\":%zu}\n",
+             name, mtus[m], acks, bytes, Host_notificationCount);
+   }
+}
+
+int main(void)
+{
+   uint8_t discover[128];
+   uint8_t information[32];
+   uint8_t features[32];
+   size_t discoverSize = Host_encodeDirective(discover, sizeof(discover), "Alexa.Discovery", "Discover", NULL, 0);
+   size_t informationSize = Host_encodeCommand(information, sizeof(information), Command_GET_DEVICE_INFORMATION);
+   size_t featuresSize = Host_encodeCommand(features, sizeof(features), Command_GET_DEVICE_FEATURES);
+
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+
+   countNotifications("Alexa.Discovery.Discover", ALEXA_STREAM, discover, discoverSize);
+   countNotifications("GET_DEVICE_INFORMATION", CONTROL_STREAM, information, informationSize);
+   countNotifications("GET_DEVICE_FEATURES", CONTROL_STREAM, features, featuresSize);
+   return 0;
+}
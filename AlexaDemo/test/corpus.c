@@ -0,0 +1,77 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdio.h>
+
+#include "accessories.pb.h"
+#include "alexaDiscoveryDiscoverDirectivePayload.pb.h"
+#include "alexaDiscoveryDiscoverResponseEvent.pb.h"
+#include "alexaGadgetMusicDataTempoDirectivePayload.pb.h"
+#include "alexaGadgetStateListenerStateUpdateDirectivePayload.pb.h"
+#include "corpus.h"
+#include "directiveParser.pb.h"
+#include "eventParser.pb.h"
+#include "helpers.h"
+
+#define ENTRY(name, type, direction) { name, #type, type##_fields, direction }
+
+corpus_entry_t const Corpus_entries[] = {
+   ENTRY("control_get_device_information", ControlEnvelope, CORPUS_RECEIVED),
+   ENTRY("control_get_device_features", ControlEnvelope, CORPUS_RECEIVED),
+   ENTRY("directive_discover", directive_DirectiveParserProto, CORPUS_RECEIVED),
+   ENTRY("directive_state_update", directive_DirectiveParserProto, CORPUS_RECEIVED),
+   ENTRY("directive_tempo", directive_DirectiveParserProto, CORPUS_RECEIVED),
+   ENTRY("directive_get_data", directive_DirectiveParserProto, CORPUS_RECEIVED),
+   ENTRY("directive_clear_indicator", directive_DirectiveParserProto, CORPUS_RECEIVED),
+   ENTRY("payload_discover", alexaDiscovery_DiscoverDirectivePayloadProto, CORPUS_RECEIVED),
+   ENTRY("payload_state_update", alexaGadgetStateListener_StateUpdateDirectivePayloadProto, CORPUS_RECEIVED),
+   ENTRY("payload_tempo", alexaGadgetMusicData_TempoDirectivePayloadProto, CORPUS_RECEIVED),
+   ENTRY("response_device_information", ControlEnvelope, CORPUS_SENT),
+   ENTRY("response_device_features", ControlEnvelope, CORPUS_SENT),
+   ENTRY("event_discover_response", alexaDiscovery_DiscoverResponseEventProto, CORPUS_SENT),
+   ENTRY("event_get_data_report", event_EventParserProto, CORPUS_SENT),
+};
+
+size_t const Corpus_entryCount = ARRAY_SIZE(Corpus_entries);
+
+static FILE *openFile(char const *name, char const *mode)
+{
+   char path[128];
+   snprintf(path, sizeof(path), "%s/%s.bin", CORPUS_DIRECTORY, name);
+   return fopen(path, mode);
+}
+
+size_t Corpus_load(char const *name, uint8_t *buffer, size_t bufferSize)
+{
+   FILE *file = openFile(name, "rb");
+   size_t size = 0;
+
+   if(file != NULL) {
+      size = fread(buffer, 1, bufferSize, file);
+      if(size == bufferSize && fgetc(file) != EOF) {
+         size = 0;
+      }
+      fclose(file);
+   }
+   return size;
+}
+
+bool Corpus_save(char const *name, uint8_t const *message, size_t messageSize)
+{
+   FILE *file = openFile(name, "wb");
+   bool status = false;
+
+   if(file != NULL) {
+      status = fwrite(message, 1, messageSize, file) == messageSize;
+      status = (fclose(file) == 0) && status;
+   }
+   return status;
+}
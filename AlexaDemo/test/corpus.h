@@ -0,0 +1,56 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// The recorded message corpus in corpus/: one encoded message per file, as
+// received from the Echo or as sent by the gadget. record_corpus regenerates
+// the files; the tests and benchmarks only read them.
+
+#ifndef HOST_CORPUS_H_
+#define HOST_CORPUS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pb.h"
+
+#define CORPUS_DIRECTORY        "corpus"
+#define CORPUS_MAX_MESSAGE_SIZE (2048U)
+// Large enough for the decoded form of any message in the corpus.
+#define CORPUS_MAX_STRUCT_SIZE  (4096U)
+
+typedef enum {
+   CORPUS_RECEIVED,         // written by the Echo, decoded by the gadget
+   CORPUS_SENT              // encoded by the gadget
+} corpus_direction_t;
+
+typedef struct {
+   char const *name;        // file name without the .bin extension
+   char const *message;     // message type the file holds
+   pb_msgdesc_t const *fields;
+   corpus_direction_t direction;
+} corpus_entry_t;
+
+extern corpus_entry_t const Corpus_entries[];
+extern size_t const Corpus_entryCount;
+
+/**
+ * Reads corpus/<name>.bin.
+ * @return the size of the message, 0 if the file is missing or too large.
+ */
+size_t Corpus_load(char const *name, uint8_t *buffer, size_t bufferSize);
+
+/**
+ * Writes corpus/<name>.bin.
+ */
+bool Corpus_save(char const *name, uint8_t const *message, size_t messageSize);
+
+#endif
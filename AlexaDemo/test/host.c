@@ -0,0 +1,378 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alexa.h"
+#include "app.h"
+#include "bg_errorcodes.h"
+#include "directiveParser.pb.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_encode.h"
+
+const char gFwVer[FWVER_MAX_LEN] = "1.0.0";
+char gAlexaSn[ALEXA_SN_LEN] = "Demo0123456789";
+unsigned char gDeviceToken[65] =
+   "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+uint8_t gConnection;
+bool gLedOn;
+
+uint8_t Host_notifications[HOST_MAX_NOTIFICATIONS][SAMPLE_MAX_ATT_MTU];
+uint8_t Host_notificationLengths[HOST_MAX_NOTIFICATIONS];
+size_t Host_notificationCount;
+uint32_t Host_allocations;
+uint32_t Host_frees;
+size_t Host_heapInUse;
+size_t Host_heapPeak;
+uint32_t Host_breakpoints;
+uint32_t Host_systemResets;
+uint32_t Host_softTimers[HOST_SOFT_TIMERS];
+
+static bool verbose;
+static bool notificationsFail;
+static uint32_t ticks;
+static unsigned failures;
+static unsigned checks;
+
+bool Host_check(bool condition, char const *text, char const *file, int line)
+{
+   checks++;
+   if(!condition) {
+      failures++;
+      fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+   }
+   return condition;
+}
+
+int Host_finish(char const *name)
+{
+   printf("%s: %u checks, %u failed\n", name, checks, failures);
+   return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void Host_setVerbose(bool enable)
+{
+   verbose = enable;
+}
+
+void Host_log(char const *format, ...)
+{
+   if(!verbose) return;
+   va_list args;
+   va_start(args, format);
+   vfprintf(stderr, format, args);
+   va_end(args);
+}
+
+void Host_resetNotifications(void)
+{
+   Host_notificationCount = 0;
+}
+
+void Host_setNotificationsFail(bool fail)
+{
+   notificationsFail = fail;
+}
+
+void Host_resetAllocations(void)
+{
+   Host_allocations = 0;
+   Host_frees = 0;
+   Host_heapPeak = Host_heapInUse;
+}
+
+void Host_setTicks(uint32_t value)
+{
+   ticks = value;
+}
+
+uint64_t Host_nowNs(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+}
+
+uint64_t Host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __builtin_ia32_rdtsc();
+#else
+   return 0;
+#endif
+}
+
+// The stack is painted below the caller's frame and scanned from the bottom
+// up for the deepest byte that no longer holds the pattern.
+#define STACK_PAINT_SIZE    (64U * 1024U)
+#define STACK_PAINT_PATTERN (0xA5U)
+
+static uint8_t *stackRegion;
+
+__attribute__((noinline)) void Host_stackPaint(void)
+{
+   uint8_t region[STACK_PAINT_SIZE];
+   uintptr_t address = (uintptr_t) region;
+   memset(region, STACK_PAINT_PATTERN, sizeof(region));
+   __asm__ volatile("" : "+r"(address) : : "memory");
+   stackRegion = (uint8_t *) address;
+}
+
+__attribute__((noinline)) size_t Host_stackPeak(void)
+{
+   volatile uint8_t const *region = stackRegion;
+   size_t i = 0;
+   while(i < STACK_PAINT_SIZE && region[i] == STACK_PAINT_PATTERN) {
+      i++;
+   }
+   return STACK_PAINT_SIZE - i;
+}
+
+void Host_breakpoint(void)
+{
+   Host_breakpoints++;
+}
+
+void Host_systemReset(void)
+{
+   Host_systemResets++;
+}
+
+uint32_t sl_sleeptimer_get_tick_count(void)
+{
+   return ticks;
+}
+
+uint32_t sl_sleeptimer_ms_to_tick(uint16_t time_ms)
+{
+   return ((uint32_t) time_ms * 32768U) / 1000U;
+}
+
+void *gecko_cmd_hardware_set_soft_timer(uint32_t time, uint8_t handle, uint8_t single_shot)
+{
+   (void) single_shot;
+   if(handle < HOST_SOFT_TIMERS) {
+      Host_softTimers[handle] = time;
+   }
+   return NULL;
+}
+
+uint16_t AlexaTxPacket(uint8_t *pData,uint8_t Len)
+{
+   if(notificationsFail) {
+      return bg_err_out_of_memory;
+   }
+   if(Host_notificationCount < HOST_MAX_NOTIFICATIONS) {
+      memcpy(Host_notifications[Host_notificationCount], pData, Len);
+      Host_notificationLengths[Host_notificationCount] = Len;
+   }
+   Host_notificationCount++;
+   return bg_err_success;
+}
+
+void DumpHex(const void *AdrIn,int Len)
+{
+   (void) AdrIn;
+   (void) Len;
+}
+
+void SetLeds(uint8_t Red,uint8_t Green,uint8_t Blue)
+{
+   (void) Red;
+   (void) Green;
+   (void) Blue;
+}
+
+size_t Host_frameTransaction(uint8_t writes[][SAMPLE_MAX_ATT_MTU], size_t *writeSizes,
+                             size_t maxWrites, stream_id_t streamId,
+                             transaction_id_t transactionId, bool ack,
+                             uint8_t const *payload, size_t payloadSize,
+                             size_t fragmentPayload)
+{
+   size_t offset = 0;
+   size_t count = 0;
+
+   do {
+      if(count == maxWrites) return 0;
+      size_t chunk = MIN(payloadSize - offset, fragmentPayload);
+      transaction_type_t type = (count == 0) ? TRANSACTION_TYPE_INITIAL :
+         (offset + chunk == payloadSize) ? TRANSACTION_TYPE_FINAL : TRANSACTION_TYPE_CONTINUE;
+      bool extendLength = chunk > 0xff;
+      uint8_t *write = writes[count];
+      size_t size = 0;
+
+      write[size++] = (uint8_t) ((streamId << STREAM_ID_SHIFT) | (transactionId << TRANSACTION_ID_SHIFT));
+      write[size++] = (uint8_t) (((count & SEQ_NUM_ID_MASK) << SEQ_NUM_ID_SHIFT) |
+                                 (type << TRANSACTION_TYPE_SHIFT) |
+                                 ((ack ? 1U : 0U) << ACK_BIT_SHIFT) |
+                                 ((extendLength ? 1U : 0U) << EXTENDED_LENGTH_BIT_SHIFT));
+      if(type == TRANSACTION_TYPE_INITIAL) {
+         write[size++] = 0; // Reserved.
+         write[size++] = (uint8_t) (payloadSize >> 8U);
+         write[size++] = (uint8_t) payloadSize;
+      }
+      if(extendLength) {
+         write[size++] = (uint8_t) (chunk >> 8U);
+      }
+      write[size++] = (uint8_t) chunk;
+      memcpy(&write[size], &payload[offset], chunk);
+      writeSizes[count++] = size + chunk;
+      offset += chunk;
+   } while(offset < payloadSize);
+   return count;
+}
+
+size_t Host_writeTransaction(stream_id_t streamId, transaction_id_t transactionId,
+                             uint8_t const *payload, size_t payloadSize,
+                             size_t fragmentPayload)
+{
+   static uint8_t writes[64][SAMPLE_MAX_ATT_MTU];
+   static size_t writeSizes[64];
+   size_t count = Host_frameTransaction(writes, writeSizes, ARRAY_SIZE(writes),
+                                        streamId, transactionId, true,
+                                        payload, payloadSize, fragmentPayload);
+   for(size_t i = 0; i < count; i++) {
+      AlexaRxPacket(writes[i], (uint8_t) writeSizes[i]);
+   }
+   return count;
+}
+
+size_t Host_parseNotifications(size_t *acks, size_t *failedAcks,
+                               uint8_t *payload, size_t payloadCapacity)
+{
+   size_t ackCount = 0;
+   size_t failedCount = 0;
+   size_t total = 0;
+   size_t received = 0;
+   int dataStream = -1;
+   int dataTransaction = -1;
+   bool valid = true;
+
+   for(size_t n = 0; n < MIN(Host_notificationCount, HOST_MAX_NOTIFICATIONS); n++) {
+      uint8_t const *p = Host_notifications[n];
+      size_t size = Host_notificationLengths[n];
+      size_t offset = 0;
+
+      while(offset + 2 <= size) {
+         int streamId = (p[offset] >> STREAM_ID_SHIFT) & STREAM_ID_MASK;
+         int transactionId = (p[offset] >> TRANSACTION_ID_SHIFT) & TRANSACTION_ID_MASK;
+         transaction_type_t type = (p[offset + 1] >> TRANSACTION_TYPE_SHIFT) & TRANSACTION_TYPE_MASK;
+         bool extendLength = (p[offset + 1] & (1U << EXTENDED_LENGTH_BIT_SHIFT)) != 0;
+         offset += 2;
+
+         if(type == TRANSACTION_TYPE_CONTROL) {
+            if(offset + CONTROL_PACKET_LENGTH - 2 > size) {
+               valid = false;
+               break;
+            }
+            ackCount++;
+            if(p[offset + 3] != CONTROL_PACKET_RESULT_SUCCESS) {
+               failedCount++;
+            }
+            offset += CONTROL_PACKET_LENGTH - 2;
+            continue;
+         }
+         size_t announced = 0;
+         if(type == TRANSACTION_TYPE_INITIAL) {
+            announced = ((size_t) p[offset + 1] << 8U) | p[offset + 2];
+            offset += 3;
+         }
+         size_t length = p[offset++];
+         if(extendLength) {
+            length = (length << 8U) | p[offset++];
+         }
+         if(offset + length > size) {
+            valid = false;
+            break;
+         }
+         if(type == TRANSACTION_TYPE_INITIAL && dataStream < 0) {
+            dataStream = streamId;
+            dataTransaction = transactionId;
+            total = announced;
+         }
+         if(streamId == dataStream && transactionId == dataTransaction) {
+            if(payload != NULL && received + length <= payloadCapacity) {
+               memcpy(&payload[received], &p[offset], length);
+            }
+            received += length;
+         }
+         offset += length;
+      }
+      if(offset != size) {
+         valid = false;
+      }
+   }
+   if(acks != NULL) *acks = ackCount;
+   if(failedAcks != NULL) *failedAcks = failedCount;
+   return (valid && received == total) ? total : 0;
+}
+
+size_t Host_countTransactions(stream_id_t streamId)
+{
+   size_t count = 0;
+
+   for(size_t n = 0; n < MIN(Host_notificationCount, HOST_MAX_NOTIFICATIONS); n++) {
+      uint8_t const *p = Host_notifications[n];
+      size_t size = Host_notificationLengths[n];
+      size_t offset = 0;
+
+      while(offset + 2 <= size) {
+         transaction_type_t type = (p[offset + 1] >> TRANSACTION_TYPE_SHIFT) & TRANSACTION_TYPE_MASK;
+         bool extendLength = (p[offset + 1] & (1U << EXTENDED_LENGTH_BIT_SHIFT)) != 0;
+         if(type == TRANSACTION_TYPE_CONTROL) {
+            offset += CONTROL_PACKET_LENGTH;
+            continue;
+         }
+         if(type == TRANSACTION_TYPE_INITIAL &&
+            ((p[offset] >> STREAM_ID_SHIFT) & STREAM_ID_MASK) == streamId)
+         {
+            count++;
+         }
+         offset += (type == TRANSACTION_TYPE_INITIAL) ? 5 : 2;
+         size_t length = p[offset++];
+         if(extendLength) {
+            length = (length << 8U) | p[offset++];
+         }
+         offset += length;
+      }
+   }
+   return count;
+}
+
+size_t Host_encodeCommand(uint8_t *buffer, size_t bufferSize, Command command)
+{
+   ControlEnvelope envelope = ControlEnvelope_init_default;
+   envelope.command = command;
+   pb_ostream_t stream = pb_ostream_from_buffer(buffer, bufferSize);
+   return pb_encode(&stream, ControlEnvelope_fields, &envelope) ? stream.bytes_written : 0;
+}
+
+size_t Host_encodeDirective(uint8_t *buffer, size_t bufferSize, char const *ns,
+                            char const *name, uint8_t const *payload, size_t payloadSize)
+{
+   directive_DirectiveParserProto directive = directive_DirectiveParserProto_init_default;
+   directive.has_directive = true;
+   directive.directive.has_header = true;
+   strncpy(directive.directive.header.namespace, ns, sizeof(directive.directive.header.namespace) - 1);
+   strncpy(directive.directive.header.name, name, sizeof(directive.directive.header.name) - 1);
+   strcpy(directive.directive.header.messageId, "host-0001");
+   directive.directive.payload.bytes = payload;
+   directive.directive.payload.size = payloadSize;
+   pb_ostream_t stream = pb_ostream_from_buffer(buffer, bufferSize);
+   return pb_encode(&stream, directive_DirectiveParserProto_fields, &directive) ? stream.bytes_written : 0;
+}
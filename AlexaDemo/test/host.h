@@ -0,0 +1,162 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+#ifndef ALEXA_GADGETS_SAMPLE_CODE_TEST_HOST_H
+#define ALEXA_GADGETS_SAMPLE_CODE_TEST_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "accessories.pb.h"
+#include "common.h"
+
+// Runs the alexa sources on a Linux host. Notifications handed to
+// AlexaTxPacket() are captured, the sleeptimer tick count is set by the test,
+// and every heap allocation made by the firmware objects is counted.
+
+#define HOST_MAX_NOTIFICATIONS (512U)
+
+extern uint8_t Host_notifications[HOST_MAX_NOTIFICATIONS][SAMPLE_MAX_ATT_MTU];
+extern uint8_t Host_notificationLengths[HOST_MAX_NOTIFICATIONS];
+extern size_t Host_notificationCount;
+
+// Heap calls made since the last Host_resetAllocations(). Only objects linked
+// with the --wrap options are seen, which is every firmware object. A test
+// linked with heap_guard.c instead of host_heap.c leaves them at 0.
+extern uint32_t Host_allocations;
+extern uint32_t Host_frees;
+// Bytes held by the firmware objects, and the most held at once since
+// Host_resetAllocations().
+extern size_t Host_heapInUse;
+extern size_t Host_heapPeak;
+
+// Calls to __BKPT() and NVIC_SystemReset(), which em_device.h sends here.
+extern uint32_t Host_breakpoints;
+extern uint32_t Host_systemResets;
+
+// Interval of the last gecko_cmd_hardware_set_soft_timer() call per handle,
+// 0 once the timer is stopped.
+#define HOST_SOFT_TIMERS (8U)
+extern uint32_t Host_softTimers[HOST_SOFT_TIMERS];
+
+#define CHECK(condition) Host_check((condition), #condition, __FILE__, __LINE__)
+
+/**
+ * Records a failed check. Host_finish() turns any failure into the exit code.
+ */
+bool Host_check(bool condition, char const *text, char const *file, int line);
+
+/**
+ * Prints the result line for the test and returns its exit code.
+ */
+int Host_finish(char const *name);
+
+/**
+ * Sends the firmware log to stderr when set, otherwise it is discarded.
+ */
+void Host_setVerbose(bool verbose);
+
+/**
+ * Clears the captured notifications.
+ */
+void Host_resetNotifications(void);
+
+/**
+ * Makes AlexaTxPacket() report that the stack is out of buffers.
+ * @param fail true to refuse every notification, false to accept them again.
+ */
+void Host_setNotificationsFail(bool fail);
+
+/**
+ * Clears the allocation counters.
+ */
+void Host_resetAllocations(void);
+
+/**
+ * Sets the value returned by sl_sleeptimer_get_tick_count().
+ */
+void Host_setTicks(uint32_t ticks);
+
+/**
+ * Returns a monotonic time stamp in nanoseconds.
+ */
+uint64_t Host_nowNs(void);
+
+/**
+ * Returns the processor time stamp counter, or 0 on hosts without one.
+ */
+uint64_t Host_cycles(void);
+
+/**
+ * Fills the stack below the caller with a pattern. Call Host_stackPeak() from
+ * the same function once the code under test has returned.
+ */
+void Host_stackPaint(void);
+
+/**
+ * Returns the deepest stack use seen since Host_stackPaint(), in bytes.
+ */
+size_t Host_stackPeak(void);
+
+/**
+ * Frames a transaction as the Echo writes it, one write per fragment.
+ * @param writes receives the writes, each at most SAMPLE_MAX_ATT_MTU bytes.
+ * @param writeSizes receives the size of each write.
+ * @param maxWrites the number of entries in \p writes and \p writeSizes.
+ * @param fragmentPayload the payload bytes carried by each fragment.
+ * @return the number of writes, 0 if they do not fit in \p maxWrites.
+ */
+size_t Host_frameTransaction(uint8_t writes[][SAMPLE_MAX_ATT_MTU], size_t *writeSizes,
+                             size_t maxWrites, stream_id_t streamId,
+                             transaction_id_t transactionId, bool ack,
+                             uint8_t const *payload, size_t payloadSize,
+                             size_t fragmentPayload);
+
+/**
+ * Frames a transaction and passes each write to AlexaRxPacket().
+ * @return the number of writes.
+ */
+size_t Host_writeTransaction(stream_id_t streamId, transaction_id_t transactionId,
+                             uint8_t const *payload, size_t payloadSize,
+                             size_t fragmentPayload);
+
+/**
+ * Walks the packets in the captured notifications.
+ * @param acks receives the number of control ACKs, may be NULL.
+ * @param failedAcks receives the number of ACKs reporting a failure, may be NULL.
+ * @param payload receives the payload of the first data transaction, may be NULL.
+ * @param payloadCapacity the size of \p payload.
+ * @return the size of the first data transaction as announced by its initial
+ *         fragment, or 0 if there is none or its fragments do not add up.
+ */
+size_t Host_parseNotifications(size_t *acks, size_t *failedAcks,
+                               uint8_t *payload, size_t payloadCapacity);
+
+/**
+ * Counts the transactions started on \p streamId in the captured notifications.
+ */
+size_t Host_countTransactions(stream_id_t streamId);
+
+/**
+ * Encodes a ControlEnvelope carrying \p command.
+ * @return the encoded size.
+ */
+size_t Host_encodeCommand(uint8_t *buffer, size_t bufferSize, Command command);
+
+/**
+ * Encodes a directive with the given header and payload.
+ * @return the encoded size.
+ */
+size_t Host_encodeDirective(uint8_t *buffer, size_t bufferSize, char const *ns,
+                            char const *name, uint8_t const *payload, size_t payloadSize);
+
+#endif // ALEXA_GADGETS_SAMPLE_CODE_TEST_HOST_H
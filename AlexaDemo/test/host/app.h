@@ -0,0 +1,39 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Host stand-in for AlexaDemo/app.h: the parts of the application that the
+// alexa sources use, with the log routed to Host_log().
+
+#ifndef APP_H_
+#define APP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define printLog(...) Host_log(__VA_ARGS__)
+
+/* Soft timer handles */
+#define TEMPO_TIMER_HANDLE       0
+#define RX_SWEEP_TIMER_HANDLE    1
+#define TX_RETRY_TIMER_HANDLE    2
+#define PROTOCOL_VERSION_TIMER_HANDLE 3
+
+#define MTU_EXCHANGE_TIMEOUT     32768
+
+extern uint8_t gConnection;
+extern bool gLedOn;
+
+void Host_log(char const *format, ...);
+uint16_t AlexaTxPacket(uint8_t *pData,uint8_t Len);
+void DumpHex(const void *AdrIn,int Len);
+void SetLeds(uint8_t Red,uint8_t Green,uint8_t Blue);
+
+#endif
@@ -0,0 +1,24 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Host stand-in for the CMSIS device header. A breakpoint or a system reset is
+// recorded by the harness instead of stopping the program.
+
+#ifndef EM_DEVICE_H
+#define EM_DEVICE_H
+
+void Host_breakpoint(void);
+void Host_systemReset(void);
+
+#define __BKPT(value)      Host_breakpoint()
+#define NVIC_SystemReset() Host_systemReset()
+
+#endif
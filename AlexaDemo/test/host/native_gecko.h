@@ -0,0 +1,21 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Host stand-in for the BGAPI commands the alexa sources call.
+
+#ifndef NATIVE_GECKO_H
+#define NATIVE_GECKO_H
+
+#include <stdint.h>
+
+void *gecko_cmd_hardware_set_soft_timer(uint32_t time, uint8_t handle, uint8_t single_shot);
+
+#endif
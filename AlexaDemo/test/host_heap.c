@@ -0,0 +1,62 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Allocator wrappers behind Host_allocations and the heap counters. Kept apart
+// from host.c so that a test can link heap_guard.c's wrappers instead.
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "helpers.h"
+#include "host.h"
+
+// Every firmware object is linked with --wrap for the allocator, so any heap
+// use on the paths under test is counted here.
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static void *countAllocation(void *ptr, size_t previousSize)
+{
+   Host_allocations++;
+   if(ptr != NULL) {
+      Host_heapInUse += malloc_usable_size(ptr) - previousSize;
+      Host_heapPeak = MAX(Host_heapPeak, Host_heapInUse);
+   }
+   return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+   return countAllocation(__real_malloc(size), 0);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+   return countAllocation(__real_calloc(count, size), 0);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   size_t previousSize = (ptr != NULL) ? malloc_usable_size(ptr) : 0;
+   return countAllocation(__real_realloc(ptr, size), previousSize);
+}
+
+void __wrap_free(void *ptr)
+{
+   if(ptr != NULL) {
+      Host_frees++;
+      Host_heapInUse -= malloc_usable_size(ptr);
+   }
+   __real_free(ptr);
+}
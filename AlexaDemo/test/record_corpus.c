@@ -0,0 +1,138 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Regenerates corpus/ with "make corpus". Directives are encoded the way the
+// Echo sends them; responses and events are captured from the notifications
+// the firmware sends.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "alexaDiscoveryDiscoverDirectivePayload.pb.h"
+#include "alexaGadgetMusicDataTempoDirectivePayload.pb.h"
+#include "alexaGadgetStateListenerStateUpdateDirectivePayload.pb.h"
+#include "corpus.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_encode.h"
+#include "tx.h"
+
+static uint8_t message[CORPUS_MAX_MESSAGE_SIZE];
+static int failures;
+
+static void save(char const *name, uint8_t const *bytes, size_t size)
+{
+   if(size == 0 || !Corpus_save(name, bytes, size)) {
+      fprintf(stderr, "record_corpus: %s not written\n", name);
+      failures++;
+   }
+}
+
+static size_t encode(pb_msgdesc_t const *fields, void const *src)
+{
+   pb_ostream_t stream = pb_ostream_from_buffer(message, sizeof(message));
+   return pb_encode(&stream, fields, src) ? stream.bytes_written : 0;
+}
+
+static pb_view_t view(char const *string)
+{
+   pb_view_t result = { (pb_byte_t const *) string, (pb_size_t) strlen(string) };
+   return result;
+}
+
+static void recordDirective(char const *name, char const *ns, char const *directiveName,
+                            uint8_t const *payload, size_t payloadSize)
+{
+   static uint8_t directive[CORPUS_MAX_MESSAGE_SIZE];
+   save(name, directive,
+        Host_encodeDirective(directive, sizeof(directive), ns, directiveName, payload, payloadSize));
+}
+
+static void recordDirectives(void)
+{
+   static uint8_t payload[CORPUS_MAX_MESSAGE_SIZE];
+   size_t payloadSize;
+
+   alexaDiscovery_DiscoverDirectivePayloadProto discover =
+      alexaDiscovery_DiscoverDirectivePayloadProto_init_default;
+   discover.has_scope = true;
+   strcpy(discover.scope.type, "BearerToken");
+   strcpy(discover.scope.token, "amzn1.ask.account.AF3X7Q2");
+   payloadSize = encode(alexaDiscovery_DiscoverDirectivePayloadProto_fields, &discover);
+   save("payload_discover", message, payloadSize);
+   memcpy(payload, message, payloadSize);
+   recordDirective("directive_discover", "Alexa.Discovery", "Discover", payload, payloadSize);
+
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States states[] = {
+      { view("wakeword"), view("active") },
+      { view("timers"), view("cleared") },
+      { view("alarms"), view("active") },
+      { view("reminders"), view("cleared") },
+   };
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto stateUpdate =
+      { ARRAY_SIZE(states), states };
+   payloadSize = encode(alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields, &stateUpdate);
+   save("payload_state_update", message, payloadSize);
+   memcpy(payload, message, payloadSize);
+   recordDirective("directive_state_update", "Alexa.Gadget.StateListener", "StateUpdate",
+                   payload, payloadSize);
+
+   alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData tempoData[] = {
+      { 120, 0 },
+      { 96, 45000 },
+      { 128, 93500 },
+   };
+   alexaGadgetMusicData_TempoDirectivePayloadProto tempo = { 1250, ARRAY_SIZE(tempoData), tempoData };
+   payloadSize = encode(alexaGadgetMusicData_TempoDirectivePayloadProto_fields, &tempo);
+   save("payload_tempo", message, payloadSize);
+   memcpy(payload, message, payloadSize);
+   recordDirective("directive_tempo", "Alexa.Gadget.MusicData", "Tempo", payload, payloadSize);
+
+   recordDirective("directive_get_data", "Custom.ThunderGadget", "GetData",
+                   (uint8_t const *) "{}", 2);
+   recordDirective("directive_clear_indicator", "Notifications", "ClearIndicator", NULL, 0);
+
+   save("control_get_device_information", message,
+        Host_encodeCommand(message, sizeof(message), Command_GET_DEVICE_INFORMATION));
+   save("control_get_device_features", message,
+        Host_encodeCommand(message, sizeof(message), Command_GET_DEVICE_FEATURES));
+}
+
+static void recordSent(char const *name, bool (*create)(void))
+{
+   Host_resetNotifications();
+   create();
+   AlexaTxPump();
+   save(name, message, Host_parseNotifications(NULL, NULL, message, sizeof(message)));
+}
+
+static bool createSensorData(void)
+{
+   SendSensorData(72, 40);
+   return true;
+}
+
+int main(void)
+{
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   recordDirectives();
+   recordSent("response_device_information", createResponseGetDeviceInformation);
+   recordSent("response_device_features", createResponseGetDeviceFeatures);
+   recordSent("event_discover_response", CreateDiscoveryResponse);
+   recordSent("event_get_data_report", createSensorData);
+   return failures;
+}
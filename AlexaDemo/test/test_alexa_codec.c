@@ -0,0 +1,362 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// The specialized codecs in alexa_codec.c must give the same result as
+// pb_decode() and pb_encode() with the generated descriptors. Both are run on
+// the recorded corpus, on every truncation and on random corruptions of it,
+// and on randomly generated messages: they must agree on success, on what was
+// decoded and on how much of the input was consumed, and encode byte for byte
+// the same events.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa_codec.h"
+#include "corpus.h"
+#include "directive_arena.h"
+#include "host.h"
+
+#define CORRUPTIONS (30U)
+#define RANDOM_MESSAGES (500U)
+#define MAX_ENTRIES (64U)
+
+typedef void (*compare_t)(uint8_t const *buffer, size_t size);
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t corrupted[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t payload[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t expected[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t output[CORPUS_MAX_MESSAGE_SIZE];
+
+static uint32_t seed = 0x2545F491U;
+
+static uint32_t nextRandom(void)
+{
+   seed ^= seed << 13;
+   seed ^= seed >> 17;
+   seed ^= seed << 5;
+   return seed;
+}
+
+static bool sameView(pb_view_t a, pb_view_t b)
+{
+   return a.size == b.size && (a.size == 0 || a.bytes == b.bytes);
+}
+
+static bool sameHeader(header_DirectiveHeaderProto const *a, header_DirectiveHeaderProto const *b)
+{
+   return strcmp(a->namespace, b->namespace) == 0 && strcmp(a->name, b->name) == 0 &&
+          strcmp(a->messageId, b->messageId) == 0 &&
+          strcmp(a->dialogRequestId, b->dialogRequestId) == 0;
+}
+
+static void compareHeader(uint8_t const *buffer, size_t size)
+{
+   header_DirectiveHeaderProto generic;
+   header_DirectiveHeaderProto specialized;
+   pb_istream_t genericStream = pb_istream_from_buffer(buffer, size);
+   pb_istream_t specializedStream = pb_istream_from_buffer(buffer, size);
+
+   memset(&specialized, 0x55, sizeof(specialized));
+   bool genericStatus = pb_decode(&genericStream, header_DirectiveHeaderProto_fields, &generic);
+   bool specializedStatus = header_DirectiveHeaderProto_decode(&specializedStream, &specialized);
+
+   if(CHECK(genericStatus == specializedStatus) && genericStatus) {
+      CHECK(sameHeader(&generic, &specialized));
+      CHECK(genericStream.bytes_left == specializedStream.bytes_left);
+   }
+}
+
+static void compareDirective(uint8_t const *buffer, size_t size)
+{
+   directive_DirectiveParserProto generic;
+   directive_DirectiveParserProto specialized;
+   pb_istream_t genericStream = pb_istream_from_buffer(buffer, size);
+   pb_istream_t specializedStream = pb_istream_from_buffer(buffer, size);
+
+   memset(&generic, 0xAA, sizeof(generic));
+   memset(&specialized, 0x55, sizeof(specialized));
+   bool genericStatus = pb_decode_ex(&genericStream, directive_DirectiveParserProto_fields,
+                                     &generic, PB_DECODE_NOCLEAR);
+   bool specializedStatus = directive_DirectiveParserProto_decode(&specializedStream, &specialized);
+
+   if(CHECK(genericStatus == specializedStatus) && genericStatus) {
+      CHECK(generic.has_directive == specialized.has_directive);
+      CHECK(generic.directive.has_header == specialized.directive.has_header);
+      CHECK(sameHeader(&generic.directive.header, &specialized.directive.header));
+      CHECK(sameView(generic.directive.payload, specialized.directive.payload));
+      CHECK(genericStream.bytes_left == specializedStream.bytes_left);
+   }
+}
+
+// Repeated fields come from the arena, so the generic result is copied out
+// before the arena is handed to the specialized decoder.
+static void compareStateUpdate(uint8_t const *buffer, size_t size)
+{
+   static alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States states[MAX_ENTRIES];
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto generic;
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto specialized;
+   pb_istream_t genericStream = pb_istream_from_buffer(buffer, size);
+   pb_istream_t specializedStream = pb_istream_from_buffer(buffer, size);
+
+   DirectiveArena_begin();
+   bool genericStatus = pb_decode_ex(&genericStream,
+                                     alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields,
+                                     &generic, PB_DECODE_NOCLEAR);
+   if(genericStatus && generic.states_count > 0) {
+      if(!CHECK(generic.states_count <= MAX_ENTRIES)) return;
+      memcpy(states, generic.states, generic.states_count * sizeof(states[0]));
+   }
+   DirectiveArena_begin();
+   bool specializedStatus = alexaGadgetStateListener_StateUpdateDirectivePayloadProto_decode(
+      &specializedStream, &specialized);
+
+   if(CHECK(genericStatus == specializedStatus) && genericStatus) {
+      if(CHECK(generic.states_count == specialized.states_count)) {
+         for(pb_size_t i = 0; i < generic.states_count; i++) {
+            CHECK(sameView(states[i].name, specialized.states[i].name));
+            CHECK(sameView(states[i].value, specialized.states[i].value));
+         }
+      }
+      CHECK(genericStream.bytes_left == specializedStream.bytes_left);
+   }
+   DirectiveArena_reset();
+}
+
+static void compareTempo(uint8_t const *buffer, size_t size)
+{
+   static alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData tempoData[MAX_ENTRIES];
+   alexaGadgetMusicData_TempoDirectivePayloadProto generic;
+   alexaGadgetMusicData_TempoDirectivePayloadProto specialized;
+   pb_istream_t genericStream = pb_istream_from_buffer(buffer, size);
+   pb_istream_t specializedStream = pb_istream_from_buffer(buffer, size);
+
+   DirectiveArena_begin();
+   bool genericStatus = pb_decode_ex(&genericStream,
+                                     alexaGadgetMusicData_TempoDirectivePayloadProto_fields,
+                                     &generic, PB_DECODE_NOCLEAR);
+   if(genericStatus && generic.tempoData_count > 0) {
+      if(!CHECK(generic.tempoData_count <= MAX_ENTRIES)) return;
+      memcpy(tempoData, generic.tempoData, generic.tempoData_count * sizeof(tempoData[0]));
+   }
+   DirectiveArena_begin();
+   bool specializedStatus = alexaGadgetMusicData_TempoDirectivePayloadProto_decode(
+      &specializedStream, &specialized);
+
+   if(CHECK(genericStatus == specializedStatus) && genericStatus) {
+      CHECK(generic.playerOffsetInMilliSeconds == specialized.playerOffsetInMilliSeconds);
+      if(CHECK(generic.tempoData_count == specialized.tempoData_count)) {
+         for(pb_size_t i = 0; i < generic.tempoData_count; i++) {
+            CHECK(tempoData[i].value == specialized.tempoData[i].value);
+            CHECK(tempoData[i].startOffsetInMilliSeconds ==
+                  specialized.tempoData[i].startOffsetInMilliSeconds);
+         }
+      }
+      CHECK(genericStream.bytes_left == specializedStream.bytes_left);
+   }
+   DirectiveArena_reset();
+}
+
+// The message itself, every prefix of it and a few copies with random bytes
+// overwritten.
+static void compareVariants(compare_t compare, uint8_t const *buffer, size_t size)
+{
+   for(size_t truncated = 0; truncated <= size; truncated++) {
+      compare(buffer, truncated);
+   }
+   for(uint32_t c = 0; c < CORRUPTIONS && size > 0; c++) {
+      uint32_t changes = 1 + nextRandom() % 3;
+
+      memcpy(corrupted, buffer, size);
+      for(uint32_t i = 0; i < changes; i++) {
+         corrupted[nextRandom() % size] = (uint8_t) nextRandom();
+      }
+      compare(corrupted, size);
+   }
+}
+
+static void compareEvent(event_EventParserProto const *event)
+{
+   pb_ostream_t genericStream = pb_ostream_from_buffer(expected, sizeof(expected));
+   pb_ostream_t specializedStream = pb_ostream_from_buffer(output, sizeof(output));
+   bool genericStatus = pb_encode(&genericStream, event_EventParserProto_fields, event);
+   bool specializedStatus = event_EventParserProto_encode(&specializedStream, event);
+
+   if(!CHECK(genericStatus == specializedStatus) || !genericStatus) return;
+   CHECK(specializedStream.bytes_written == genericStream.bytes_written);
+   CHECK(memcmp(output, expected, genericStream.bytes_written) == 0);
+
+   pb_ostream_t sizing = PB_OSTREAM_SIZING;
+   CHECK(event_EventParserProto_encode(&sizing, event));
+   CHECK(sizing.bytes_written == genericStream.bytes_written);
+
+   for(size_t maxSize = 0; maxSize < genericStream.bytes_written; maxSize++) {
+      pb_ostream_t tooSmall = pb_ostream_from_buffer(output, maxSize);
+      CHECK(!event_EventParserProto_encode(&tooSmall, event));
+   }
+}
+
+static void testCorpus(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      corpus_entry_t const *entry = &Corpus_entries[e];
+      size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+
+      if(!CHECK(size > 0)) continue;
+      if(entry->fields == directive_DirectiveParserProto_fields) {
+         directive_DirectiveParserProto directive = directive_DirectiveParserProto_init_zero;
+         pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+         pb_ostream_t header = pb_ostream_from_buffer(payload, sizeof(payload));
+
+         compareVariants(compareDirective, encoded, size);
+         CHECK(pb_decode(&stream, directive_DirectiveParserProto_fields, &directive));
+         CHECK(pb_encode(&header, header_DirectiveHeaderProto_fields, &directive.directive.header));
+         compareVariants(compareHeader, payload, header.bytes_written);
+      }
+      else if(entry->fields == alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields) {
+         compareVariants(compareStateUpdate, encoded, size);
+      }
+      else if(entry->fields == alexaGadgetMusicData_TempoDirectivePayloadProto_fields) {
+         compareVariants(compareTempo, encoded, size);
+      }
+      else if(entry->fields == event_EventParserProto_fields) {
+         event_EventParserProto event = event_EventParserProto_init_zero;
+         pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+
+         if(CHECK(pb_decode(&stream, event_EventParserProto_fields, &event))) {
+            compareEvent(&event);
+         }
+      }
+   }
+}
+
+// Mostly short, sometimes empty and now and then longer than a header string
+// may be.
+static pb_view_t randomView(uint8_t *buffer)
+{
+   size_t size = (nextRandom() % 4 == 0) ? 0 : nextRandom() % 30;
+
+   if(nextRandom() % 50 == 0) {
+      size = 200;
+   }
+   for(size_t i = 0; i < size; i++) {
+      buffer[i] = (uint8_t) ('a' + nextRandom() % 26);
+   }
+   return (pb_view_t) { buffer, (pb_size_t) size };
+}
+
+static void randomString(char *string, size_t size)
+{
+   pb_view_t view = randomView((uint8_t *) string);
+   string[(view.size < size) ? view.size : size - 1] = '\0';
+}
+
+static void testRandomDirective(void)
+{
+   static char strings[4][256];
+   directive_DirectiveParserProto directive = directive_DirectiveParserProto_init_zero;
+   header_DirectiveHeaderProto *header = &directive.directive.header;
+   pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+
+   directive.has_directive = (nextRandom() % 8 != 0);
+   directive.directive.has_header = (nextRandom() % 8 != 0);
+   randomString(strings[0], sizeof(header->namespace));
+   randomString(strings[1], sizeof(header->name));
+   randomString(strings[2], sizeof(header->messageId));
+   randomString(strings[3], sizeof(header->dialogRequestId));
+   strcpy(header->namespace, strings[0]);
+   strcpy(header->name, strings[1]);
+   strcpy(header->messageId, strings[2]);
+   strcpy(header->dialogRequestId, strings[3]);
+   directive.directive.payload.size = (nextRandom() % 3 == 0) ? 0 : nextRandom() % 300;
+   for(size_t i = 0; i < directive.directive.payload.size; i++) {
+      payload[i] = (uint8_t) nextRandom();
+   }
+   directive.directive.payload.bytes = payload;
+
+   if(!CHECK(pb_encode(&stream, directive_DirectiveParserProto_fields, &directive))) return;
+   if(nextRandom() % 4 == 0) {
+      // An unknown length-delimited field, which both must skip.
+      static uint8_t const unknown[] = { 0x2A, 0x03, 0x01, 0x02, 0x03 };
+      memcpy(&encoded[stream.bytes_written], unknown, sizeof(unknown));
+      stream.bytes_written += sizeof(unknown);
+   }
+   compareVariants(compareDirective, encoded, stream.bytes_written);
+
+   stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+   if(!CHECK(pb_encode(&stream, header_DirectiveHeaderProto_fields, header))) return;
+   compareVariants(compareHeader, encoded, stream.bytes_written);
+}
+
+static void testRandomStateUpdate(void)
+{
+   static alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States states[8];
+   static uint8_t strings[16][256];
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto stateUpdate = { 0, states };
+   pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+
+   stateUpdate.states_count = nextRandom() % 8;
+   for(pb_size_t i = 0; i < stateUpdate.states_count; i++) {
+      states[i].name = randomView(strings[2 * i]);
+      states[i].value = randomView(strings[2 * i + 1]);
+   }
+   if(!CHECK(pb_encode(&stream, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields,
+                       &stateUpdate))) return;
+   compareVariants(compareStateUpdate, encoded, stream.bytes_written);
+}
+
+static void testRandomTempo(void)
+{
+   static alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData tempoData[4];
+   alexaGadgetMusicData_TempoDirectivePayloadProto tempo = { 0, 0, tempoData };
+   pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+
+   tempo.playerOffsetInMilliSeconds = (int32_t) nextRandom();
+   tempo.tempoData_count = nextRandom() % 4;
+   for(pb_size_t i = 0; i < tempo.tempoData_count; i++) {
+      // Negative values take ten bytes on the wire.
+      tempoData[i].value = (nextRandom() % 3 != 0) ? (int32_t) (nextRandom() % 200)
+                                                   : -(int32_t) (nextRandom() % 5);
+      tempoData[i].startOffsetInMilliSeconds = (nextRandom() % 2 != 0) ? 0 : (int32_t) nextRandom();
+   }
+   if(!CHECK(pb_encode(&stream, alexaGadgetMusicData_TempoDirectivePayloadProto_fields, &tempo))) {
+      return;
+   }
+   compareVariants(compareTempo, encoded, stream.bytes_written);
+}
+
+static void testRandomEvent(void)
+{
+   static uint8_t strings[4][256];
+   event_EventParserProto event = event_EventParserProto_init_zero;
+
+   event.has_event = (nextRandom() % 8 != 0);
+   event.event.has_header = (nextRandom() % 8 != 0);
+   event.event.header.namespace = randomView(strings[0]);
+   event.event.header.name = randomView(strings[1]);
+   event.event.header.messageId = randomView(strings[2]);
+   event.event.payload = randomView(strings[3]);
+   compareEvent(&event);
+}
+
+int main(void)
+{
+   testCorpus();
+   for(uint32_t i = 0; i < RANDOM_MESSAGES; i++) {
+      testRandomDirective();
+      testRandomStateUpdate();
+      testRandomTempo();
+      testRandomEvent();
+   }
+   return Host_finish("test_alexa_codec");
+}
@@ -0,0 +1,158 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Fragments and notifications are sized from the ATT MTU negotiated on the
+// connection. The protocol version packet advertises that size, so it waits
+// for the MTU exchange (or its timeout) and goes out exactly once.
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "app.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+static uint8_t discover[128];
+static size_t discoverSize;
+static uint8_t directive[800];
+static size_t directiveSize;
+
+static size_t advertisedFragmentSize(void)
+{
+   return ((size_t) Host_notifications[0][4] << 8U) | Host_notifications[0][5];
+}
+
+static void testProtocolVersionWaitsForExchange(void)
+{
+   AlexaResetAttMtu();
+   Host_resetNotifications();
+   SendAlexaProtocolVerPkt();
+   CHECK(Host_notificationCount == 0);
+   CHECK(Host_softTimers[PROTOCOL_VERSION_TIMER_HANDLE] == MTU_EXCHANGE_TIMEOUT);
+
+   AlexaSetAttMtu(185);
+   CHECK(Host_notificationCount == 1);
+   CHECK(advertisedFragmentSize() == 185 - ATT_HEADER_SIZE);
+   CHECK(Host_softTimers[PROTOCOL_VERSION_TIMER_HANDLE] == 0);
+
+   // A late timer event or a second exchange does not send it again.
+   AlexaProtocolVerTimeout();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   CHECK(Host_notificationCount == 1);
+}
+
+static void testProtocolVersionTimeout(void)
+{
+   AlexaResetAttMtu();
+   Host_resetNotifications();
+   SendAlexaProtocolVerPkt();
+   SendAlexaProtocolVerPkt();
+   CHECK(Host_notificationCount == 0);
+
+   AlexaProtocolVerTimeout();
+   CHECK(Host_notificationCount == 1);
+   CHECK(advertisedFragmentSize() == SAMPLE_DEFAULT_ATT_MTU - ATT_HEADER_SIZE);
+
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   CHECK(Host_notificationCount == 1);
+}
+
+static void testProtocolVersionAfterExchange(void)
+{
+   AlexaResetAttMtu();
+   AlexaSetAttMtu(100);
+   Host_resetNotifications();
+   SendAlexaProtocolVerPkt();
+   CHECK(Host_notificationCount == 1);
+   CHECK(advertisedFragmentSize() == 100 - ATT_HEADER_SIZE);
+}
+
+// The central may write at the negotiated MTU before the exchange event
+// reaches the gadget.
+static void testWriteBeforeExchange(void)
+{
+   size_t acks;
+   size_t failedAcks;
+
+   AlexaResetAttMtu();
+   Host_resetNotifications();
+   CHECK(Host_writeTransaction(ALEXA_STREAM, 1, directive, directiveSize,
+                               SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE - 7) > 1);
+   Host_parseNotifications(&acks, &failedAcks, NULL, 0);
+   CHECK(acks == 1);
+   CHECK(failedAcks == 0);
+}
+
+static void testMtuSweep(void)
+{
+   static uint8_t payload[1024];
+
+   for(uint16_t mtu = SAMPLE_DEFAULT_ATT_MTU; mtu <= SAMPLE_MAX_ATT_MTU; mtu++) {
+      size_t fragmentSize = mtu - ATT_HEADER_SIZE;
+      size_t acks;
+      size_t failedAcks;
+      size_t responseSize;
+      bool fits = true;
+
+      AlexaSetAttMtu(mtu);
+      CHECK(getFragmentSize() == fragmentSize);
+
+      Host_resetNotifications();
+      Host_writeTransaction(ALEXA_STREAM, mtu & TRANSACTION_ID_MASK, discover, discoverSize,
+                            fragmentSize - 7);
+      responseSize = Host_parseNotifications(&acks, &failedAcks, payload, sizeof(payload));
+      CHECK(acks == 1);
+      CHECK(responseSize > 0);
+      CHECK(memmem(payload, responseSize, "Alexa.Gadget.MusicData", 22) != NULL);
+      for(size_t n = 0; n < Host_notificationCount; n++) {
+         fits = fits && Host_notificationLengths[n] <= fragmentSize;
+      }
+      CHECK(fits);
+
+      Host_resetNotifications();
+      Host_writeTransaction(ALEXA_STREAM, (mtu + 1) & TRANSACTION_ID_MASK, directive, directiveSize,
+                            fragmentSize - 7);
+      Host_parseNotifications(&acks, &failedAcks, NULL, 0);
+      CHECK(acks == 1);
+      CHECK(failedAcks == 0);
+   }
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU + 10);
+   CHECK(getFragmentSize() == SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE);
+   AlexaSetAttMtu(SAMPLE_DEFAULT_ATT_MTU - 10);
+   CHECK(getFragmentSize() == SAMPLE_DEFAULT_ATT_MTU - ATT_HEADER_SIZE);
+}
+
+int main(void)
+{
+   // Small enough to frame in 64 writes at the default MTU.
+   static uint8_t data[600];
+
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+   memset(data, 'x', sizeof(data));
+   discoverSize = Host_encodeDirective(discover, sizeof(discover), "Alexa.Discovery", "Discover", NULL, 0);
+   directiveSize = Host_encodeDirective(directive, sizeof(directive), "Custom.ThunderGadget", "Data",
+                                        data, sizeof(data));
+   CHECK(discoverSize > 0);
+   CHECK(directiveSize > sizeof(data));
+
+   testProtocolVersionWaitsForExchange();
+   testProtocolVersionTimeout();
+   testProtocolVersionAfterExchange();
+   testWriteBeforeExchange();
+   testMtuSweep();
+   return Host_finish("test_att_mtu");
+}
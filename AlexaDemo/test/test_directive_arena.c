@@ -0,0 +1,77 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// The directive arena backs pb_realloc, but only while a directive is being
+// dispatched: outside that window it refuses every allocation, so a message
+// with pointer fields decoded anywhere else fails rather than sharing space
+// the next directive will reuse.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alexaGadgetStateListenerStateUpdateDirectivePayload.pb.h"
+#include "corpus.h"
+#include "directive_arena.h"
+#include "host.h"
+#include "pb_decode.h"
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+
+static void testClosedUntilBegin(void)
+{
+   CHECK(DirectiveArena_realloc(NULL, 16) == NULL);
+
+   DirectiveArena_begin();
+   void *block = DirectiveArena_realloc(NULL, 16);
+   CHECK(block != NULL);
+   CHECK(DirectiveArena_realloc(block, 32) == block);
+   CHECK(DirectiveArena_getUsed() > 0);
+
+   DirectiveArena_reset();
+   CHECK(DirectiveArena_getUsed() == 0);
+   CHECK(DirectiveArena_realloc(NULL, 16) == NULL);
+}
+
+static bool decodeStateUpdate(size_t size)
+{
+   alexaGadgetStateListener_StateUpdateDirectivePayloadProto payload;
+   pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+   bool status = pb_decode(&stream, alexaGadgetStateListener_StateUpdateDirectivePayloadProto_fields,
+                           &payload);
+
+   if(status) {
+      CHECK(payload.states_count > 0);
+      CHECK(payload.states != NULL);
+   }
+   return status;
+}
+
+static void testDecodeOnlyForDirective(void)
+{
+   size_t size = Corpus_load("payload_state_update", encoded, sizeof(encoded));
+   if(!CHECK(size > 0)) return;
+
+   CHECK(!decodeStateUpdate(size));
+
+   DirectiveArena_begin();
+   CHECK(decodeStateUpdate(size));
+   DirectiveArena_reset();
+
+   CHECK(!decodeStateUpdate(size));
+}
+
+int main(void)
+{
+   testClosedUntilBegin();
+   testDecodeOnlyForDirective();
+   return Host_finish("test_directive_arena");
+}
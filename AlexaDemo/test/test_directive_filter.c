@@ -0,0 +1,149 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// A streamed directive whose header no route accepts has its payload skipped
+// instead of collected, however large it is, while accepted directives come
+// out exactly as pb_decode() sees them. Checked over a mix of recorded and
+// unrouted directives, fed in fragments of several sizes.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "directive_router.h"
+#include "directive_stream.h"
+#include "directiveParser.pb.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+
+static void handleDirective(uint8_t const *payload, size_t payloadSize)
+{
+}
+
+// Two of the recorded namespaces are routed, the others are not.
+static directive_route_t routes[] = {
+   DIRECTIVE_ROUTE("Alexa.Discovery",            "Discover",    handleDirective),
+   DIRECTIVE_ROUTE("Alexa.Gadget.StateListener", "StateUpdate", handleDirective),
+};
+
+static directive_router_t router = DIRECTIVE_ROUTER(routes);
+static uint32_t filterCalls;
+static directive_stream_t directive;
+static uint8_t encoded[DIRECTIVE_STREAM_PAYLOAD_SIZE * 3];
+static uint8_t payload[DIRECTIVE_STREAM_PAYLOAD_SIZE * 2];
+
+static bool acceptDirective(header_DirectiveHeaderProto const *header)
+{
+   filterCalls++;
+   return DirectiveRouter_accepts(&router, header);
+}
+
+static bool feed(directive_stream_filter_t filter, size_t size, size_t fragmentSize)
+{
+   filterCalls = 0;
+   DirectiveStream_reset(&directive, filter);
+   for(size_t offset = 0; offset < size; offset += fragmentSize) {
+      if(!DirectiveStream_feed(&directive, &encoded[offset], MIN(fragmentSize, size - offset))) {
+         return false;
+      }
+   }
+   return DirectiveStream_finish(&directive);
+}
+
+// Feeds one directive and checks it against pb_decode() of the same bytes.
+static void checkDirective(size_t size, bool routed)
+{
+   static size_t const fragmentSizes[] = { 1, 13, 240, sizeof(encoded) };
+   directive_DirectiveParserProto expected = directive_DirectiveParserProto_init_zero;
+   pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+
+   if(!CHECK(pb_decode(&stream, directive_DirectiveParserProto_fields, &expected))) return;
+   header_DirectiveHeaderProto const *header = &expected.directive.header;
+   pb_view_t const *expectedPayload = &expected.directive.payload;
+
+   for(size_t f = 0; f < ARRAY_SIZE(fragmentSizes); f++) {
+      if(!CHECK(feed(acceptDirective, size, fragmentSizes[f]))) continue;
+      CHECK(filterCalls == 1);
+      CHECK(strcmp(directive.header.namespace, header->namespace) == 0);
+      CHECK(strcmp(directive.header.name, header->name) == 0);
+      CHECK(directive.ignored == !routed);
+      if(routed) {
+         CHECK(directive.payloadSize == expectedPayload->size);
+         CHECK(memcmp(directive.payload, expectedPayload->bytes, expectedPayload->size) == 0);
+      }
+      else {
+         CHECK(directive.payloadSize == 0);
+      }
+   }
+}
+
+static void testRecordedDirectives(void)
+{
+   static struct {
+      char const *name;
+      bool routed;
+   } const recorded[] = {
+      { "directive_discover",        true  },
+      { "directive_state_update",    true  },
+      { "directive_tempo",           false },
+      { "directive_get_data",        false },
+      { "directive_clear_indicator", false },
+   };
+
+   for(size_t i = 0; i < ARRAY_SIZE(recorded); i++) {
+      size_t size = Corpus_load(recorded[i].name, encoded, sizeof(encoded));
+      if(CHECK(size > 0)) {
+         checkDirective(size, recorded[i].routed);
+      }
+   }
+}
+
+static void testUnroutedPayloadIsNotLimited(void)
+{
+   for(size_t i = 0; i < sizeof(payload); i++) {
+      payload[i] = (uint8_t) i;
+   }
+   size_t size = Host_encodeDirective(encoded, sizeof(encoded), "Custom.Unrouted", "Ignored",
+                                      payload, sizeof(payload));
+   CHECK(size > sizeof(payload));
+   checkDirective(size, false);
+
+   // The same payload is refused once something wants it, or with no filter.
+   size = Host_encodeDirective(encoded, sizeof(encoded), "Alexa.Discovery", "Discover",
+                               payload, sizeof(payload));
+   CHECK(!feed(acceptDirective, size, 240));
+   CHECK(strcmp(DirectiveStream_error(&directive), "payload too long") == 0);
+   CHECK(!feed(NULL, size, 240));
+}
+
+static void testNoFilterKeepsEverything(void)
+{
+   size_t size = Host_encodeDirective(encoded, sizeof(encoded), "Custom.Unrouted", "Ignored",
+                                      payload, DIRECTIVE_STREAM_PAYLOAD_SIZE);
+
+   CHECK(feed(NULL, size, 240));
+   CHECK(!directive.ignored);
+   CHECK(directive.payloadSize == DIRECTIVE_STREAM_PAYLOAD_SIZE);
+   CHECK(memcmp(directive.payload, payload, DIRECTIVE_STREAM_PAYLOAD_SIZE) == 0);
+}
+
+int main(void)
+{
+   DirectiveRouter_init(&router);
+
+   testRecordedDirectives();
+   testUnroutedPayloadIsNotLimited();
+   testNoFilterKeepsEverything();
+   return Host_finish("test_directive_filter");
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Built with SAMPLE_HEAP_GUARD and linked with heap_guard.c's allocator
+// wrappers: once HeapGuard_initComplete() has run, the control, directive,
+// event and advertising paths must not reach the heap at all, and an
+// allocation that does is trapped.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "alexa.h"
+#include "corpus.h"
+#include "heap_guard.h"
+#include "helpers.h"
+#include "host.h"
+#include "packet_pool.h"
+#include "tx.h"
+
+#define ROUNDS (4U)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t unrouted[3000];
+
+static void exerciseSteadyState(transaction_id_t id)
+{
+   static char const *const received[] = {
+      "control_get_device_information",
+      "control_get_device_features",
+   };
+   static char const *const directives[] = {
+      "directive_discover",
+      "directive_state_update",
+      "directive_tempo",
+      "directive_get_data",
+      "directive_clear_indicator",
+   };
+   static uint8_t directive[sizeof(unrouted) + 128];
+
+   for(size_t i = 0; i < ARRAY_SIZE(received); i++) {
+      size_t size = Corpus_load(received[i], encoded, sizeof(encoded));
+      Host_resetNotifications();
+      CHECK(Host_writeTransaction(CONTROL_STREAM, id++ & TRANSACTION_ID_MASK, encoded, size, 7) > 0);
+      AlexaTxPump();
+   }
+   // Whole directives in one packet, then the same split into fragments.
+   for(size_t i = 0; i < ARRAY_SIZE(directives); i++) {
+      size_t size = Corpus_load(directives[i], encoded, sizeof(encoded));
+      Host_resetNotifications();
+      CHECK(Host_writeTransaction(ALEXA_STREAM, id++ & TRANSACTION_ID_MASK, encoded, size, 240) > 0);
+      CHECK(Host_writeTransaction(ALEXA_STREAM, id++ & TRANSACTION_ID_MASK, encoded, size, 20) > 1);
+      AlexaTxPump();
+   }
+   size_t size = Host_encodeDirective(directive, sizeof(directive), "Custom.Unrouted", "Ignored",
+                                      unrouted, sizeof(unrouted));
+   Host_resetNotifications();
+   CHECK(Host_writeTransaction(ALEXA_STREAM, id++ & TRANSACTION_ID_MASK, directive, size, 240) > 1);
+
+   Host_resetNotifications();
+   SendSensorData(72, 45000);
+   AlexaTxPump();
+   CHECK(Host_countTransactions(ALEXA_STREAM) == 1);
+
+   // As SetAlexaAdvertisingData() in app.c builds it.
+   for(int pairing = 0; pairing < 2; pairing++) {
+      uint8_t *advertisingData = NULL;
+      CHECK(CreateAlexaAdvertisingData(pairing, &advertisingData) > 0);
+      PacketPool_free(advertisingData);
+   }
+
+   // A connection that closes and reopens.
+   AlexaRxExpireTransactions(true);
+   AlexaTxFlush();
+   AlexaResetAttMtu();
+   Host_resetNotifications();
+   SendAlexaProtocolVerPkt();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   AlexaTxPump();
+   CHECK(Host_notificationCount > 0);
+}
+
+static void testSteadyStateDoesNotAllocate(void)
+{
+   for(uint32_t round = 0; round < ROUNDS; round++) {
+      exerciseSteadyState((transaction_id_t) (round * 16U));
+   }
+   CHECK(HeapGuard_getSteadyStateAllocations() == 0);
+   CHECK(Host_breakpoints == 0);
+   CHECK(Host_systemResets == 0);
+}
+
+static void testAllocationIsTrapped(void)
+{
+   void *volatile block = malloc(16);
+
+   CHECK(HeapGuard_getSteadyStateAllocations() == 1);
+   CHECK(Host_breakpoints == 1);
+   CHECK(Host_systemResets == 1);
+   free(block);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   HeapGuard_initComplete();
+
+   testSteadyStateDoesNotAllocate();
+   testAllocationIsTrapped();
+   return Host_finish("test_heap_guard");
+}
@@ -0,0 +1,215 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// The packet pools hand out fixed blocks without touching the heap, and after
+// millions of mixed allocations every block can still be allocated again: no
+// capacity is lost to fragmentation. Packet lists built from the pools frame
+// a transaction the same way the TX ring does.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "packet_pool.h"
+#include "tx.h"
+
+#define STRESS_CYCLES   (2000000U)
+#define LIST_CYCLES     (1000000U)
+#define TOTAL_BLOCKS    (SAMPLE_PACKET_POOL_NODES + SAMPLE_PACKET_POOL_SHORT_PACKETS + \
+                         SAMPLE_PACKET_POOL_FRAGMENTS)
+
+static size_t const sizes[] = {
+   CONTROL_PACKET_LENGTH, sizeof(packet_list_t), PROTOCOL_VERSION_PACKET_SIZE,
+   ADV_DATA_LEN, SAMPLE_DEFAULT_ATT_MTU - ATT_HEADER_SIZE, SAMPLE_MAX_ATT_MTU - ATT_HEADER_SIZE,
+};
+
+static uint32_t totalFailures(void)
+{
+   uint32_t failures = 0;
+   for(packet_pool_t pool = 0; pool < PACKET_POOL_COUNT; pool++) {
+      failures += PacketPool_getFailures(pool);
+   }
+   return failures;
+}
+
+static size_t totalInUse(void)
+{
+   size_t inUse = 0;
+   for(packet_pool_t pool = 0; pool < PACKET_POOL_COUNT; pool++) {
+      inUse += PacketPool_getInUse(pool);
+   }
+   return inUse;
+}
+
+static void testNoCapacityLost(void)
+{
+   static uint8_t *live[TOTAL_BLOCKS];
+   static size_t liveSizes[TOTAL_BLOCKS];
+   size_t liveCount = 0;
+   uint32_t refused = 0;
+
+   srand(1);
+   Host_resetAllocations();
+   for(uint32_t cycle = 0; cycle < STRESS_CYCLES; cycle++) {
+      if(liveCount > 0 && (liveCount == TOTAL_BLOCKS || (rand() & 1))) {
+         size_t victim = (size_t) rand() % liveCount;
+         // The block still holds what was written into it.
+         if(live[victim][0] != (uint8_t) liveSizes[victim] ||
+            live[victim][liveSizes[victim] - 1] != (uint8_t) liveSizes[victim])
+         {
+            CHECK(false);
+         }
+         PacketPool_free(live[victim]);
+         live[victim] = live[--liveCount];
+         liveSizes[victim] = liveSizes[liveCount];
+         continue;
+      }
+      size_t size = sizes[(size_t) rand() % ARRAY_SIZE(sizes)];
+      uint8_t *block = PacketPool_alloc(size);
+      if(block == NULL) {
+         refused++;
+         continue;
+      }
+      block[0] = (uint8_t) size;
+      block[size - 1] = (uint8_t) size;
+      live[liveCount] = block;
+      liveSizes[liveCount++] = size;
+   }
+   CHECK(Host_allocations == 0);
+   CHECK(totalInUse() == liveCount);
+   while(liveCount > 0) {
+      PacketPool_free(live[--liveCount]);
+   }
+   CHECK(totalInUse() == 0);
+
+   // Every block of every pool can be allocated again, and the largest
+   // requests still find all of the fragment blocks.
+   for(size_t i = 0; i < SAMPLE_PACKET_POOL_FRAGMENTS; i++) {
+      live[liveCount++] = PacketPool_alloc(SAMPLE_MAX_ATT_MTU);
+      CHECK(live[liveCount - 1] != NULL);
+   }
+   CHECK(PacketPool_alloc(SAMPLE_MAX_ATT_MTU) == NULL);
+   while(liveCount < TOTAL_BLOCKS) {
+      live[liveCount++] = PacketPool_alloc(1);
+      CHECK(live[liveCount - 1] != NULL);
+   }
+   CHECK(PacketPool_alloc(1) == NULL);
+   CHECK(totalInUse() == TOTAL_BLOCKS);
+   while(liveCount > 0) {
+      PacketPool_free(live[--liveCount]);
+   }
+   CHECK(totalInUse() == 0);
+   CHECK(refused > 0);
+}
+
+// Checks that the list carries payload as one transaction on streamId.
+static bool checkFraming(packet_list_t const *list, stream_id_t streamId,
+                         uint8_t const *payload, size_t payloadSize)
+{
+   size_t received = 0;
+   uint8_t seqNum = 0;
+
+   for(packet_list_t const *node = list; node != NULL; node = node->next) {
+      uint8_t const *data = node->packet.data;
+      transaction_type_t type = (data[1] >> TRANSACTION_TYPE_SHIFT) & TRANSACTION_TYPE_MASK;
+      transaction_type_t expected = (node == list) ? TRANSACTION_TYPE_INITIAL :
+         (node->next == NULL) ? TRANSACTION_TYPE_FINAL : TRANSACTION_TYPE_CONTINUE;
+      size_t offset = 2;
+
+      if(node->packet.dataSize > getFragmentSize() || type != expected ||
+         ((data[0] >> STREAM_ID_SHIFT) & STREAM_ID_MASK) != streamId ||
+         ((data[1] >> SEQ_NUM_ID_SHIFT) & SEQ_NUM_ID_MASK) != seqNum)
+      {
+         return false;
+      }
+      if(type == TRANSACTION_TYPE_INITIAL) {
+         if((((size_t) data[3] << 8U) | data[4]) != payloadSize) return false;
+         offset += 3;
+      }
+      size_t length = data[offset++];
+      if(offset + length != node->packet.dataSize ||
+         memcmp(&data[offset], &payload[received], length) != 0)
+      {
+         return false;
+      }
+      received += length;
+      seqNum = (seqNum + 1) & SEQ_NUM_ID_MASK;
+   }
+   return received == payloadSize;
+}
+
+static void testPacketLists(void)
+{
+   static uint8_t payload[600];
+   uint32_t poolFailures = totalFailures();
+   uint32_t failures = 0;
+
+   for(size_t i = 0; i < sizeof(payload); i++) {
+      payload[i] = (uint8_t) (i * 7U);
+   }
+
+   Host_resetAllocations();
+   for(uint32_t cycle = 0; cycle < LIST_CYCLES; cycle++) {
+      size_t payloadSize = 1 + cycle % sizeof(payload);
+      packet_t ack = createControlAckPacket(ALEXA_STREAM, cycle & TRANSACTION_ID_MASK, true,
+                                            CONTROL_PACKET_RESULT_SUCCESS);
+      packet_list_t *list = PacketList_addToTail(NULL, &ack);
+      packet_list_t *fragments = buildStreamPacket(ALEXA_STREAM, true, payload, payloadSize);
+
+      if(ack.data == NULL || list == NULL || fragments == NULL ||
+         !checkFraming(fragments, ALEXA_STREAM, payload, payloadSize))
+      {
+         failures++;
+      }
+      size_t count = PacketList_getSize(fragments);
+      list = PacketList_appendList(list, fragments);
+      if(PacketList_getSize(list) != count + 1 || list->tail->next != NULL) {
+         failures++;
+      }
+      PacketList_freeList(list);
+      if(totalInUse() != 0) {
+         failures++;
+      }
+   }
+   CHECK(failures == 0);
+   CHECK(Host_allocations == 0);
+   CHECK(totalFailures() == poolFailures);
+}
+
+static void testExhaustedPoolFailsCleanly(void)
+{
+   static uint8_t payload[SAMPLE_TX_RING_SIZE];
+   uint32_t failures = totalFailures();
+
+   // More fragments than there are blocks: nothing is returned and nothing
+   // stays allocated.
+   CHECK(buildStreamPacket(ALEXA_STREAM, true, payload, sizeof(payload)) == NULL);
+   CHECK(totalInUse() == 0);
+   CHECK(totalFailures() > failures);
+
+   packet_t ack = createControlAckPacket(CONTROL_STREAM, 1, false, CONTROL_PACKET_RESULT_SUCCESS);
+   CHECK(ack.data == NULL);
+}
+
+int main(void)
+{
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   testNoCapacityLost();
+   testPacketLists();
+   AlexaSetAttMtu(SAMPLE_DEFAULT_ATT_MTU);
+   testExhaustedPoolFailsCleanly();
+   return Host_finish("test_packet_pool");
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Submessages written to a memory buffer are encoded once, behind a one byte
+// length placeholder that is patched, and widened if needed, afterwards.
+// Other streams size every submessage first. Both must produce the same bytes
+// and a buffer that is too small must fail without writing past its end.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "directive_arena.h"
+#include "eventParser.pb.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+#define GUARD (0x5AU)
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t output[CORPUS_MAX_MESSAGE_SIZE + 16];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+// Submessage substreams share the state, so it is the write position.
+static bool writeCallback(pb_ostream_t *stream, pb_byte_t const *buf, size_t count)
+{
+   memcpy(stream->state, buf, count);
+   stream->state = (uint8_t *) stream->state + count;
+   return true;
+}
+
+// A stream that is not a memory buffer, so submessages take the sizing pass.
+static pb_ostream_t callbackStream(uint8_t *buffer, size_t size)
+{
+   pb_ostream_t stream = { writeCallback, buffer, size, 0 };
+   return stream;
+}
+
+static void checkBothPaths(pb_msgdesc_t const *fields, void const *src, uint8_t const *expected,
+                           size_t expectedSize)
+{
+   memset(output, GUARD, sizeof(output));
+   pb_ostream_t stream = pb_ostream_from_buffer(output, sizeof(output));
+   CHECK(pb_encode(&stream, fields, src));
+   CHECK(stream.bytes_written == expectedSize);
+   CHECK(memcmp(output, expected, expectedSize) == 0);
+
+   memset(output, GUARD, sizeof(output));
+   stream = callbackStream(output, sizeof(output));
+   CHECK(pb_encode(&stream, fields, src));
+   CHECK(stream.bytes_written == expectedSize);
+   CHECK(memcmp(output, expected, expectedSize) == 0);
+}
+
+static void checkTooSmall(pb_msgdesc_t const *fields, void const *src, size_t size)
+{
+   bool failed = true;
+   bool guarded = true;
+
+   for(size_t maxSize = 0; maxSize < size; maxSize++) {
+      memset(output, GUARD, sizeof(output));
+      pb_ostream_t stream = pb_ostream_from_buffer(output, maxSize);
+      failed = failed && !pb_encode(&stream, fields, src);
+      for(size_t i = maxSize; i < sizeof(output); i++) {
+         guarded = guarded && output[i] == GUARD;
+      }
+   }
+   CHECK(failed);
+   CHECK(guarded);
+}
+
+static void testCorpus(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      corpus_entry_t const *entry = &Corpus_entries[e];
+      size_t size = Corpus_load(entry->name, encoded, sizeof(encoded));
+      pb_istream_t stream = pb_istream_from_buffer(encoded, size);
+
+      if(!CHECK(size > 0)) continue;
+      DirectiveArena_begin();
+      CHECK(pb_decode(&stream, entry->fields, decoded.bytes));
+      checkBothPaths(entry->fields, decoded.bytes, encoded, size);
+      checkTooSmall(entry->fields, decoded.bytes, size);
+   }
+   DirectiveArena_reset();
+}
+
+// The event submessage crosses the one and two byte length boundaries as the
+// payload grows.
+static void testLengthBoundaries(void)
+{
+   static uint8_t payload[300];
+   static uint8_t expected[sizeof(payload) + 64];
+   event_EventParserProto event = event_EventParserProto_init_zero;
+
+   memset(payload, 'p', sizeof(payload));
+   event.has_event = true;
+   event.event.has_header = true;
+   event.event.header.namespace.bytes = (pb_byte_t const *) "Custom.ThunderGadget";
+   event.event.header.namespace.size = 20;
+   event.event.header.name.bytes = (pb_byte_t const *) "GetDataReport";
+   event.event.header.name.size = 13;
+   event.event.payload.bytes = payload;
+
+   for(pb_size_t size = 60; size <= sizeof(payload); size++) {
+      event.event.payload.size = size;
+      pb_ostream_t stream = callbackStream(expected, sizeof(expected));
+      CHECK(pb_encode(&stream, event_EventParserProto_fields, &event));
+      checkBothPaths(event_EventParserProto_fields, &event, expected, stream.bytes_written);
+   }
+}
+
+int main(void)
+{
+   testCorpus();
+   testLengthBoundaries();
+   return Host_finish("test_pb_encode");
+}
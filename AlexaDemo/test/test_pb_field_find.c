@@ -0,0 +1,159 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// pb_field_iter_find() jumps to a field through the descriptor's tag table.
+// For every descriptor and every tag it must land where a walk through the
+// descriptor finds the same tag, and report unknown tags as before.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "accessories.pb.h"
+#include "alexaDiscoveryDiscoverDirective.pb.h"
+#include "alexaDiscoveryDiscoverDirectivePayload.pb.h"
+#include "alexaDiscoveryDiscoverResponseEvent.pb.h"
+#include "alexaDiscoveryDiscoverResponseEventPayload.pb.h"
+#include "alexaGadgetMusicDataTempoDirective.pb.h"
+#include "alexaGadgetMusicDataTempoDirectivePayload.pb.h"
+#include "alexaGadgetStateListenerStateUpdateDirective.pb.h"
+#include "alexaGadgetStateListenerStateUpdateDirectivePayload.pb.h"
+#include "common.pb.h"
+#include "device.pb.h"
+#include "directiveHeader.pb.h"
+#include "directiveParser.pb.h"
+#include "eventHeader.pb.h"
+#include "eventParser.pb.h"
+#include "firmware.pb.h"
+#include "notificationsClearIndicatorDirective.pb.h"
+#include "notificationsClearIndicatorDirectivePayload.pb.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_common.h"
+
+#define MAX_TAG (200U)
+
+typedef struct {
+   char const *name;
+   pb_msgdesc_t const *fields;
+} descriptor_t;
+
+#define DESCRIPTOR(type) { #type, type##_fields }
+
+static descriptor_t const descriptors[] = {
+   DESCRIPTOR(Response),
+   DESCRIPTOR(ControlEnvelope),
+   DESCRIPTOR(alexaDiscovery_DiscoverDirectiveProto),
+   DESCRIPTOR(alexaDiscovery_DiscoverDirectiveProto_Directive),
+   DESCRIPTOR(alexaDiscovery_DiscoverDirectivePayloadProto),
+   DESCRIPTOR(alexaDiscovery_DiscoverDirectivePayloadProto_Scope),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventProto),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventProto_Event),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_Capabilities_Configuration_SupportedTypes),
+   DESCRIPTOR(alexaDiscovery_DiscoverResponseEventPayloadProto_Endpoints_AdditionalIdentification),
+   DESCRIPTOR(alexaGadgetMusicData_TempoDirectiveProto),
+   DESCRIPTOR(alexaGadgetMusicData_TempoDirectiveProto_Directive),
+   DESCRIPTOR(alexaGadgetMusicData_TempoDirectivePayloadProto),
+   DESCRIPTOR(alexaGadgetMusicData_TempoDirectivePayloadProto_TempoData),
+   DESCRIPTOR(alexaGadgetStateListener_StateUpdateDirectiveProto),
+   DESCRIPTOR(alexaGadgetStateListener_StateUpdateDirectiveProto_Directive),
+   DESCRIPTOR(alexaGadgetStateListener_StateUpdateDirectivePayloadProto),
+   DESCRIPTOR(alexaGadgetStateListener_StateUpdateDirectivePayloadProto_States),
+   DESCRIPTOR(DeviceInformation),
+   DESCRIPTOR(GetDeviceInformation),
+   DESCRIPTOR(DeviceFeatures),
+   DESCRIPTOR(GetDeviceFeatures),
+   DESCRIPTOR(header_DirectiveHeaderProto),
+   DESCRIPTOR(directive_DirectiveParserProto),
+   DESCRIPTOR(directive_DirectiveParserProto_Directive),
+   DESCRIPTOR(header_EventHeaderProto),
+   DESCRIPTOR(event_EventParserProto),
+   DESCRIPTOR(event_EventParserProto_Event),
+   DESCRIPTOR(FirmwareComponent),
+   DESCRIPTOR(FirmwareInformation),
+   DESCRIPTOR(UpdateComponentSegment),
+   DESCRIPTOR(ApplyFirmware),
+   DESCRIPTOR(notifications_ClearIndicatorDirectiveProto),
+   DESCRIPTOR(notifications_ClearIndicatorDirectiveProto_Directive),
+   DESCRIPTOR(notifications_ClearIndicatorDirectivePayloadProto),
+};
+
+static union {
+   uint8_t bytes[4096];
+   uint64_t align;
+} message;
+
+// The field with the tag, found by walking the whole descriptor from the start.
+static bool walk(pb_field_iter_t *iter, pb_msgdesc_t const *fields, uint32_t tag)
+{
+   if(!pb_field_iter_begin(iter, fields, message.bytes)) {
+      return false;
+   }
+   do {
+      if(iter->tag == tag) {
+         return true;
+      }
+   } while(pb_field_iter_next(iter));
+   return false;
+}
+
+static void testDescriptor(descriptor_t const *descriptor)
+{
+   bool matched = true;
+
+   for(uint32_t tag = 0; tag < MAX_TAG; tag++) {
+      pb_field_iter_t expected;
+      bool known = walk(&expected, descriptor->fields, tag);
+
+      // Start from every field, as the decoder does.
+      pb_field_iter_t start;
+      bool more = pb_field_iter_begin(&start, descriptor->fields, message.bytes);
+      while(more) {
+         pb_field_iter_t iter = start;
+         bool found = pb_field_iter_find(&iter, tag);
+
+         matched = matched && found == known;
+         if(found && known) {
+            matched = matched &&
+               iter.index == expected.index &&
+               iter.field_info_index == expected.field_info_index &&
+               iter.submessage_index == expected.submessage_index &&
+               iter.required_field_index == expected.required_field_index &&
+               iter.tag == expected.tag &&
+               iter.type == expected.type &&
+               iter.pData == expected.pData &&
+               iter.pSize == expected.pSize &&
+               iter.submsg_desc == expected.submsg_desc;
+         }
+         if(!found) {
+            // A miss leaves the iterator where it was.
+            matched = matched && iter.index == start.index;
+         }
+         more = pb_field_iter_next(&start);
+      }
+   }
+   if(!CHECK(matched)) {
+      fprintf(stderr, "%s: pb_field_iter_find differs from a walk\n", descriptor->name);
+   }
+}
+
+int main(void)
+{
+   for(size_t d = 0; d < ARRAY_SIZE(descriptors); d++) {
+      testDescriptor(&descriptors[d]);
+   }
+   return Host_finish("test_pb_field_find");
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// PB_DECODE_NOCLEAR resets only presence (has_ flags, counts, which_ fields
+// and empty scalars) instead of clearing the whole destination, so it must
+// give the same message as pb_decode() whatever the struct held before.
+// Handlers that decode this way must check presence before reading.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "accessories.pb.h"
+#include "alexa.h"
+#include "app.h"
+#include "corpus.h"
+#include "directive_arena.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+
+static uint8_t encoded[CORPUS_MAX_MESSAGE_SIZE];
+static uint8_t reencoded[CORPUS_MAX_MESSAGE_SIZE];
+static union {
+   uint8_t bytes[CORPUS_MAX_STRUCT_SIZE];
+   uint64_t align;
+} decoded;
+
+// Decodes without clearing and checks the message encodes back unchanged.
+static void checkRoundTrip(corpus_entry_t const *entry, size_t size)
+{
+   pb_istream_t input = pb_istream_from_buffer(encoded, size);
+   pb_ostream_t output = pb_ostream_from_buffer(reencoded, sizeof(reencoded));
+
+   if(!CHECK(pb_decode_ex(&input, entry->fields, decoded.bytes, PB_DECODE_NOCLEAR))) return;
+   CHECK(pb_encode(&output, entry->fields, decoded.bytes));
+   CHECK(output.bytes_written == size);
+   CHECK(memcmp(reencoded, encoded, size) == 0);
+}
+
+static void testOverGarbage(void)
+{
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      size_t size = Corpus_load(Corpus_entries[e].name, encoded, sizeof(encoded));
+      if(!CHECK(size > 0)) continue;
+      memset(decoded.bytes, 0xA5, sizeof(decoded.bytes));
+      DirectiveArena_begin();
+      checkRoundTrip(&Corpus_entries[e], size);
+      DirectiveArena_reset();
+   }
+}
+
+// A message decoded over a fuller one of the same type keeps nothing of it.
+// A NULL next message is an empty one.
+static void testOverPreviousMessage(char const *previous, char const *next)
+{
+   corpus_entry_t const *entry = NULL;
+   size_t size;
+
+   for(size_t e = 0; e < Corpus_entryCount; e++) {
+      if(strcmp(Corpus_entries[e].name, previous) == 0) {
+         entry = &Corpus_entries[e];
+      }
+   }
+   if(!CHECK(entry != NULL)) return;
+   size = Corpus_load(previous, encoded, sizeof(encoded));
+   memset(decoded.bytes, 0, sizeof(decoded.bytes));
+   DirectiveArena_begin();
+   checkRoundTrip(entry, size);
+   size = (next != NULL) ? Corpus_load(next, encoded, sizeof(encoded)) : 0;
+   checkRoundTrip(entry, size);
+   DirectiveArena_reset();
+}
+
+static ControlEnvelope respondToCommand(Command command)
+{
+   static uint8_t payload[CORPUS_MAX_MESSAGE_SIZE];
+   ControlEnvelope envelope = ControlEnvelope_init_default;
+   size_t payloadSize = Host_encodeCommand(payload, sizeof(payload), command);
+
+   Host_resetNotifications();
+   Host_writeTransaction(CONTROL_STREAM, 1, payload, payloadSize, SAMPLE_MAX_ATT_MTU);
+   payloadSize = Host_parseNotifications(NULL, NULL, payload, sizeof(payload));
+   pb_istream_t stream = pb_istream_from_buffer(payload, payloadSize);
+   CHECK(pb_decode(&stream, ControlEnvelope_fields, &envelope));
+   return envelope;
+}
+
+// Firmware commands without their payload are refused rather than handled
+// with whatever the envelope held.
+static void testCommandsWithoutPayload(void)
+{
+   ControlEnvelope envelope = respondToCommand(Command_UPDATE_COMPONENT_SEGMENT);
+   CHECK(envelope.command == Command_UPDATE_COMPONENT_SEGMENT);
+   CHECK(envelope.payload.response.error_code == ErrorCode_INVALID);
+
+   envelope = respondToCommand(Command_APPLY_FIRMWARE);
+   CHECK(envelope.command == Command_APPLY_FIRMWARE);
+   CHECK(envelope.payload.response.error_code == ErrorCode_INVALID);
+}
+
+static void sendTempo(uint8_t const *tempo, size_t tempoSize)
+{
+   static uint8_t directive[CORPUS_MAX_MESSAGE_SIZE];
+   size_t directiveSize = Host_encodeDirective(directive, sizeof(directive), "Alexa.Gadget.MusicData",
+                                               "Tempo", tempo, tempoSize);
+   Host_writeTransaction(ALEXA_STREAM, 2, directive, directiveSize, SAMPLE_MAX_ATT_MTU - 10);
+}
+
+// A Tempo payload without entries ends the song instead of reading entry 0.
+static void testTempoWithoutEntries(void)
+{
+   size_t size = Corpus_load("payload_tempo", encoded, sizeof(encoded));
+
+   sendTempo(encoded, size);
+   CHECK(Host_softTimers[TEMPO_TIMER_HANDLE] == (32768U * 60U) / (120U * 2U));
+
+   // Only playerOffsetInMilliSeconds.
+   static uint8_t const noEntries[] = { 0x08, 0x10 };
+   gLedOn = true;
+   sendTempo(noEntries, sizeof(noEntries));
+   CHECK(!gLedOn);
+   CHECK(Host_softTimers[TEMPO_TIMER_HANDLE] == 0);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   testOverGarbage();
+   testOverPreviousMessage("response_device_information", "control_get_device_information");
+   testOverPreviousMessage("directive_state_update", "directive_clear_indicator");
+   testOverPreviousMessage("payload_state_update", NULL);
+   testOverPreviousMessage("event_discover_response", NULL);
+   testCommandsWithoutPayload();
+   testTempoWithoutEntries();
+   return Host_finish("test_pb_noclear");
+}
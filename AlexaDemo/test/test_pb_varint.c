@@ -0,0 +1,148 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Varints and tags in memory buffer streams are decoded straight from the
+// buffer. A stream with its own read callback takes the byte by byte
+// decoder, so the two are compared on the same input: same value, same
+// bytes consumed, and the same failures for truncated and overlong input.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+
+#define RANDOM_INPUTS (200000U)
+
+static uint32_t seed = 0x2545F491U;
+
+static uint32_t nextRandom(void)
+{
+   seed ^= seed << 13;
+   seed ^= seed >> 17;
+   seed ^= seed << 5;
+   return seed;
+}
+
+static bool readCallback(pb_istream_t *stream, pb_byte_t *buf, size_t count)
+{
+   memcpy(buf, stream->state, count);
+   stream->state = (pb_byte_t *) stream->state + count;
+   return true;
+}
+
+static pb_istream_t callbackStream(uint8_t const *buffer, size_t size)
+{
+   pb_istream_t stream = { readCallback, (void *) buffer, size };
+   return stream;
+}
+
+static void compare(uint8_t const *input, size_t size)
+{
+   pb_istream_t fast = pb_istream_from_buffer(input, size);
+   pb_istream_t slow = callbackStream(input, size);
+   uint32_t fast32 = 0;
+   uint32_t slow32 = 0;
+   bool fastStatus = pb_decode_varint32(&fast, &fast32);
+   bool slowStatus = pb_decode_varint32(&slow, &slow32);
+
+   CHECK(fastStatus == slowStatus);
+   CHECK(fast.bytes_left == slow.bytes_left || !fastStatus);
+   CHECK(fast32 == slow32 || !fastStatus);
+
+   uint64_t fast64 = 0;
+   uint64_t slow64 = 0;
+   fast = pb_istream_from_buffer(input, size);
+   slow = callbackStream(input, size);
+   fastStatus = pb_decode_varint(&fast, &fast64);
+   slowStatus = pb_decode_varint(&slow, &slow64);
+   CHECK(fastStatus == slowStatus);
+   CHECK(fast.bytes_left == slow.bytes_left || !fastStatus);
+   CHECK(fast64 == slow64 || !fastStatus);
+
+   pb_wire_type_t fastType = PB_WT_VARINT;
+   pb_wire_type_t slowType = PB_WT_VARINT;
+   bool fastEof = false;
+   bool slowEof = false;
+   fast = pb_istream_from_buffer(input, size);
+   slow = callbackStream(input, size);
+   fastStatus = pb_decode_tag(&fast, &fastType, &fast32, &fastEof);
+   slowStatus = pb_decode_tag(&slow, &slowType, &slow32, &slowEof);
+   CHECK(fastStatus == slowStatus);
+   CHECK(fastEof == slowEof);
+   if(fastStatus) {
+      CHECK(fastType == slowType);
+      CHECK(fast32 == slow32);
+      CHECK(fast.bytes_left == slow.bytes_left);
+   }
+}
+
+static void testKnownValues(void)
+{
+   static struct {
+      uint8_t bytes[10];
+      size_t size;
+      uint32_t value;
+   } const vectors[] = {
+      { { 0x00 }, 1, 0 },
+      { { 0x7F }, 1, 127 },
+      { { 0x80, 0x01 }, 2, 128 },
+      { { 0xAC, 0x02 }, 2, 300 },
+      { { 0xFF, 0xFF, 0x7F }, 3, 0x1FFFFF },
+      { { 0xFF, 0xFF, 0xFF, 0x7F }, 4, 0xFFFFFFF },
+      { { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F }, 5, 0xFFFFFFFFU },
+      { { 0x80, 0x80, 0x80, 0x00 }, 4, 0 },
+   };
+
+   for(size_t v = 0; v < ARRAY_SIZE(vectors); v++) {
+      uint8_t input[16];
+      uint32_t value = 0;
+
+      // Trailing bytes that are not part of the varint must be left alone.
+      memset(input, 0xFF, sizeof(input));
+      memcpy(input, vectors[v].bytes, vectors[v].size);
+      pb_istream_t stream = pb_istream_from_buffer(input, sizeof(input));
+      CHECK(pb_decode_varint32(&stream, &value));
+      CHECK(value == vectors[v].value);
+      CHECK(stream.bytes_left == sizeof(input) - vectors[v].size);
+      compare(input, vectors[v].size);
+      compare(input, vectors[v].size - 1);
+   }
+}
+
+static void testRandomInputs(void)
+{
+   for(uint32_t i = 0; i < RANDOM_INPUTS; i++) {
+      uint8_t input[12];
+      size_t size = 1 + nextRandom() % 11;
+      size_t varintSize = 1 + nextRandom() % 11;
+
+      // Continuation bits up to a random length, so truncated, overlong and
+      // well formed values all turn up.
+      for(size_t b = 0; b < sizeof(input); b++) {
+         input[b] = (uint8_t) (nextRandom() & 0x7F);
+         if(b + 1 < varintSize) {
+            input[b] |= 0x80;
+         }
+      }
+      compare(input, size);
+   }
+}
+
+int main(void)
+{
+   testKnownValues();
+   testRandomInputs();
+   return Host_finish("test_pb_varint");
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// The identity responses are answered from encodings cached by
+// AlexaRefreshResponseCache(). They are encoded on demand until the cache is
+// filled, and carry the new identity once it is refreshed.
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+static uint8_t payload[1024];
+
+static size_t respond(bool (*create)(void))
+{
+   Host_resetNotifications();
+   Host_resetAllocations();
+   CHECK(create());
+   AlexaTxPump();
+   CHECK(Host_allocations == 0);
+   return Host_parseNotifications(NULL, NULL, payload, sizeof(payload));
+}
+
+static bool contains(size_t payloadSize, char const *text)
+{
+   return memmem(payload, payloadSize, text, strlen(text)) != NULL;
+}
+
+static void setIdentity(char const *serialNumber, char token)
+{
+   snprintf(gAlexaSn, sizeof(gAlexaSn), "%s", serialNumber);
+   memset(gDeviceToken, token, 64);
+   gDeviceToken[64] = 0;
+}
+
+static void testIdentityChange(void)
+{
+   static char token[65];
+   size_t size;
+
+   setIdentity("Demo0123456789", 'a');
+   AlexaRefreshResponseCache();
+   size = respond(CreateDiscoveryResponse);
+   CHECK(contains(size, "Demo0123456789"));
+
+   // The cache holds the identity it was filled with until it is refreshed.
+   setIdentity("Demo9876543210", 'b');
+   size = respond(CreateDiscoveryResponse);
+   CHECK(contains(size, "Demo0123456789"));
+
+   AlexaRefreshResponseCache();
+   size = respond(CreateDiscoveryResponse);
+   CHECK(contains(size, "Demo9876543210"));
+   CHECK(!contains(size, "Demo0123456789"));
+   memset(token, 'b', 64);
+   CHECK(contains(size, token));
+   size = respond(createResponseGetDeviceInformation);
+   CHECK(contains(size, "Demo9876543210"));
+}
+
+static void testEncodedBeforeRefresh(void)
+{
+   static uint8_t encoded[1024];
+   size_t encodedSize;
+
+   setIdentity("Demo0123456789", 'a');
+   encodedSize = respond(CreateDiscoveryResponse);
+   CHECK(contains(encodedSize, "Demo0123456789"));
+   memcpy(encoded, payload, encodedSize);
+
+   AlexaRefreshResponseCache();
+   CHECK(respond(CreateDiscoveryResponse) == encodedSize);
+   CHECK(memcmp(payload, encoded, encodedSize) == 0);
+}
+
+int main(void)
+{
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   testEncodedBeforeRefresh();
+   testIdentityChange();
+   return Host_finish("test_response_cache");
+}
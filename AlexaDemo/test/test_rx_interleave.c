@@ -0,0 +1,128 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Transactions in flight are keyed by stream and transaction id, so fragments
+// of several transactions may arrive interleaved. When every slot is busy the
+// least recently used transaction of the same kind gives way.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+#define MAX_WRITES (32U)
+
+typedef struct {
+   uint8_t writes[MAX_WRITES][SAMPLE_MAX_ATT_MTU];
+   size_t writeSizes[MAX_WRITES];
+   size_t count;
+} transaction_t;
+
+static transaction_t transactions[4];
+static uint8_t discover[128];
+static size_t discoverSize;
+
+static void frame(transaction_t *transaction, stream_id_t streamId, transaction_id_t transactionId,
+                  uint8_t const *payload, size_t payloadSize, size_t fragmentPayload)
+{
+   transaction->count = Host_frameTransaction(transaction->writes, transaction->writeSizes,
+                                              MAX_WRITES, streamId, transactionId, true,
+                                              payload, payloadSize, fragmentPayload);
+   CHECK(transaction->count > 1);
+}
+
+// Sends fragment i of every transaction in turn.
+static void sendInterleaved(transaction_t *list, size_t listSize)
+{
+   bool sent = true;
+   for(size_t i = 0; sent; i++) {
+      sent = false;
+      for(size_t t = 0; t < listSize; t++) {
+         if(i < list[t].count) {
+            AlexaRxPacket(list[t].writes[i], (uint8_t) list[t].writeSizes[i]);
+            sent = true;
+         }
+      }
+   }
+}
+
+static void testInterleavedStreams(void)
+{
+   uint8_t information[32];
+   uint8_t features[32];
+   size_t informationSize = Host_encodeCommand(information, sizeof(information), Command_GET_DEVICE_INFORMATION);
+   size_t featuresSize = Host_encodeCommand(features, sizeof(features), Command_GET_DEVICE_FEATURES);
+   size_t acks;
+   size_t failedAcks;
+
+   frame(&transactions[0], ALEXA_STREAM, 1, discover, discoverSize, 8);
+   frame(&transactions[1], CONTROL_STREAM, 1, information, informationSize, 1);
+   frame(&transactions[2], ALEXA_STREAM, 2, discover, discoverSize, 8);
+   frame(&transactions[3], CONTROL_STREAM, 2, features, featuresSize, 1);
+
+   Host_resetNotifications();
+   sendInterleaved(transactions, 4);
+   Host_parseNotifications(&acks, &failedAcks, NULL, 0);
+   CHECK(acks == 4);
+   CHECK(failedAcks == 0);
+   CHECK(Host_countTransactions(ALEXA_STREAM) == 2);
+   CHECK(Host_countTransactions(CONTROL_STREAM) == 2);
+}
+
+static void testLeastRecentlyUsedIsEvicted(void)
+{
+   size_t acks;
+   size_t failedAcks;
+
+   // One more directive than there are directive slots: the first one has
+   // been idle the longest once the last one starts, and is dropped.
+   for(transaction_id_t id = 0; id <= SAMPLE_RX_DIRECTIVE_TRANSACTIONS; id++) {
+      frame(&transactions[id], ALEXA_STREAM, id + 4, discover, discoverSize, 8);
+   }
+   Host_resetNotifications();
+   sendInterleaved(transactions, SAMPLE_RX_DIRECTIVE_TRANSACTIONS + 1);
+   Host_parseNotifications(&acks, &failedAcks, NULL, 0);
+   CHECK(acks == SAMPLE_RX_DIRECTIVE_TRANSACTIONS);
+   CHECK(failedAcks == 0);
+   CHECK(Host_countTransactions(ALEXA_STREAM) == SAMPLE_RX_DIRECTIVE_TRANSACTIONS);
+}
+
+static void testReusedTransactionIdRestarts(void)
+{
+   size_t acks;
+
+   // A new initial fragment with the id of a transaction in flight replaces it.
+   frame(&transactions[0], ALEXA_STREAM, 9, discover, discoverSize, 8);
+   Host_resetNotifications();
+   AlexaRxPacket(transactions[0].writes[0], (uint8_t) transactions[0].writeSizes[0]);
+   AlexaRxPacket(transactions[0].writes[1], (uint8_t) transactions[0].writeSizes[1]);
+   sendInterleaved(transactions, 1);
+   Host_parseNotifications(&acks, NULL, NULL, 0);
+   CHECK(acks == 1);
+   CHECK(Host_countTransactions(ALEXA_STREAM) == 1);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   discoverSize = Host_encodeDirective(discover, sizeof(discover), "Alexa.Discovery", "Discover", NULL, 0);
+   CHECK(discoverSize > 0);
+
+   testInterleavedStreams();
+   testLeastRecentlyUsedIsEvicted();
+   testReusedTransactionIdRestarts();
+   return Host_finish("test_rx_interleave");
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Multi-fragment transactions are reassembled without touching the heap, and
+// a transaction too large for its stream is refused without losing the
+// packets that share its write.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+static uint8_t writes[64][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[64];
+
+static void testReassemblyDoesNotAllocate(void)
+{
+   uint8_t command[32];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_INFORMATION);
+   size_t acks;
+
+   CHECK(commandSize > 1);
+   for(transaction_id_t id = 0; id < 32; id++) {
+      Host_resetNotifications();
+      Host_resetAllocations();
+      CHECK(Host_writeTransaction(CONTROL_STREAM, id & TRANSACTION_ID_MASK,
+                                  command, commandSize, 1) > 1);
+      CHECK(Host_allocations == 0);
+      CHECK(Host_parseNotifications(&acks, NULL, NULL, 0) > 0);
+      CHECK(acks == 1);
+   }
+}
+
+static void testOversizedTransactionIsSkipped(void)
+{
+   static uint8_t oversized[SAMPLE_MAX_CONTROL_TRANSACTION_SIZE + 64];
+   uint8_t command[32];
+   uint8_t write[SAMPLE_MAX_ATT_MTU];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_FEATURES);
+   size_t fragments = Host_frameTransaction(writes, writeSizes, ARRAY_SIZE(writes),
+                                            CONTROL_STREAM, 3, true,
+                                            oversized, sizeof(oversized), 100);
+   size_t commandWrites[1];
+   uint8_t commandWrite[1][SAMPLE_MAX_ATT_MTU];
+   size_t acks;
+   size_t failedAcks;
+
+   CHECK(fragments == 4);
+   CHECK(Host_frameTransaction(commandWrite, commandWrites, 1, CONTROL_STREAM, 4, true,
+                               command, commandSize, SAMPLE_MAX_ATT_MTU) == 1);
+
+   // The initial fragment of the oversized transaction and a whole command
+   // arrive in one write: the command must still be answered.
+   memcpy(write, writes[0], writeSizes[0]);
+   memcpy(&write[writeSizes[0]], commandWrite[0], commandWrites[0]);
+   Host_resetNotifications();
+   AlexaRxPacket(write, (uint8_t) (writeSizes[0] + commandWrites[0]));
+   CHECK(Host_parseNotifications(&acks, &failedAcks, NULL, 0) > 0);
+   CHECK(acks == 2);
+   CHECK(failedAcks == 1);
+
+   // The rest of the oversized transaction is consumed without further ACKs,
+   // each fragment again followed by a command in the same write.
+   for(size_t i = 1; i < fragments; i++) {
+      memcpy(write, writes[i], writeSizes[i]);
+      memcpy(&write[writeSizes[i]], commandWrite[0], commandWrites[0]);
+      Host_resetNotifications();
+      AlexaRxPacket(write, (uint8_t) (writeSizes[i] + commandWrites[0]));
+      CHECK(Host_parseNotifications(&acks, &failedAcks, NULL, 0) > 0);
+      CHECK(acks == 1);
+      CHECK(failedAcks == 0);
+   }
+}
+
+static void testInvalidStream(void)
+{
+   CHECK(streamToIndex(CONTROL_STREAM) != STREAM_INDEX_INVALID);
+   CHECK(streamToIndex(ALEXA_STREAM) != STREAM_INDEX_INVALID);
+   CHECK(streamToIndex(OTA_STREAM) != STREAM_INDEX_INVALID);
+   CHECK(streamToIndex((stream_id_t) 5) == STREAM_INDEX_INVALID);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   testReassemblyDoesNotAllocate();
+   testOversizedTransactionIsSkipped();
+   testInvalidStream();
+   return Host_finish("test_rx_reassembly");
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// A transaction carried whole by one write is handled straight from the write
+// buffer: it needs no reassembly slot and no heap.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+
+static uint8_t writes[8][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[8];
+
+static void testSingleFragmentNeedsNoSlot(void)
+{
+   uint8_t command[32];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_INFORMATION);
+   static uint8_t pending[SAMPLE_RX_BUFFERED_TRANSACTIONS][2][SAMPLE_MAX_ATT_MTU];
+   static size_t pendingSizes[SAMPLE_RX_BUFFERED_TRANSACTIONS][2];
+   size_t acks;
+
+   // Occupy every buffered slot with a transaction that is half received.
+   for(transaction_id_t id = 0; id < SAMPLE_RX_BUFFERED_TRANSACTIONS; id++) {
+      CHECK(Host_frameTransaction(pending[id], pendingSizes[id], 2, CONTROL_STREAM, id, true,
+                                  command, commandSize, 1) == 2);
+      AlexaRxPacket(pending[id][0], (uint8_t) pendingSizes[id][0]);
+   }
+
+   // Whole commands are answered while the slots are busy, without allocating.
+   for(transaction_id_t id = 8; id < 16; id++) {
+      Host_resetNotifications();
+      Host_resetAllocations();
+      CHECK(Host_writeTransaction(CONTROL_STREAM, id, command, commandSize,
+                                  SAMPLE_MAX_ATT_MTU) == 1);
+      CHECK(Host_allocations == 0);
+      CHECK(Host_parseNotifications(&acks, NULL, NULL, 0) > 0);
+      CHECK(acks == 1);
+   }
+
+   // None of the transactions in the slots was evicted to make room.
+   for(transaction_id_t id = 0; id < SAMPLE_RX_BUFFERED_TRANSACTIONS; id++) {
+      Host_resetNotifications();
+      AlexaRxPacket(pending[id][1], (uint8_t) pendingSizes[id][1]);
+      CHECK(Host_parseNotifications(&acks, NULL, NULL, 0) > 0);
+      CHECK(acks == 1);
+   }
+}
+
+static void testSeveralTransactionsInOneWrite(void)
+{
+   uint8_t command[32];
+   uint8_t write[SAMPLE_MAX_ATT_MTU];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_FEATURES);
+   size_t size = 0;
+   size_t acks;
+
+   for(transaction_id_t id = 0; id < 3; id++) {
+      CHECK(Host_frameTransaction(writes, writeSizes, 1, CONTROL_STREAM, id, true,
+                                  command, commandSize, SAMPLE_MAX_ATT_MTU) == 1);
+      memcpy(&write[size], writes[0], writeSizes[0]);
+      size += writeSizes[0];
+   }
+   Host_resetNotifications();
+   Host_resetAllocations();
+   AlexaRxPacket(write, (uint8_t) size);
+   CHECK(Host_allocations == 0);
+   CHECK(Host_parseNotifications(&acks, NULL, NULL, 0) > 0);
+   CHECK(acks == 3);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   testSingleFragmentNeedsNoSlot();
+   testSeveralTransactionsInOneWrite();
+   return Host_finish("test_single_fragment");
+}
@@ -0,0 +1,146 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Responses are encoded straight into TX fragments. The INITIAL fragment's
+// total length is filled in once the encoder finishes, so the fragments must
+// add up to exactly what pb_encode() produces into a flat buffer, at every
+// MTU and without touching the heap.
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "accessories.pb.h"
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "tx.h"
+
+typedef struct {
+   char const *name;
+   bool (*create)(void);
+   Command command;           // control responses
+   char const *marker;        // text found in events, NULL for control responses
+} response_t;
+
+static bool createErrorResponse(void)
+{
+   return createResponseError(Command_UPDATE_COMPONENT_SEGMENT, ErrorCode_UNSUPPORTED, 0);
+}
+
+static bool createSensorData(void)
+{
+   SendSensorData(72, 40);
+   return true;
+}
+
+static response_t const responses[] = {
+   { "GET_DEVICE_INFORMATION", createResponseGetDeviceInformation, Command_GET_DEVICE_INFORMATION, NULL },
+   { "GET_DEVICE_FEATURES", createResponseGetDeviceFeatures, Command_GET_DEVICE_FEATURES, NULL },
+   { "UPDATE_COMPONENT_SEGMENT", createResponseUpdateComponentSegment, Command_UPDATE_COMPONENT_SEGMENT, NULL },
+   { "APPLY_FIRMWARE", createResponseApplyFirmware, Command_APPLY_FIRMWARE, NULL },
+   { "error", createErrorResponse, Command_UPDATE_COMPONENT_SEGMENT, NULL },
+   { "Discover.Response", CreateDiscoveryResponse, 0, "Alexa.Gadget.MusicData" },
+   { "GetDataReport", createSensorData, 0, "{\"temperature\": 72, \"RH\": 40}" },
+};
+
+static uint8_t encoded[ARRAY_SIZE(responses)][1024];
+static size_t encodedSize[ARRAY_SIZE(responses)];
+
+static size_t frameResponse(response_t const *response, uint8_t *payload, size_t payloadCapacity)
+{
+   Host_resetNotifications();
+   Host_resetAllocations();
+   CHECK(response->create());
+   AlexaTxPump();
+   CHECK(Host_allocations == 0);
+   CHECK(AlexaTxQueueDepth() == 0);
+   return Host_parseNotifications(NULL, NULL, payload, payloadCapacity);
+}
+
+static void checkResponse(response_t const *response, uint8_t const *payload, size_t payloadSize)
+{
+   if(!CHECK(payloadSize > 0)) return;
+   if(response->marker == NULL) {
+      ControlEnvelope envelope = ControlEnvelope_init_default;
+      pb_istream_t stream = pb_istream_from_buffer(payload, payloadSize);
+      CHECK(pb_decode(&stream, ControlEnvelope_fields, &envelope));
+      CHECK(envelope.command == response->command);
+      CHECK(envelope.which_payload == ControlEnvelope_response_tag);
+      CHECK(Host_countTransactions(CONTROL_STREAM) == 1);
+   }
+   else {
+      CHECK(memmem(payload, payloadSize, response->marker, strlen(response->marker)) != NULL);
+      CHECK(Host_countTransactions(ALEXA_STREAM) == 1);
+   }
+}
+
+// The first pass runs before the response cache is filled, so every response
+// is encoded into the fragments as the encoder produces it.
+static void testEncodedAtEveryMtu(void)
+{
+   static uint8_t payload[1024];
+
+   for(size_t r = 0; r < ARRAY_SIZE(responses); r++) {
+      AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+      encodedSize[r] = frameResponse(&responses[r], encoded[r], sizeof(encoded[r]));
+      checkResponse(&responses[r], encoded[r], encodedSize[r]);
+
+      for(uint16_t mtu = SAMPLE_DEFAULT_ATT_MTU; mtu < SAMPLE_MAX_ATT_MTU; mtu += 7) {
+         AlexaSetAttMtu(mtu);
+         size_t payloadSize = frameResponse(&responses[r], payload, sizeof(payload));
+         CHECK(payloadSize == encodedSize[r]);
+         CHECK(memcmp(payload, encoded[r], encodedSize[r]) == 0);
+      }
+   }
+}
+
+// Cached responses carry the same bytes as the ones encoded on the spot.
+static void testCachedMatchesEncoded(void)
+{
+   static uint8_t payload[1024];
+
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_DEFAULT_ATT_MTU);
+   for(size_t r = 0; r < ARRAY_SIZE(responses); r++) {
+      size_t payloadSize = frameResponse(&responses[r], payload, sizeof(payload));
+      CHECK(payloadSize == encodedSize[r]);
+      CHECK(memcmp(payload, encoded[r], encodedSize[r]) == 0);
+   }
+}
+
+// A control envelope encoded through pb_encode() into a flat buffer matches
+// the fragments byte for byte.
+static void testMatchesFlatEncode(void)
+{
+   static uint8_t flat[ControlEnvelope_size];
+   ControlEnvelope envelope = ControlEnvelope_init_default;
+   envelope.command = Command_APPLY_FIRMWARE;
+   envelope.which_payload = ControlEnvelope_response_tag;
+   envelope.payload.response.error_code = ErrorCode_SUCCESS;
+   pb_ostream_t stream = pb_ostream_from_buffer(flat, sizeof(flat));
+
+   CHECK(pb_encode(&stream, ControlEnvelope_fields, &envelope));
+   CHECK(stream.bytes_written == encodedSize[3]);
+   CHECK(memcmp(flat, encoded[3], stream.bytes_written) == 0);
+}
+
+int main(void)
+{
+   testEncodedAtEveryMtu();
+   testMatchesFlatEncode();
+   testCachedMatchesEncoded();
+   return Host_finish("test_tx_encode");
+}
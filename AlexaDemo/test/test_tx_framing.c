@@ -0,0 +1,92 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// Responses are framed in place in the TX ring. The packet list API frames
+// through the same sink into pool blocks, and sendPacketList() moves those
+// frames into the ring, so both deliver the same notifications.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "packet_pool.h"
+#include "tx.h"
+
+static uint8_t ringNotifications[HOST_MAX_NOTIFICATIONS][SAMPLE_MAX_ATT_MTU];
+static uint8_t ringNotificationLengths[HOST_MAX_NOTIFICATIONS];
+
+static void testListMatchesRing(uint16_t mtu, bool (*createResponse)(void))
+{
+   static uint8_t payload[1024];
+   size_t payloadSize;
+   size_t ringCount;
+
+   AlexaSetAttMtu(mtu);
+   Host_resetNotifications();
+   Host_resetAllocations();
+   CHECK(createResponse());
+   AlexaTxPump();
+   payloadSize = Host_parseNotifications(NULL, NULL, payload, sizeof(payload));
+   CHECK(payloadSize > 0);
+   ringCount = Host_notificationCount;
+   memcpy(ringNotifications, Host_notifications, sizeof(ringNotifications));
+   memcpy(ringNotificationLengths, Host_notificationLengths, sizeof(ringNotificationLengths));
+
+   Host_resetNotifications();
+   packet_list_t *list = buildStreamPacket((stream_id_t) ((ringNotifications[0][0] >> STREAM_ID_SHIFT) & STREAM_ID_MASK),
+                                           false, payload, payloadSize);
+   if(!CHECK(list != NULL)) return;
+   CHECK(sendPacketList(list) == (int) ringCount);
+   CHECK(Host_notificationCount == ringCount);
+   CHECK(Host_allocations == 0);
+   for(packet_pool_t pool = 0; pool < PACKET_POOL_COUNT; pool++) {
+      CHECK(PacketPool_getInUse(pool) == 0);
+   }
+
+   // Only the transaction id differs.
+   for(size_t n = 0; n < ringCount && n < Host_notificationCount; n++) {
+      CHECK(Host_notificationLengths[n] == ringNotificationLengths[n]);
+      CHECK((Host_notifications[n][0] & ~TRANSACTION_ID_MASK) == (ringNotifications[n][0] & ~TRANSACTION_ID_MASK));
+      CHECK(memcmp(&Host_notifications[n][1], &ringNotifications[n][1], ringNotificationLengths[n] - 1) == 0);
+   }
+}
+
+static void testAckPacket(void)
+{
+   packet_t ack = createControlAckPacket(CONTROL_STREAM, 5, true, CONTROL_PACKET_RESULT_SUCCESS);
+   size_t acks;
+   size_t failedAcks;
+
+   if(!CHECK(ack.data != NULL)) return;
+   CHECK(ack.dataSize == CONTROL_PACKET_LENGTH);
+   Host_resetNotifications();
+   CHECK(sendPacketList(PacketList_addToTail(NULL, &ack)) == 1);
+   Host_parseNotifications(&acks, &failedAcks, NULL, 0);
+   CHECK(acks == 1);
+   CHECK(failedAcks == 0);
+   CHECK(Host_notifications[0][0] == ((CONTROL_STREAM << STREAM_ID_SHIFT) | 5));
+}
+
+int main(void)
+{
+   AlexaRefreshResponseCache();
+
+   testListMatchesRing(SAMPLE_MAX_ATT_MTU, CreateDiscoveryResponse);
+   testListMatchesRing(128, CreateDiscoveryResponse);
+   testListMatchesRing(SAMPLE_MAX_ATT_MTU, createResponseGetDeviceInformation);
+   testListMatchesRing(SAMPLE_DEFAULT_ATT_MTU, createResponseGetDeviceFeatures);
+   testAckPacket();
+   return Host_finish("test_tx_framing");
+}
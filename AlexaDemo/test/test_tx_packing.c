@@ -0,0 +1,101 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// ACKs and small responses queued while handling one write leave in as few
+// notifications as the negotiated MTU allows, and no notification is larger
+// than a fragment.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+static uint8_t writes[4][SAMPLE_MAX_ATT_MTU];
+static size_t writeSizes[4];
+
+static void checkNotificationSizes(void)
+{
+   for(size_t n = 0; n < Host_notificationCount; n++) {
+      CHECK(Host_notificationLengths[n] <= getFragmentSize());
+   }
+}
+
+static void testAckSharesNotificationWithResponse(void)
+{
+   uint8_t command[32];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_FEATURES);
+   size_t acks;
+
+   Host_resetNotifications();
+   Host_writeTransaction(CONTROL_STREAM, 1, command, commandSize, SAMPLE_MAX_ATT_MTU);
+   CHECK(Host_notificationCount == 1);
+   CHECK(Host_parseNotifications(&acks, NULL, NULL, 0) > 0);
+   CHECK(acks == 1);
+   checkNotificationSizes();
+}
+
+static void testTransactionsInOneWriteArePacked(void)
+{
+   uint8_t command[32];
+   uint8_t write[SAMPLE_MAX_ATT_MTU];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_FEATURES);
+   size_t size = 0;
+   size_t acks;
+
+   for(transaction_id_t id = 0; id < 4; id++) {
+      Host_frameTransaction(writes, writeSizes, 1, CONTROL_STREAM, id, true,
+                            command, commandSize, SAMPLE_MAX_ATT_MTU);
+      memcpy(&write[size], writes[0], writeSizes[0]);
+      size += writeSizes[0];
+   }
+   Host_resetNotifications();
+   AlexaRxPacket(write, (uint8_t) size);
+   Host_parseNotifications(&acks, NULL, NULL, 0);
+   CHECK(acks == 4);
+   CHECK(Host_countTransactions(CONTROL_STREAM) == 4);
+   // Four ACKs and four responses need eight notifications when sent alone.
+   CHECK(Host_notificationCount < 4);
+   checkNotificationSizes();
+}
+
+static void testSmallMtuSplitsPackets(void)
+{
+   uint8_t command[32];
+   size_t commandSize = Host_encodeCommand(command, sizeof(command), Command_GET_DEVICE_INFORMATION);
+   uint8_t response[256];
+   size_t acks;
+
+   AlexaSetAttMtu(SAMPLE_DEFAULT_ATT_MTU);
+   Host_resetNotifications();
+   Host_writeTransaction(CONTROL_STREAM, 2, command, commandSize, SAMPLE_MAX_ATT_MTU);
+   CHECK(Host_notificationCount > 1);
+   CHECK(Host_parseNotifications(&acks, NULL, response, sizeof(response)) > 0);
+   CHECK(acks == 1);
+   checkNotificationSizes();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+
+   testAckSharesNotificationWithResponse();
+   testTransactionsInOneWriteArePacked();
+   testSmallMtuSplitsPackets();
+   return Host_finish("test_tx_packing");
+}
@@ -0,0 +1,132 @@
+/******************************************************************************
+* (C) Copyright 2020 Darwin Tech, LLC, http://www.darwintechnologiesllc.com
+*******************************************************************************
+* This file is licensed under the Darwin Tech Embedded Software License Agreement.
+* See the file "Darwin Tech - Embedded Software License Agreement.pdf" for
+* details. Read the terms of that agreement carefully.
+*
+* Using or distributing any product utilizing this software for any purpose
+* constitutes acceptance of the terms of that agreement.
+******************************************************************************/
+
+// When the stack has no buffers for a notification it is kept and resent by
+// the next AlexaTxPump(), so a response survives any number of refusals
+// without losing, reordering or duplicating frames.
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alexa.h"
+#include "helpers.h"
+#include "host.h"
+#include "tx.h"
+
+#define MAX_PUMPS (1000U)
+
+static uint8_t discover[128];
+static size_t discoverSize;
+
+static bool checkDiscoveryResponse(void)
+{
+   static uint8_t payload[1024];
+   size_t acks;
+   size_t failedAcks;
+   size_t payloadSize = Host_parseNotifications(&acks, &failedAcks, payload, sizeof(payload));
+   bool fits = true;
+
+   for(size_t n = 0; n < Host_notificationCount; n++) {
+      fits = fits && Host_notificationLengths[n] <= getFragmentSize();
+   }
+   return CHECK(fits) &&
+          CHECK(acks == 1) &&
+          CHECK(failedAcks == 0) &&
+          CHECK(Host_countTransactions(ALEXA_STREAM) == 1) &&
+          CHECK(payloadSize > 0) &&
+          CHECK(memmem(payload, payloadSize, "Alexa.Gadget.MusicData", 22) != NULL);
+}
+
+static void testOutOfBuffers(void)
+{
+   uint32_t retries = gTxRetries;
+   uint32_t dropped = gTxDroppedFrames;
+
+   Host_resetNotifications();
+   Host_setNotificationsFail(true);
+   Host_writeTransaction(ALEXA_STREAM, 1, discover, discoverSize, getFragmentSize() - 7);
+   CHECK(Host_notificationCount == 0);
+   CHECK(AlexaTxQueueDepth() > 0);
+   CHECK(gTxRetries > retries);
+   CHECK(AlexaTxPump() == 0);
+
+   Host_setNotificationsFail(false);
+   CHECK(AlexaTxPump() > 0);
+   CHECK(AlexaTxQueueDepth() == 0);
+   CHECK(gTxDroppedFrames == dropped);
+   checkDiscoveryResponse();
+}
+
+// Every other notification is refused.
+static void testIntermittentRefusal(void)
+{
+   uint32_t dropped = gTxDroppedFrames;
+   size_t pumps = 0;
+
+   Host_resetNotifications();
+   Host_setNotificationsFail(true);
+   Host_writeTransaction(ALEXA_STREAM, 2, discover, discoverSize, getFragmentSize() - 7);
+   while(AlexaTxQueueDepth() > 0 && pumps < MAX_PUMPS) {
+      Host_setNotificationsFail(pumps % 2 == 0);
+      AlexaTxPump();
+      pumps++;
+   }
+   Host_setNotificationsFail(false);
+   CHECK(AlexaTxQueueDepth() == 0);
+   CHECK(gTxDroppedFrames == dropped);
+   checkDiscoveryResponse();
+}
+
+static void testEmptyRing(void)
+{
+   Host_resetNotifications();
+   CHECK(AlexaTxQueueDepth() == 0);
+   CHECK(AlexaTxPump() == 0);
+   CHECK(Host_notificationCount == 0);
+}
+
+static void testFlushDropsQueued(void)
+{
+   uint32_t dropped = gTxDroppedFrames;
+
+   Host_resetNotifications();
+   Host_setNotificationsFail(true);
+   Host_writeTransaction(ALEXA_STREAM, 3, discover, discoverSize, getFragmentSize() - 7);
+   size_t depth = AlexaTxQueueDepth();
+   CHECK(depth > 0);
+   AlexaTxFlush();
+   Host_setNotificationsFail(false);
+   CHECK(AlexaTxQueueDepth() == 0);
+   CHECK(gTxDroppedFrames == dropped + depth);
+   CHECK(AlexaTxPump() == 0);
+   CHECK(Host_notificationCount == 0);
+}
+
+int main(void)
+{
+   AlexaRxInit();
+   AlexaRefreshResponseCache();
+   discoverSize = Host_encodeDirective(discover, sizeof(discover), "Alexa.Discovery", "Discover", NULL, 0);
+   CHECK(discoverSize > 0);
+
+   AlexaSetAttMtu(SAMPLE_DEFAULT_ATT_MTU);
+   testOutOfBuffers();
+   testIntermittentRefusal();
+   testEmptyRing();
+   testFlushDropsQueued();
+   AlexaSetAttMtu(SAMPLE_MAX_ATT_MTU);
+   testOutOfBuffers();
+   testIntermittentRefusal();
+   return Host_finish("test_tx_retry");
+}